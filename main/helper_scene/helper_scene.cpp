@@ -1,6 +1,8 @@
 #include "helper_scene.hpp"
 #include <GLFW/glfw3.h>
 
+#include <chrono>
+
 
 using namespace vcl;
 
@@ -32,6 +34,9 @@ void initialize_interface(gui_structure& gui)
     vcl::glad_init();
     std::cout<<"\t [OK] GLAD Initialized"<<std::endl;
 
+    // Linked programs are cached on disk when the driver supports program binaries
+    shader_cache_init([](const char* name) { return reinterpret_cast<void*>(glfwGetProcAddress(name)); });
+
     std::cout<<"*** OPENGL Information ***"<<std::endl;
     std::cout<<"======================================================="<<std::endl;
     vcl::opengl_debug_print_version();
@@ -43,11 +48,66 @@ void initialize_interface(gui_structure& gui)
     std::cout<<"\t [OK] imgui Initialized"<<std::endl;
 }
 
+bool initialize_headless(gui_structure& gui, int width, int height)
+{
+    std::cout<<"*** Create headless OpenGL context (EGL) ***"<<std::endl;
+    if( !vcl::egl_headless_init(3, 3) )
+        return false;
+    gui.window = nullptr;
+    gui.window_title = "Headless";
+    std::cout<<"\t [OK] Headless context created"<<std::endl;
+
+    std::cout<<"*** OPENGL Information ***"<<std::endl;
+    std::cout<<"======================================================="<<std::endl;
+    vcl::opengl_debug_print_version();
+    std::cout<<"======================================================="<<std::endl;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    shader_cache_init(vcl::egl_get_proc_address);
+    imgui_init_headless(width, height);
+    return true;
+}
+
+/** Variants of the mesh and sphere impostor shaders writing the depth of depth_mode */
+static void load_shader_variants(std::map<std::string,GLuint>& shaders, depth_buffer_mode depth_mode)
+{
+    // Only the logarithmic depth is written by the fragment shaders: with the standard depth, the early depth test is kept
+    const unsigned int depth_features = depth_mode==depth_buffer_mode::logarithmic ? shader_log_depth : 0u;
+
+    const std::string mesh_vert = "scenes/shared_assets/shaders/mesh/shader.vert.glsl";
+    const std::string mesh_frag = "scenes/shared_assets/shaders/mesh/shader.frag.glsl";
+    const unsigned int mesh_features = shader_textured | shader_vertex_color | depth_features;
+    shaders["mesh"] = shader_variant(mesh_vert, mesh_frag, mesh_features);
+    shaders["mesh_unlit"] = shader_variant(mesh_vert, mesh_frag, mesh_features | shader_unlit);
+    // The instanced bodies have no specular term (see solarsystem): the shading is reduced to the diffuse term
+    shaders["mesh_instanced"] = shader_variant(mesh_vert, mesh_frag, mesh_features | shader_instanced | shader_virtual_texture | shader_no_specular);
+    shaders["mesh_oit"] = shader_variant(mesh_vert, mesh_frag, mesh_features | shader_weighted_blended);
+    shaders["mesh_oit_unlit"] = shader_variant(mesh_vert, mesh_frag, mesh_features | shader_weighted_blended | shader_unlit);
+    shaders["virtual_texture_feedback"] = shader_variant(mesh_vert, "scenes/shared_assets/shaders/virtual_texture_feedback/shader.frag.glsl", shader_instanced | shader_virtual_texture | shader_no_specular | depth_features);
+    shaders["sphere_impostor"] = shader_variant("scenes/shared_assets/shaders/sphere_impostor/shader.vert.glsl", "scenes/shared_assets/shaders/sphere_impostor/shader.frag.glsl", shader_no_specular | depth_features);
+
+    // The samplers of the virtual textures have their own texture units (see virtual_texture_system::bind)
+    glUseProgram(shaders["mesh_instanced"]);
+    uniform(shaders["mesh_instanced"], "page_table", 1);
+    uniform(shaders["mesh_instanced"], "tile_atlas", 2);
+    glUseProgram(0);
+}
+
+void update_shader_variants(std::map<std::string,GLuint>& shaders, scene_structure& scene)
+{
+    load_shader_variants(shaders, scene.camera.perspective.depth_mode);
+    scene.frame_camera.shader = shaders.at("mesh");
+    scene.frame_worldspace.shader = shaders.at("mesh");
+}
+
 void load_shaders(std::map<std::string,GLuint>& shaders)
 {
     std::cout<<"*** Setup Shader ***"<<std::endl;
+    const auto start = std::chrono::steady_clock::now();
 
-    shaders["mesh"] = create_shader_program("scenes/shared_assets/shaders/mesh/shader.vert.glsl","scenes/shared_assets/shaders/mesh/shader.frag.glsl");
+    load_shader_variants(shaders, depth_buffer_mode::standard);
+    shaders["oit_composite"] = create_shader_program("scenes/shared_assets/shaders/oit_composite/shader.vert.glsl","scenes/shared_assets/shaders/oit_composite/shader.frag.glsl");
+    shaders["skybox"] = create_shader_program("scenes/shared_assets/shaders/skybox/shader.vert.glsl","scenes/shared_assets/shaders/skybox/shader.frag.glsl");
     shaders["mesh_bf"] = create_shader_program("scenes/shared_assets/shaders/mesh_back_illumination/mesh.vert.glsl","scenes/shared_assets/shaders/mesh_back_illumination/mesh.frag.glsl");
     shaders["wireframe"] = create_shader_program("scenes/shared_assets/shaders/wireframe/shader.vert.glsl","scenes/shared_assets/shaders/wireframe/shader.geom.glsl","scenes/shared_assets/shaders/wireframe/shader.frag.glsl");
     shaders["wireframe_quads"] = create_shader_program("scenes/shared_assets/shaders/wireframe_quads/shader.vert.glsl","scenes/shared_assets/shaders/wireframe_quads/shader.geom.glsl","scenes/shared_assets/shaders/wireframe_quads/shader.frag.glsl");
@@ -55,10 +115,11 @@ void load_shaders(std::map<std::string,GLuint>& shaders)
     shaders["segment_im"] = create_shader_program("scenes/shared_assets/shaders/segment_immediate_mode/shader.vert.glsl","scenes/shared_assets/shaders/segment_immediate_mode/shader.frag.glsl");
     shaders["normals"] = create_shader_program("scenes/shared_assets/shaders/normals/shader.vert.glsl","scenes/shared_assets/shaders/normals/shader.geom.glsl","scenes/shared_assets/shaders/normals/shader.frag.glsl");
 
-    std::cout<<"\t [OK] Shader loaded"<<std::endl;
+    const float elapsed_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-start).count();
+    std::cout<<"\t [OK] Shader loaded in "<<elapsed_ms<<" ms ("<<shader_cache_stats().loaded<<" from cache, "<<shader_cache_stats().compiled<<" compiled"<<(shader_cache_enabled() ? "" : ", no program binary support")<<")"<<std::endl;
 }
 
-void setup_scene(scene_structure &scene, gui_structure& gui, const std::map<std::string,GLuint>& shaders)
+void setup_scene(scene_structure &scene, gui_structure& , const std::map<std::string,GLuint>& shaders)
 {
     scene.frame_camera = mesh_drawable(mesh_primitive_frame(0.15f, 0.05f, 0.15f, 0.3f));
     scene.frame_camera.uniform.transform.scaling = 0.2f;
@@ -67,9 +128,10 @@ void setup_scene(scene_structure &scene, gui_structure& gui, const std::map<std:
     scene.frame_worldspace = mesh_drawable(mesh_primitive_frame(0.05f, 0.015f, 0.05f, 0.1f));
     scene.frame_worldspace.shader = shaders.at("mesh");
 
-    int width=0, height=0;
-    glfwGetWindowSize(gui.window, &width, &height);
-    const float aspect_ratio = width/static_cast<float>(height);
+    // Size of the window, or of the offscreen image in headless mode
+    GLint viewport[4] = {0,0,0,0};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    const float aspect_ratio = viewport[2]/static_cast<float>(viewport[3]);
 
     scene.camera.perspective = perspective_structure( 40*3.14f/180, aspect_ratio, 0.01f, 1500.0f);
 
@@ -103,7 +165,8 @@ void gui_start_basic_structure(gui_structure& gui, scene_structure& scene)
 
     ImGui::Text("Frame: "); ImGui::SameLine();
     ImGui::Checkbox("Camera", &gui.show_frame_camera); ImGui::SameLine();
-    ImGui::Checkbox("Worldspace", &gui.show_frame_worldspace);
+    ImGui::Checkbox("Worldspace", &gui.show_frame_worldspace); ImGui::SameLine();
+    ImGui::Checkbox("Capture", &gui.capture);
     ImGui::Spacing();
 
     if(gui.show_frame_camera)
@@ -115,3 +178,13 @@ void gui_start_basic_structure(gui_structure& gui, scene_structure& scene)
         draw(scene.frame_worldspace, scene.camera);
 
 }
+
+void update_frame_capture(gui_structure& gui)
+{
+    if(gui.capture && !gui.capture_frames.running())
+        gui.capture_frames.start(gui.capture_prefix, gui.capture_format);
+    else if(!gui.capture && gui.capture_frames.running())
+        gui.capture_frames.stop();
+
+    gui.capture_frames.capture();
+}
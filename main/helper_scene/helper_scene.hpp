@@ -19,13 +19,25 @@ struct gui_structure
 
     bool show_frame_camera     = true;
     bool show_frame_worldspace = false;
+
+    // Capture of the frames to an image sequence
+    bool capture = false;
+    std::string capture_prefix = "capture_";
+    vcl::frame_capture_format capture_format = vcl::frame_capture_format::png;
+    vcl::frame_capture capture_frames;
 };
 
 
 GLFWwindow* create_window(const std::string& window_title);
 void initialize_interface(gui_structure& gui);
+/** Offscreen rendering without window (gui.window is null): the caller draws in an offscreen_framebuffer of the given size */
+bool initialize_headless(gui_structure& gui, int width, int height);
 void load_shaders(std::map<std::string,GLuint>& shaders);
 void setup_scene(scene_structure &scene, gui_structure& gui, const std::map<std::string,GLuint>& shaders);
+/** Select the mesh and sphere impostor shaders writing the depth of scene.camera (see depth_buffer_mode), to be called after changing its depth_mode */
+void update_shader_variants(std::map<std::string,GLuint>& shaders, scene_structure& scene);
 void clear_screen();
 void update_fps_title(GLFWwindow* window, const std::string& title, vcl::glfw_fps_counter& fps_counter);
 void gui_start_basic_structure(gui_structure& gui, scene_structure& scene);
+/** Start or stop the capture from the GUI, and capture the current frame */
+void update_frame_capture(gui_structure& gui);
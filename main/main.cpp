@@ -8,6 +8,13 @@
 // Include scene
 #include "scenes/3D_graphics/SolarSystem/solarsystem.hpp"
 
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
 
 
 // ************************************** //
@@ -38,12 +45,44 @@ void mouse_scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void keyboard_input_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 // ************************************** //
-// Start program
+// Headless benchmark (no window)
 // ************************************** //
 
-int main()
+struct program_arguments
 {
+    bool headless = false;
+    int width = 1280;
+    int height = 1000;
+    int frames = 300;
+    int warmup_frames = 10; // not measured (shader and texture uploads of the first frames)
+    std::string capture_prefix; // frames are captured if not empty (see frame_capture)
+    bool capture_raw = false;
+    std::string pack;       // asset pack mounted (see asset_pack), by default assets.pack next to the executable if it exists
+    std::string build_pack; // write an asset pack of the shaders and assets and exit, if not empty
+    std::string cache;      // directory of the caches (see vcl::set_cache_directory), by default the user cache directory once a pack is mounted
+};
+program_arguments parse_arguments(int argc, char** argv);
+void mount_asset_pack(const program_arguments& settings, const char* executable);
+void select_cache_directory(const program_arguments& settings);
+int run_headless(const program_arguments& settings);
+void apply_capture_arguments(const program_arguments& settings);
 
+// ************************************** //
+// Start program
+// ************************************** //
+
+int main(int argc, char** argv)
+{
+    // Usage: pgm [--headless [--frames N] [--size WIDTHxHEIGHT]] [--capture PREFIX [--capture-raw]] [--pack FILE] [--cache DIRECTORY]
+    //       pgm --build-pack FILE (run from the root directory)
+    const program_arguments arguments = parse_arguments(argc, argv);
+    if(!arguments.build_pack.empty())
+        return vcl::asset_pack_build(arguments.build_pack, {"scenes/shared_assets", "scenes/3D_graphics/SolarSystem/assets"}) ? 0 : 1;
+    mount_asset_pack(arguments, argv[0]);
+    select_cache_directory(arguments);
+    apply_capture_arguments(arguments);
+    if(arguments.headless)
+        return run_headless(arguments);
 
     // ************************************** //
     // Initialization and data setup
@@ -92,6 +131,8 @@ int main()
         // Perform computation and draw calls for each iteration loop
         scene_current.frame_draw(shaders, scene, gui); opengl_debug();
 
+        // Capture the scene without the GUI
+        update_frame_capture(gui);
 
         // Render GUI and update window
         ImGui::End();
@@ -106,6 +147,8 @@ int main()
 
     }
     std::cout<<"*** Stop GLFW loop ***"<<std::endl;
+    gui.capture_frames.stop();
+    scene_current.cleanup();
 
     // Cleanup ImGui and GLFW
     vcl::imgui_cleanup();
@@ -116,6 +159,146 @@ int main()
     return 0;
 }
 
+program_arguments parse_arguments(int argc, char** argv)
+{
+    program_arguments settings;
+    for(int k=1; k<argc; ++k)
+    {
+        const std::string argument = argv[k];
+        if(argument=="--headless")
+            settings.headless = true;
+        else if(argument=="--frames" && k+1<argc)
+            settings.frames = std::max(1, std::atoi(argv[++k]));
+        else if(argument=="--size" && k+1<argc)
+            std::sscanf(argv[++k], "%dx%d", &settings.width, &settings.height);
+        else if(argument=="--capture" && k+1<argc)
+            settings.capture_prefix = argv[++k];
+        else if(argument=="--capture-raw")
+            settings.capture_raw = true;
+        else if(argument=="--pack" && k+1<argc)
+            settings.pack = argv[++k];
+        else if(argument=="--build-pack" && k+1<argc)
+            settings.build_pack = argv[++k];
+        else if(argument=="--cache" && k+1<argc)
+            settings.cache = argv[++k];
+        else
+            std::cerr<<"Unknown argument "<<argument<<std::endl;
+    }
+    return settings;
+}
+
+void mount_asset_pack(const program_arguments& settings, const char* executable)
+{
+    if(!settings.pack.empty()) {
+        vcl::asset_pack_mount(settings.pack);
+        return;
+    }
+
+    // Default pack: next to the executable, so that it can run from any directory
+    const std::string path = executable;
+    const size_t separator = path.find_last_of("/\\");
+    const std::string pack = (separator==std::string::npos ? std::string() : path.substr(0, separator+1)) + "assets.pack";
+    if(std::ifstream(pack).is_open())
+        vcl::asset_pack_mount(pack);
+}
+
+void select_cache_directory(const program_arguments& settings)
+{
+    if(!settings.cache.empty()) {
+        vcl::set_cache_directory(settings.cache);
+        return;
+    }
+    // Without pack, the caches stay next to the assets (the program runs from the root directory).
+    // With a pack, the assets directories may not exist nor be writable: the caches missing from the pack go to the user cache directory.
+    if(!vcl::asset_pack_mounted())
+        return;
+    std::string directory;
+    if(const char* xdg = std::getenv("XDG_CACHE_HOME"))
+        directory = xdg;
+    else if(const char* home = std::getenv("HOME"))
+        directory = std::string(home)+"/.cache";
+    else if(const char* local = std::getenv("LOCALAPPDATA"))
+        directory = local;
+    else
+        directory = ".";
+    vcl::set_cache_directory(directory+"/vcl_solarsystem");
+    std::cout<<"Cache directory "<<directory<<"/vcl_solarsystem"<<std::endl;
+}
+
+void apply_capture_arguments(const program_arguments& settings)
+{
+    if(!settings.capture_prefix.empty()) {
+        gui.capture = true;
+        gui.capture_prefix = settings.capture_prefix;
+    }
+    gui.capture_format = settings.capture_raw ? vcl::frame_capture_format::raw : vcl::frame_capture_format::png;
+}
+
+int run_headless(const program_arguments& settings)
+{
+    if( !initialize_headless(gui, settings.width, settings.height) )
+        return 1;
+
+    // The scene is drawn in an offscreen framebuffer in place of the window
+    const vcl::offscreen_framebuffer target(settings.width, settings.height);
+    target.bind();
+
+    load_shaders(shaders);
+    setup_scene(scene, gui, shaders);
+
+    opengl_debug();
+    std::cout<<"*** Setup Data ***"<<std::endl;
+    scene_current.setup_data(shaders, scene, gui);
+    std::cout<<"\t [OK] Data setup"<<std::endl;
+    opengl_debug();
+
+    // Scripted camera: a full turn around the system, zooming in then out
+    vcl::camera_path path;
+    path.keyframes = { {0.0f, 1.2f, 25.0f}, {1.6f, 0.9f, 6.0f}, {3.1f, 0.6f, 2.0f}, {4.7f, 1.0f, 60.0f}, {6.28f, 1.2f, 25.0f} };
+
+    std::cout<<"*** Start headless loop ("<<settings.frames<<" frames, "<<settings.width<<"x"<<settings.height<<") ***"<<std::endl;
+    std::vector<float> frame_ms;
+    const int total_frames = settings.warmup_frames + settings.frames;
+    for(int frame=0; frame<total_frames; ++frame)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        target.bind();
+        clear_screen();
+        glBindTexture(GL_TEXTURE_2D,scene.texture_white);
+
+        gui_start_basic_structure(gui,scene);
+        path.apply(scene.camera, float(frame)/float(total_frames-1));
+        scene_current.frame_draw(shaders, scene, gui);
+        update_frame_capture(gui);
+        ImGui::End();
+        vcl::imgui_render_frame(gui.window);
+
+        // Wait for the GPU: the measure includes the rendering of the frame
+        glFinish();
+        opengl_debug();
+
+        if(frame>=settings.warmup_frames)
+            frame_ms.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-start).count());
+    }
+
+    gui.capture_frames.stop();
+    scene_current.cleanup();
+
+    // Report
+    std::vector<float> sorted = frame_ms;
+    std::sort(sorted.begin(), sorted.end());
+    const float mean = std::accumulate(sorted.begin(), sorted.end(), 0.0f)/float(sorted.size());
+    const auto percentile = [&](float p) { return sorted[std::min(sorted.size()-1, size_t(p*float(sorted.size())))]; };
+    std::cout<<"*** Frame times (ms) ***"<<std::endl;
+    std::cout<<"\t mean "<<mean<<" ("<<1000.0f/mean<<" fps)"<<std::endl;
+    std::cout<<"\t min "<<sorted.front()<<", median "<<percentile(0.5f)<<", p95 "<<percentile(0.95f)<<", max "<<sorted.back()<<std::endl;
+
+    vcl::imgui_cleanup();
+    vcl::egl_headless_cleanup();
+    return 0;
+}
+
 void window_size_callback(GLFWwindow* /*window*/, int width, int height)
 {
     glViewport(0, 0, width, height);
@@ -9,22 +9,48 @@
 // Add vcl namespace within the current one - Allows to use function from vcl library without explicitely preceeding their name with vcl::
 using namespace vcl;
 
+// Dimension of each layer of the texture array shared by the spheres
+const unsigned int sphere_texture_width  = 4096;
+const unsigned int sphere_texture_height = 2048;
+
+// Levels of detail of the spheres, with the minimal radius on screen (in pixels) to use each level
+//  - level 0: ray-traced impostor for the bodies covering only a few pixels
+//  - level k>0: tessellated sphere with (Nu,Nv) = sphere_lod_samples[k-1]
+const size_t sphere_lod_samples[][2] = { {24,48}, {48,96}, {96,192}, {192,384} };
+const float sphere_lod_screen_radius[] = { 0.0f, 24.0f, 64.0f, 256.0f, 768.0f };
+const size_t sphere_lod_levels = sizeof(sphere_lod_screen_radius)/sizeof(float);
 
-mesh create_universe(float dimension);
 star& create_star(float radius, float mass, vcl::vec3 p, vcl::vec3 v);
 planet& create_planet(float radius, float mass, vcl::vec3 p, vcl::vec3 v,  float inclination, vcl::vec3 force, float orbit_radius, float vel_rot);
 mesh create_ring(float r_int, float r_ext);
+mesh_drawable create_sphere();
+mesh_instance sphere_instance(const star& body);
+procedural_texture_parameters procedural_sphere(procedural_texture_type type, const vec3& color_low, const vec3& color_high, unsigned int seed);
+std::string texture_or_procedural(const std::string& filename, const procedural_texture_parameters& parameters);
 
 
 /** This function is called before the beginning of the animation loop
     It is used to initialize all part-specific data */
-void scene_model::setup_data(std::map<std::string,GLuint>& , scene_structure& scene, gui_structure&)
+void scene_model::setup_data(std::map<std::string,GLuint>& shaders, scene_structure& scene, gui_structure&)
 {
     // Setup initial camera mode and position
     scene.camera.camera_type = camera_control_spherical_coordinates;
     scene.camera.scale = 25.0f;
     scene.camera.apply_rotation(0,0,0,1.2f);
 
+    // Logarithmic depth: the near plane can be close to the bodies while the far plane contains the whole system
+    scene.camera.perspective.z_near = 1e-6f;
+    scene.camera.perspective.z_far = 1e8f;
+    scene.camera.perspective.depth_mode = depth_buffer_mode::logarithmic;
+    update_shader_variants(shaders, scene);
+
+    // The cubemap is decoded on worker threads while the scene is set up, and sent to the GPU at the end of the setup.
+    // The other textures are streamed from placeholders, at the resolution they are displayed with.
+    texture_loading.reset(new texture_loader());
+    streaming.reset(new texture_streaming());
+    // The rocky planets are also displayed at twice the resolution of the texture array, only their visible tiles being resident
+    virtual_textures.reset(new virtual_texture_system(2*sphere_texture_width, 2*sphere_texture_height));
+
     // Universe creation
     setup_universe();
 
@@ -43,6 +69,22 @@ void scene_model::setup_data(std::map<std::string,GLuint>& , scene_structure& sc
 
     // Moon creation
     setup_moon();
+
+    // Shared geometry and textures of the spheres
+    setup_spheres();
+
+    texture_loading->finish();
+    texture_loading.reset();
+}
+
+/** This function is called after the animation loop, while the OpenGL context still exists.
+    The loading threads are stopped before the exit: they must not outlive the context and the static data they use */
+void scene_model::cleanup()
+{
+    if(streaming)
+        streaming->clear();
+    if(virtual_textures)
+        virtual_textures->clear();
 }
 
 
@@ -53,11 +95,18 @@ void scene_model::frame_draw(std::map<std::string,GLuint>& shaders, scene_struct
     timer.update();
     set_gui(timer);
 
+    // Stream the texture levels required by the previous frame, within a time budget per frame and a memory budget
+    if(streaming) {
+        streaming->memory_budget = size_t(gui_scene.texture_budget)<<20;
+        streaming->update();
+    }
+    // Tiles seen in the feedback of the previous frames
+    if(virtual_textures)
+        virtual_textures->update();
+
     // Simulation time step (dt)
     float dt = timer.scale*0.001f;
 
-    glEnable( GL_POLYGON_OFFSET_FILL ); // avoids z-fighting when displaying wireframe
-
 
     /// *** Data update *** ///
 
@@ -75,6 +124,8 @@ void scene_model::frame_draw(std::map<std::string,GLuint>& shaders, scene_struct
 
     /// *** Follow the star selected on Gui *** ///
 
+    // The camera target becomes the floating origin, unless a star is followed
+    view_origin.recenter(scene.camera);
     camera_position_at_each_star(scene);
 
     /// *************************************** ///
@@ -82,43 +133,41 @@ void scene_model::frame_draw(std::map<std::string,GLuint>& shaders, scene_struct
 
     /// *** Draw the elements *** ///
 
-    // Universe
-    draw_universe(shaders, scene);
-    // Sun
-    draw_sun(shaders, scene);
-    // Planets
-    draw_planets(shaders, scene);
-    // Moon
-    draw_moon(shaders, scene);
-    // Saturn ring
-    draw_saturn_ring(shaders, scene);
-    // Sun ring
-    draw_sun_ring(shaders, scene);
+    // Only positions relative to the camera target are sent to the GPU
+    update_relative_positions(shaders, scene.camera);
 
-    /// ************************* ///
-
-
-    /// *** Wireframe *** ///
+    // Wireframe if asked from the GUI: the edges are drawn by the fragment shaders in the same pass
+    if( gui_scene.wireframe!=spheres_barycentric )
+        setup_sphere_levels(gui_scene.wireframe);
+    for(const char* name : {"mesh", "mesh_unlit", "mesh_oit", "mesh_oit_unlit", "mesh_instanced"}) {
+        glUseProgram(shaders[name]);
+        uniform(shaders[name], "wireframe", int(gui_scene.wireframe));
+    }
 
-    if( gui_scene.wireframe ){ // wireframe if asked from the GUI
-        glPolygonOffset( 1.0, 1.0 );
-        // Universe
-        draw(universe, scene.camera, shaders["wireframe"]);
-        // Sun
-        draw(sun.drawable,scene.camera, shaders["wireframe"]);
-        // Planets
-        for(planet& it : planets){
-            draw(it.drawable, scene.camera, shaders["wireframe"]);
-        }
-        // Moon
-        draw(moon.drawable, scene.camera, shaders["wireframe"]);
-        // Saturn ring
-        draw(saturn_ring.drawable, scene.camera, shaders["wireframe"]);
-        // Sun ring
-        draw(sun_ring, scene.camera, shaders["wireframe"]);
+    // Elements are collected in the render queue, the ones outside of the view are culled,
+    //  and the others are submitted sorted by pass, shader, texture and depth
+    const frustum view_frustum = camera_frustum(scene.camera);
+    fill_render_queue(shaders, scene, view_frustum);
+    queue.cull(view_frustum);
+    queue.sort();
+    if(virtual_textures)
+        virtual_textures->bind(shaders["mesh_instanced"]);
+    queue.submit(scene.camera);
+
+    // Pages of the virtual textures needed by the spheres, drawn again in a small framebuffer
+    if(virtual_textures && gui_scene.virtual_texturing) {
+        GLint viewport[4] = {0,0,0,0};
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        virtual_textures->begin_feedback(shaders["virtual_texture_feedback"], viewport[2], viewport[3]);
+        for(const mesh_drawable_instanced& level : spheres)
+            draw(level, scene.camera, shaders["virtual_texture_feedback"]);
+        virtual_textures->end_feedback();
     }
 
-    /// ***************** ///
+    // Avoids to use the previous texture for another object
+    glBindTexture(GL_TEXTURE_2D, scene.texture_white);
+
+    /// ************************* ///
 }
 
 
@@ -130,8 +179,9 @@ star& create_star(float radius, float mass, vec3 p, vec3 v){
     static star new_star;
     new_star.mass = mass;
     new_star.radius = radius;
-    new_star.p = p;
-    new_star.v = v;
+    new_star.p = to_dvec3(p);
+    new_star.v = to_dvec3(v);
+    new_star.position = new_star.p;
 
     return new_star;
 }
@@ -140,12 +190,13 @@ planet& create_planet(float radius, float mass, vec3 p, vec3 v,  float inclinati
     static planet new_planet;
     new_planet.mass = mass;
     new_planet.radius = radius;
-    new_planet.p = p;
-    new_planet.v = v;
+    new_planet.p = to_dvec3(p);
+    new_planet.v = to_dvec3(v);
+    new_planet.position = new_planet.p;
     new_planet.vel_rot = vel_rot;
 
     new_planet.inclination = inclination;
-    new_planet.force = force;
+    new_planet.force = to_dvec3(force);
     new_planet.orbit_radius = orbit_radius;
     //new_planet.drawable.uniform.transform.rotation = rotation_from_axis_angle_mat3({0,1,0}, inclination);
 
@@ -153,48 +204,28 @@ planet& create_planet(float radius, float mass, vec3 p, vec3 v,  float inclinati
 
 }
 
-mesh create_universe(float dimension){
-    mesh sky;
-    // Geometry
-    float l = dimension/2.0f;
-    mesh base;
-    mesh face1;
-    mesh face2;
-    mesh face3;
-    mesh face4;
-    mesh top;
-
-    base.position = {{-l,-l,-l}, {l,-l,-l}, {l,l,-l}, {-l,l,-l}};
-    base.texture_uv = {{1/4.0f, 2/3.0f}, {2/4.0f, 2/3.0f}, {2/4.0f, 1.0f}, {1/4.0f, 1.0f}};
-    base.connectivity = {{0,1,2}, {0,2,3}};
-
-    face1.position = {{-l,-l,-l}, {l,-l,-l}, {-l,-l,l}, {l,-l,l}};
-    face1.texture_uv = {{1/4.0f, 2/3.0f}, {2/4.0f, 2/3.0f}, {1/4.0f, 1/3.0f}, {2/4.0f, 1/3.0f}};
-    face1.connectivity = {{0,1,2}, {1,2,3}};
-
-    face2.position = {{l,-l,-l}, {l,l,-l}, {l,-l,l}, {l,l,l}};
-    face2.texture_uv = {{2/4.0f, 2/3.0f}, {3/4.0f, 2/3.0f}, {2/4.0f, 1/3.0f}, {3/4.0f, 1/3.0f}};
-    face2.connectivity = {{0,1,2}, {1,2,3}};
-
-    face3.position = {{l,l,-l}, {-l,l,-l}, {l,l,l}, {-l,l,l}};
-    face3.texture_uv = {{3/4.0f, 2/3.0f}, {1.0f, 2/3.0f}, {3/4.0f, 1/3.0f}, {1.0f, 1/3.0f}};
-    face3.connectivity = {{0,1,2}, {1,2,3}};
-
-    face4.position = {{-l,l,-l}, {-l,-l,-l}, {-l,-l,l}, {-l,l,l}};
-    face4.texture_uv = {{0, 2/3.0f}, {1/4.0f, 2/3.0f}, {1/4.0f, 1/3.0f}, {0, 1/3.0f}};
-    face4.connectivity = {{0,1,2}, {0,2,3}};
-
-    top.position = {{-l,-l,l}, {l,-l,l}, {l,l,l}, {-l,l,l}};
-    top.texture_uv = {{1/4.0f, 1/3.0f}, {2/4.0f, 1/3.0f}, {2/4.0f, 0}, {1/4.0f, 0}};
-    top.connectivity = {{0,1,2}, {0,2,3}};
-
-    sky.push_back(base);
-    sky.push_back(face1);
-    sky.push_back(face2);
-    sky.push_back(face3);
-    sky.push_back(face4);
-    sky.push_back(top);
-    return sky;
+mesh_drawable create_sphere()
+{
+    // All spheres share the same unit spheres on the GPU, the radius is set as a scaling at each frame
+    //  The geometry is only used for the bounding sphere: the bodies are drawn by the instanced levels of detail
+    mesh_drawable sphere;
+    sphere.data = mesh_gpu_registry_sphere(sphere_lod_samples[0][0], sphere_lod_samples[0][1]);
+    return sphere;
+}
+
+mesh_instance sphere_instance(const star& body)
+{
+    const mesh_drawable_uniform& u = body.drawable.uniform;
+
+    mesh_instance instance;
+    instance.rotation = u.transform.rotation;
+    instance.translation = u.transform.translation;
+    instance.scaling = u.transform.scaling;
+    instance.shading = {u.shading.ambiant, u.shading.diffuse, u.shading.specular};
+    instance.texture_layer = float(body.texture_layer);
+    instance.occluders = body.shadow_occluders;
+    instance.virtual_texture = float(body.virtual_texture);
+    return instance;
 }
 
 mesh create_ring(float r_int, float r_ext)
@@ -239,38 +270,58 @@ mesh create_ring(float r_int, float r_ext)
 
 void scene_model::setup_universe()
 {
-    universe = create_universe(1100.0f);
-    universe.uniform.shading = {1,0,0};
-    universe.texture_id = create_texture_gpu( image_load_png("scenes/3D_graphics/SolarSystem/assets/universe/8k_stars_milky.png"));
+    // The cross layout image is converted once into the six faces of a cubemap (cached next to the image)
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+    const std::string filename = "scenes/3D_graphics/SolarSystem/assets/universe/8k_stars_milky.png";
+    procedural_texture_parameters stars;
+    stars.type = procedural_texture_type::starfield;
+    stars.layout = procedural_texture_layout::cube_cross;
+    stars.width = 4096;
+    stars.height = 3072;
+    stars.color_low = {0.04f,0.04f,0.08f};
+    stars.color_high = {1.0f,1.0f,1.0f};
+    stars.frequency = 3.0f;
+    stars.seed = 8;
+    texture_or_procedural(filename, stars);
+    texture_loading->request(filename, [filename](){ return image_load_cubemap_cross(procedural_texture_source(filename)); },
+                             [this](std::vector<image_raw>& faces){
+                                 universe = skybox(create_texture_cubemap_gpu(faces));
+                                 universe.sampler = sampler_object(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+                             });
 }
 
 void scene_model::setup_sun()
 {
     // Sun
     sun = create_star(sun_radius, sun_mass, {0,0,0} , {0,0,0});
-    sun.drawable = mesh_primitive_sphere(sun_radius*200, {0,0,0}, 40, 80);
+    sun.drawable = create_sphere();
+    sun.display_scale = 200;
     sun.drawable.uniform.shading = {1,0,0};
-    sun.drawable.texture_id = create_texture_gpu( image_load_png("scenes/3D_graphics/SolarSystem/assets/sun/8k_sun.png"));
-    // Sun ring
+    sun.texture_layer = load_sphere_texture(texture_or_procedural("scenes/3D_graphics/SolarSystem/assets/sun/8k_sun.png",
+                                                                  procedural_sphere(procedural_texture_type::rocky, {0.9f,0.35f,0.05f}, {1.0f,0.85f,0.3f}, 1)));
+    // Sun ring (scaled with the sun)
     mesh sunring;
-    float size = 325.0f;
+    float size = 325.0f/sun.display_scale;
     sunring.position     = {{-sun_radius*size,-sun_radius*size,0}, {sun_radius*size,-sun_radius*size,0}, {sun_radius*size,sun_radius*size,0}, {-sun_radius*size,sun_radius*size,0}};
     sunring.texture_uv   = {{0,1}, {1,1}, {1,0}, {0,0}};
     sunring.connectivity = {{0,1,2}, {0,2,3}};
-    sun_ring = sunring;
+    sun_ring = mesh_drawable(sunring, 0, 0, true);
     sun_ring.uniform.shading = {1,0,0};
     // Load a texture (with transparent background)
-    sun_ring.texture_id = create_texture_gpu( image_load_png("scenes/3D_graphics/SolarSystem/assets/sun/sun_ring.png"), GL_REPEAT, GL_REPEAT );
+    sun_ring.texture_id = streaming->create_texture_gpu("scenes/3D_graphics/SolarSystem/assets/sun/sun_ring.png", {0,0,0,0}, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, texture_compression::automatic);
+    sun_ring.sampler = sampler_object(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE); // clamp to edge avoids sampling artifacts
 }
 
 void scene_model::setup_mercury()
 {
     planet mercury;
     mercury = create_planet(m_radius, m_mass, m_p, m_v, m_inclination, m_force, m_orbitradius, m_vel_rot);
-    mercury.drawable = mesh_primitive_sphere(m_radius*1000, {0,0,0}, 40, 80);
+    mercury.drawable = create_sphere();
+    mercury.display_scale = 1000;
     mercury.drawable.uniform.transform.rotation = rotation_from_axis_angle_mat3({0,1,0}, m_inclination);
     mercury.drawable.uniform.shading.specular = 0.0f;
-    mercury.drawable.texture_id = create_texture_gpu( image_load_png("scenes/3D_graphics/SolarSystem/assets/mercury/8k_mercury.png"));
+    mercury.texture_layer = load_sphere_texture(texture_or_procedural("scenes/3D_graphics/SolarSystem/assets/mercury/8k_mercury.png",
+                                                                      procedural_sphere(procedural_texture_type::rocky, {0.35f,0.33f,0.31f}, {0.65f,0.62f,0.58f}, 2)));
     planets.push_back(mercury);
 }
 
@@ -278,10 +329,14 @@ void scene_model::setup_venus()
 {
     planet venus;
     venus = create_planet(v_radius, v_mass,v_p, v_v, v_inclination, v_force, v_orbitradius, v_vel_rot);
-    venus.drawable = mesh_primitive_sphere(v_radius*1000, {0,0,0}, 40, 80);
+    venus.drawable = create_sphere();
+    venus.display_scale = 1000;
     venus.drawable.uniform.transform.rotation = rotation_from_axis_angle_mat3({0,1,0}, v_inclination);
     venus.drawable.uniform.shading.specular = 0.0f;
-    venus.drawable.texture_id = create_texture_gpu( image_load_png("scenes/3D_graphics/SolarSystem/assets/venus/4k_venus.png"));
+    procedural_texture_parameters clouds = procedural_sphere(procedural_texture_type::gas_giant, {0.8f,0.6f,0.35f}, {0.95f,0.85f,0.6f}, 3);
+    clouds.bands = 6.0f;
+    clouds.turbulence = 0.1f;
+    venus.texture_layer = load_sphere_texture(texture_or_procedural("scenes/3D_graphics/SolarSystem/assets/venus/4k_venus.png", clouds));
     planets.push_back(venus);
 }
 
@@ -289,10 +344,14 @@ void scene_model::setup_earth()
 {
     planet earth;
     earth = create_planet(e_radius, e_mass, e_p, e_v, e_inclination, e_force, e_orbitradius, e_vel_rot);
-    earth.drawable = mesh_primitive_sphere(e_radius*1000, {0,0,0}, 40, 80);
+    earth.drawable = create_sphere();
+    earth.display_scale = 1000;
     earth.drawable.uniform.transform.rotation = rotation_from_axis_angle_mat3({0,1,0}, e_inclination);
     earth.drawable.uniform.shading.specular = 0.0f;
-    earth.drawable.texture_id = create_texture_gpu( image_load_png("scenes/3D_graphics/SolarSystem/assets/earth/8k_earth.png"));
+    const std::string texture = texture_or_procedural("scenes/3D_graphics/SolarSystem/assets/earth/8k_earth.png",
+                                                      procedural_sphere(procedural_texture_type::rocky, {0.05f,0.15f,0.45f}, {0.35f,0.5f,0.2f}, 4));
+    earth.texture_layer = load_sphere_texture(texture);
+    earth.virtual_texture = virtual_textures->add(texture);
     planets.push_back(earth);
 }
 
@@ -300,10 +359,14 @@ void scene_model::setup_mars()
 {
     planet mars;
     mars = create_planet(ma_radius, ma_mass, ma_p, ma_v, ma_inclination, ma_force, ma_orbitradius, ma_vel_rot);
-    mars.drawable = mesh_primitive_sphere(ma_radius*1000, {0,0,0}, 40, 80);
+    mars.drawable = create_sphere();
+    mars.display_scale = 1000;
     mars.drawable.uniform.transform.rotation = rotation_from_axis_angle_mat3({0,1,0}, ma_inclination);
     mars.drawable.uniform.shading.specular = 0.0f;
-    mars.drawable.texture_id = create_texture_gpu( image_load_png("scenes/3D_graphics/SolarSystem/assets/mars/8k_mars.png"));
+    const std::string texture = texture_or_procedural("scenes/3D_graphics/SolarSystem/assets/mars/8k_mars.png",
+                                                      procedural_sphere(procedural_texture_type::rocky, {0.45f,0.18f,0.08f}, {0.8f,0.45f,0.25f}, 5));
+    mars.texture_layer = load_sphere_texture(texture);
+    mars.virtual_texture = virtual_textures->add(texture);
     planets.push_back(mars);
 }
 
@@ -311,10 +374,12 @@ void scene_model::setup_jupiter()
 {
     planet jupiter;
     jupiter = create_planet(j_radius, j_mass, j_p, j_v, j_inclination, j_force, j_orbitradius, j_vel_rot);
-    jupiter.drawable = mesh_primitive_sphere(j_radius*1000, {0,0,0}, 40, 80);
+    jupiter.drawable = create_sphere();
+    jupiter.display_scale = 1000;
     jupiter.drawable.uniform.transform.rotation = rotation_from_axis_angle_mat3({0,1,0}, j_inclination);
     jupiter.drawable.uniform.shading.specular = 0.0f;
-    jupiter.drawable.texture_id = create_texture_gpu( image_load_png("scenes/3D_graphics/SolarSystem/assets/jupiter/8k_jupiter.png"));
+    jupiter.texture_layer = load_sphere_texture(texture_or_procedural("scenes/3D_graphics/SolarSystem/assets/jupiter/8k_jupiter.png",
+                                                                      procedural_sphere(procedural_texture_type::gas_giant, {0.6f,0.45f,0.3f}, {0.95f,0.9f,0.8f}, 6)));
     planets.push_back(jupiter);
 }
 
@@ -322,28 +387,32 @@ void scene_model::setup_saturn()
 {
     planet saturn;
     saturn = create_planet(s_radius, s_mass, s_p, s_v, s_inclination, s_force, s_orbitradius, s_vel_rot);
-    saturn.drawable = mesh_primitive_sphere(s_radius*1000, {0,0,0}, 40, 80);
+    saturn.drawable = create_sphere();
+    saturn.display_scale = 1000;
     saturn.drawable.uniform.transform.rotation = rotation_from_axis_angle_mat3({0,1,0}, s_inclination);
     saturn.drawable.uniform.shading.specular = 0.0f;
-    saturn.drawable.texture_id = create_texture_gpu( image_load_png("scenes/3D_graphics/SolarSystem/assets/saturn/8k_saturn.png"));
+    saturn.texture_layer = load_sphere_texture("scenes/3D_graphics/SolarSystem/assets/saturn/8k_saturn.png");
     planets.push_back(saturn);
     // Saturn ring
     saturn_ring = create_planet(s_radius, s_mass, s_p, s_v, s_inclination, s_force, s_orbitradius, s_vel_rot);
-    saturn_ring.drawable = create_ring(sr_int_radius*1000, sr_ext_radius*1000);
+    saturn_ring.drawable = mesh_drawable(create_ring(sr_int_radius, sr_ext_radius), 0, 0, true);
+    saturn_ring.display_scale = 1000;
     saturn_ring.drawable.uniform.transform.rotation = rotation_from_axis_angle_mat3({0,1,0}, s_inclination);
     saturn_ring.drawable.uniform.shading = {1,0,0};
     // Load a texture (with transparent background)
-    saturn_ring.drawable.texture_id = create_texture_gpu( image_load_png("scenes/3D_graphics/SolarSystem/assets/saturn/8k_saturn_ring_alpha.png"), GL_REPEAT, GL_REPEAT );
+    saturn_ring.drawable.texture_id = streaming->create_texture_gpu("scenes/3D_graphics/SolarSystem/assets/saturn/8k_saturn_ring_alpha.png", {0,0,0,0}, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, texture_compression::automatic);
+    saturn_ring.drawable.sampler = sampler_object(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE); // clamp to edge avoids sampling artifacts
 }
 
 void scene_model::setup_uranus()
 {
     planet uranus;
     uranus = create_planet(u_radius, u_mass, u_p, u_v, u_inclination, u_force, u_orbitradius, u_vel_rot);
-    uranus.drawable = mesh_primitive_sphere(u_radius*1000, {0,0,0}, 40, 80);
+    uranus.drawable = create_sphere();
+    uranus.display_scale = 1000;
     uranus.drawable.uniform.transform.rotation = rotation_from_axis_angle_mat3({0,1,0}, u_inclination);
     uranus.drawable.uniform.shading.specular = 0.0f;
-    uranus.drawable.texture_id = create_texture_gpu( image_load_png("scenes/3D_graphics/SolarSystem/assets/uranus/2k_uranus.png"));
+    uranus.texture_layer = load_sphere_texture("scenes/3D_graphics/SolarSystem/assets/uranus/2k_uranus.png");
     planets.push_back(uranus);
 }
 
@@ -351,111 +420,121 @@ void scene_model::setup_neptune()
 {
     planet neptune;
     neptune = create_planet(n_radius, n_mass, n_p, n_v, n_inclination, n_force, n_orbitradius, n_vel_rot);
-    neptune.drawable = mesh_primitive_sphere(n_radius*1000, {0,0,0}, 40, 80);
+    neptune.drawable = create_sphere();
+    neptune.display_scale = 1000;
     neptune.drawable.uniform.transform.rotation = rotation_from_axis_angle_mat3({0,1,0}, n_inclination);
     neptune.drawable.uniform.shading.specular = 0.0f;
-    neptune.drawable.texture_id = create_texture_gpu( image_load_png("scenes/3D_graphics/SolarSystem/assets/neptune/2k_neptune.png"));
+    neptune.texture_layer = load_sphere_texture("scenes/3D_graphics/SolarSystem/assets/neptune/2k_neptune.png");
     planets.push_back(neptune);
 }
 
 void scene_model::setup_moon()
 {
     moon = create_planet(mo_radius, mo_mass, mo_p, mo_v, mo_inclination, mo_force, mo_orbitradius, mo_vel_rot);
-    moon.drawable = mesh_primitive_sphere(mo_radius*1000, {0,0,0}, 40, 80);
+    moon.drawable = create_sphere();
+    moon.display_scale = 1000;
     moon.drawable.uniform.transform.rotation = rotation_from_axis_angle_mat3({0,1,0}, mo_inclination);
     moon.drawable.uniform.shading.specular = 0.0f;
-    moon.drawable.texture_id = create_texture_gpu( image_load_png("scenes/3D_graphics/SolarSystem/assets/moon/8k_moon.png"));
+    const std::string texture = texture_or_procedural("scenes/3D_graphics/SolarSystem/assets/moon/8k_moon.png",
+                                                      procedural_sphere(procedural_texture_type::rocky, {0.3f,0.3f,0.3f}, {0.7f,0.7f,0.68f}, 7));
+    moon.texture_layer = load_sphere_texture(texture);
+    moon.virtual_texture = virtual_textures->add(texture);
 }
 
-
-// ************************** //
-// DRAW FUNCTIONS
-// ************************** //
-
-void scene_model::draw_universe(std::map<std::string,GLuint>& shaders, scene_structure& scene)
+void scene_model::setup_spheres()
 {
-    // Before displaying a textured surface: bind the associated texture id
-    glBindTexture(GL_TEXTURE_2D, texture_universe_id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
-    draw(universe, scene.camera, shaders["mesh"]);
-    // After the surface is displayed it is safe to set the texture id to a white image
-    // Avoids to use the previous texture for another object
-    glBindTexture(GL_TEXTURE_2D, scene.texture_white);
+    // The layers are displayed in grey until their levels are streamed. The bodies are opaque: bc1 (4 bits per texel) is enough.
+    sphere_texture_array = streaming->create_texture_array_gpu(sphere_texture_files, sphere_texture_width, sphere_texture_height, {0.5f,0.5f,0.5f,1.0f}, GL_MIRRORED_REPEAT, GL_MIRRORED_REPEAT, texture_compression::bc1);
+    sphere_texture_files.clear();
+
+    // One instanced drawable per level of detail, all sharing the same texture array and sampler
+    sphere_impostors = mesh_drawable_instanced(mesh_gpu_registry_quad(), 0, sphere_texture_array);
+    sphere_impostors.sampler = sampler_object(GL_MIRRORED_REPEAT, GL_MIRRORED_REPEAT);
+    setup_sphere_levels(false);
+    sphere_lod = level_of_detail(std::vector<float>(sphere_lod_screen_radius, sphere_lod_screen_radius+sphere_lod_levels));
 }
 
-void scene_model::draw_sun(std::map<std::string,GLuint>& shaders, scene_structure& scene)
+void scene_model::setup_sphere_levels(bool barycentric)
 {
-    glBindTexture(GL_TEXTURE_2D, texture_sun_id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
-    draw(sun.drawable, scene.camera, shaders["mesh"]);
-    glBindTexture(GL_TEXTURE_2D, scene.texture_white);
-}
-
-void scene_model::draw_planets(std::map<std::string,GLuint>& shaders, scene_structure& scene)
-{
-    for(planet& it : planets){
-        glBindTexture(GL_TEXTURE_2D, it.drawable.texture_id);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
-        draw(it.drawable, scene.camera, shaders["mesh"]);
-        glBindTexture(GL_TEXTURE_2D, scene.texture_white);
+    // The barycentric geometry (split triangles) is only created once the wireframe is asked
+    for(mesh_drawable_instanced& level : spheres)
+        level.clear();
+    spheres.clear();
+    for(size_t k=0; k<sphere_lod_levels-1; ++k) {
+        spheres.push_back( mesh_drawable_instanced(mesh_gpu_registry_sphere(sphere_lod_samples[k][0], sphere_lod_samples[k][1], barycentric), 0, sphere_texture_array) );
+        spheres.back().sampler = sphere_impostors.sampler;
     }
+    spheres_barycentric = barycentric;
 }
 
-void scene_model::draw_moon(std::map<std::string,GLuint>& shaders, scene_structure& scene)
+unsigned int scene_model::load_sphere_texture(const std::string& filename)
 {
-    glBindTexture(GL_TEXTURE_2D, moon.drawable.texture_id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
-    draw(moon.drawable, scene.camera, shaders["mesh"]);
-    glBindTexture(GL_TEXTURE_2D, scene.texture_white);
+    // The texture array is created once all the layers are known (setup_spheres)
+    sphere_texture_files.push_back(filename);
+    return static_cast<unsigned int>(sphere_texture_files.size()-1);
 }
 
-void scene_model::draw_saturn_ring(std::map<std::string,GLuint>& shaders, scene_structure& scene)
+procedural_texture_parameters procedural_sphere(procedural_texture_type type, const vec3& color_low, const vec3& color_high, unsigned int seed)
 {
-    // Enable use of alpha component as color blending for transparent elements
-    //  new color = previous color + (1-alpha) current color
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    // Disable depth buffer writing
-    //  - Transparent elements cannot use depth buffer
-    //  - They are supposed to be display from furest to nearest elements
-    glDepthMask(false);
-
-    glBindTexture(GL_TEXTURE_2D, saturn_ring.drawable.texture_id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // avoids sampling artifacts
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE); // avoids sampling artifacts
-
-    draw(saturn_ring.drawable, scene.camera, shaders["mesh"]);
-
-    glBindTexture(GL_TEXTURE_2D, scene.texture_white);
-    glDepthMask(true);
+    procedural_texture_parameters parameters;
+    parameters.type = type;
+    parameters.width = sphere_texture_width;
+    parameters.height = sphere_texture_height;
+    parameters.color_low = color_low;
+    parameters.color_high = color_high;
+    parameters.seed = seed;
+    return parameters;
 }
 
-void scene_model::draw_sun_ring(std::map<std::string,GLuint>& shaders, scene_structure& scene)
+std::string texture_or_procedural(const std::string& filename, const procedural_texture_parameters& parameters)
 {
-    // Enable use of alpha component as color blending for transparent elements
-    //  new color = previous color + (1-alpha) current color
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // The textures missing from the assets are generated by the loading threads the first time they are decoded,
+    // and cached with the assets (then packed with them)
+    procedural_texture_fallback(filename, parameters, "scenes/3D_graphics/SolarSystem/assets/procedural");
+    return filename;
+}
 
-    // Disable depth buffer writing
-    //  - Transparent elements cannot use depth buffer
-    //  - They are supposed to be display from furest to nearest elements
-    glDepthMask(false);
 
-    glBindTexture(GL_TEXTURE_2D, sun_ring.texture_id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // avoids sampling artifacts
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE); // avoids sampling artifacts
+// ************************** //
+// DRAW FUNCTIONS
+// ************************** //
 
-    sun_ring.uniform.transform.rotation = scene.camera.orientation;
-    draw(sun_ring, scene.camera, shaders["mesh"]);
+void scene_model::fill_render_queue(std::map<std::string,GLuint>& shaders, scene_structure& scene, const frustum& view_frustum)
+{
+    queue.clear();
+
+    // Only the visible spheres are kept as instances, grouped by level of detail
+    GLint viewport[4] = {0,0,0,0};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    update_spheres_instances(view_frustum, scene.camera, float(viewport[3]));
+
+    // The rings textures are only kept at full resolution while they are visible and large on screen
+    if(streaming) {
+        for(const mesh_drawable* ring : {&saturn_ring.drawable, &sun_ring}) {
+            const bounding_sphere bounds = world_bounding_sphere(*ring);
+            if(is_visible(view_frustum, bounds))
+                streaming->require(ring->texture_id, 2.0f*screen_radius(bounds, scene.camera, float(viewport[3])));
+        }
+    }
 
-    glBindTexture(GL_TEXTURE_2D, scene.texture_white);
-    glDepthMask(true);
+    // Universe: drawn after the opaque elements, only on the pixels which are not covered
+    queue.push(universe, shaders["skybox"]);
+
+    // Sun, planets and moon: one instanced draw call per level of detail, plus one for the distant bodies drawn as impostors.
+    //  Each instance reads its own texture layer
+    for(const mesh_drawable_instanced& level : spheres)
+        if(level.number_instances>0)
+            queue.push(level, shaders["mesh_instanced"], render_pass::opaque, scene.camera);
+    if(sphere_impostors.number_instances>0)
+        queue.push(sphere_impostors, shaders["sphere_impostor"], render_pass::opaque, scene.camera);
+
+    // Transparent elements, either displayed from furthest to nearest, or accumulated independently of their order
+    queue.transparency = gui_scene.order_independent_transparency ? transparency_mode::weighted_blended : transparency_mode::sorted;
+    queue.oit_composite_shader = shaders["oit_composite"];
+    // The rings only have an ambiant term: the unlit variant skips the lighting
+    const GLuint transparent_shader = gui_scene.order_independent_transparency ? shaders["mesh_oit_unlit"] : shaders["mesh_unlit"];
+    queue.push(saturn_ring.drawable, transparent_shader, render_pass::transparent, scene.camera);
+    queue.push(sun_ring, transparent_shader, render_pass::transparent, scene.camera);
 }
 
 
@@ -466,10 +545,10 @@ void scene_model::draw_sun_ring(std::map<std::string,GLuint>& shaders, scene_str
 void scene_model::update_position_planets(float dt)
 {
     for(planet& it : planets){
-        vec3& p = it.p;
-        vec3& v = it.v;
+        dvec3& p = it.p;
+        dvec3& v = it.v;
 
-        vec3 F = it.force;
+        dvec3 F = it.force;
 
         // Numerical integration
         v = v + dt* F/it.mass;
@@ -478,18 +557,18 @@ void scene_model::update_position_planets(float dt)
         const mat3 Inclination = rotation_from_axis_angle_mat3({0,1,0}, it.inclination);
         const mat3 Rotation = rotation_from_axis_angle_mat3({0,0,1}, it.hour);
         it.drawable.uniform.transform.rotation = Inclination * Rotation;
-        it.drawable.uniform.transform.translation = p + back*normalize(p);
-        it.force = G * sun.mass * it.mass/(norm(p)*norm(p)) * -1.0f *normalize(p);
+        it.position = gui_scene.true_scale ? p : p + back*normalize(p);
+        it.force = float(G * sun.mass * it.mass/dot(p,p)) * -1.0f *normalize(p);
         it.hour += it.vel_rot * dt;
     }
 }
 
 void scene_model::update_position_moon(float dt)
 {
-    vec3& mo_p = moon.p;
-    vec3& mo_v = moon.v;
+    dvec3& mo_p = moon.p;
+    dvec3& mo_v = moon.v;
 
-    vec3 mo_F = moon.force;
+    dvec3 mo_F = moon.force;
 
     // Numerical integration
     mo_v = mo_v + dt* mo_F/moon.mass;
@@ -498,17 +577,126 @@ void scene_model::update_position_moon(float dt)
     const mat3 Inclination = rotation_from_axis_angle_mat3({0,1,0}, moon.inclination);
     const mat3 Rotation = rotation_from_axis_angle_mat3({0,0,1}, moon.hour);
     moon.drawable.uniform.transform.rotation = Inclination * Rotation;
-    moon.drawable.uniform.transform.translation = mo_p + back*normalize(mo_p) + 2000*planets[2].radius* normalize(mo_p - planets[2].p);
-    moon.force = G * sun.mass * moon.mass/(norm(mo_p)*norm(mo_p)) * -1.0f *normalize(mo_p) + G * planets[2].mass * moon.mass/(norm(planets[2].p - mo_p)*norm(planets[2].p - mo_p)) * -1.0f *normalize(mo_p - planets[2].p);
+    if(gui_scene.true_scale)
+        moon.position = mo_p;
+    else
+        moon.position = mo_p + back*normalize(mo_p) + 2000*planets[2].radius* normalize(mo_p - planets[2].p);
+    const dvec3 earth_to_moon = mo_p - planets[2].p;
+    moon.force = float(G * sun.mass * moon.mass/dot(mo_p,mo_p)) * -1.0f *normalize(mo_p) + float(G * planets[2].mass * moon.mass/dot(earth_to_moon,earth_to_moon)) * -1.0f *normalize(earth_to_moon);
     moon.hour += moon.vel_rot * dt;
 }
 
 void scene_model::update_position_saturn_ring()
 {
-    saturn_ring.drawable.uniform.transform.translation = planets[5].drawable.uniform.transform.translation;
+    saturn_ring.position = planets[5].position;
     saturn_ring.drawable.uniform.transform.rotation = planets[5].drawable.uniform.transform.rotation;
 }
 
+void scene_model::update_relative_positions(std::map<std::string,GLuint>& shaders, const camera_scene& camera)
+{
+    // Radii are exaggerated unless the true scale is displayed
+    auto update_transform = [&](star& body) {
+        body.drawable.uniform.transform.translation = view_origin.relative(body.position);
+        body.drawable.uniform.transform.scaling = body.radius * (gui_scene.true_scale ? 1.0f : body.display_scale);
+    };
+    update_transform(sun);
+    for(planet& it : planets)
+        update_transform(it);
+    update_transform(moon);
+
+    saturn_ring.drawable.uniform.transform.translation = view_origin.relative(saturn_ring.position);
+    saturn_ring.drawable.uniform.transform.scaling = gui_scene.true_scale ? 1.0f : saturn_ring.display_scale;
+
+    // The sun ring is a billboard facing the camera
+    sun_ring.uniform.transform.translation = sun.drawable.uniform.transform.translation;
+    sun_ring.uniform.transform.rotation = camera.orientation;
+    sun_ring.uniform.transform.scaling = gui_scene.true_scale ? 1.0f : sun.display_scale;
+
+    // The sun is the light source
+    for(const char* name : {"mesh", "mesh_oit", "mesh_instanced", "sphere_impostor"}) {
+        glUseProgram(shaders[name]);
+        uniform(shaders[name], "light", sun.drawable.uniform.transform.translation);
+    }
+
+    update_shadows(shaders);
+}
+
+void scene_model::update_shadows(std::map<std::string,GLuint>& shaders)
+{
+    // Every body but the sun is an occluder, with its displayed radius (no occluder: no shadow is selected)
+    shadows.clear();
+    shadows.light_center = sun.drawable.uniform.transform.translation;
+    shadows.light_radius = sun.drawable.uniform.transform.scaling;
+    int moon_index = -1;
+    if(gui_scene.shadows) {
+        for(const planet& it : planets)
+            shadows.add(it.drawable.uniform.transform.translation, it.drawable.uniform.transform.scaling);
+        moon_index = shadows.add(moon.drawable.uniform.transform.translation, moon.drawable.uniform.transform.scaling);
+    }
+
+    // Occluders of each body, sent as instance attributes
+    for(size_t k=0; k<planets.size(); ++k)
+        planets[k].shadow_occluders = shadows.select(planets[k].drawable.uniform.transform.translation, planets[k].drawable.uniform.transform.scaling, int(k));
+    moon.shadow_occluders = shadows.select(moon.drawable.uniform.transform.translation, moon.drawable.uniform.transform.scaling, moon_index);
+
+    for(const char* name : {"mesh", "mesh_oit"}) {
+        glUseProgram(shaders[name]);
+        shadows.send(shaders[name]);
+    }
+
+    // The ring shadows Saturn (and any body behind it), drawn as a mesh or as an impostor
+    const mesh_drawable_uniform& ring = saturn_ring.drawable.uniform;
+    for(const char* name : {"mesh_instanced", "sphere_impostor"}) {
+        const GLuint shader = shaders[name];
+        glUseProgram(shader);
+        shadows.send(shader);
+        uniform(shader, "ring_center", ring.transform.translation);
+        uniform(shader, "ring_normal", ring.transform.rotation*vec3{0,0,1});
+        uniform(shader, "ring_radius_interior", sr_int_radius*ring.transform.scaling);
+        uniform(shader, "ring_radius_exterior", sr_ext_radius*ring.transform.scaling);
+        uniform(shader, "ring_opacity", gui_scene.shadows ? 0.6f : 0.0f);
+    }
+}
+
+void scene_model::update_spheres_instances(const frustum& view_frustum, const camera_scene& camera, float viewport_height)
+{
+    std::vector<buffer<mesh_instance> > instances(spheres.size());
+    buffer<mesh_instance> impostors;
+
+    // Select the level of detail of each body from its radius on screen
+    auto add_instance = [&](star& body) {
+        const bounding_sphere bounds = world_bounding_sphere(body.drawable);
+        const float radius = screen_radius(bounds, camera, viewport_height);
+        body.lod_level = sphere_lod.select(radius, body.lod_level);
+
+        // The equator of the texture spans about 2*pi*radius pixels on screen
+        if(streaming && is_visible(view_frustum, bounds))
+            streaming->require(sphere_texture_array, 2.0f*pi*radius);
+
+        mesh_instance instance = sphere_instance(body);
+        if(!gui_scene.virtual_texturing)
+            instance.virtual_texture = -1.0f;
+        if(body.lod_level==0 && gui_scene.impostors)
+            impostors.push_back(instance);
+        else {
+            const size_t k = std::max(body.lod_level, 1u)-1;
+            instances[k].push_back(instance);
+        }
+    };
+    add_instance(sun);
+    for(planet& it : planets)
+        add_instance(it);
+    add_instance(moon);
+
+    for(size_t k=0; k<spheres.size(); ++k) {
+        queue.stats.culled += cull_instances(instances[k], spheres[k].geometry.bounding, view_frustum);
+        spheres[k].update_instances(instances[k]);
+    }
+    // Impostors are bounded by the unit sphere (not by their quad)
+    queue.stats.culled += cull_instances(impostors, spheres[0].geometry.bounding, view_frustum);
+    sphere_impostors.update_instances(impostors);
+}
+
 
 
  void scene_model::set_gui(timer_basic& timer)
@@ -533,6 +721,22 @@ void scene_model::update_position_saturn_ring()
 
      ImGui::Text("Display: "); ImGui::SameLine();
      ImGui::Checkbox("Wireframe", &gui_scene.wireframe); ImGui::SameLine();
+     ImGui::Checkbox("Impostors", &gui_scene.impostors); ImGui::SameLine();
+     ImGui::Checkbox("Eclipses", &gui_scene.shadows); ImGui::SameLine();
+     ImGui::Checkbox("True scale", &gui_scene.true_scale); ImGui::NewLine();
+     ImGui::Checkbox("Order independent transparency", &gui_scene.order_independent_transparency); ImGui::NewLine();
+     ImGui::SliderInt("Texture memory (MB)", &gui_scene.texture_budget, 16, 2048);
+     if(streaming)
+         ImGui::Text("Textures resident: %.1f MB", double(streaming->memory_used())/double(1<<20));
+     ImGui::Checkbox("Virtual textures", &gui_scene.virtual_texturing);
+     if(virtual_textures) {
+         ImGui::SameLine();
+         ImGui::Text("tiles: %u / %u", unsigned(virtual_textures->resident_tiles()), unsigned(virtual_textures->capacity()));
+     }
+
+     ImGui::Text("Drawn: %u, culled: %u, draw calls: %u", queue.stats.drawn, queue.stats.culled, queue.stats.draw_calls);
+     ImGui::Text("Triangles: %u", queue.stats.triangles);
+     ImGui::Text("Sort: %.3f ms, transparent pass (GPU): %.3f ms", double(queue.stats.sort_ms), double(queue.stats.transparent_ms));
 
  }
 
@@ -541,14 +745,14 @@ void scene_model::update_position_saturn_ring()
      for (int i=0; i<10; i++){
          if (gui_scene.stars[i]){
              if(i<8){
-                 scene.camera.translation = -planets[i].drawable.uniform.transform.translation;
+                 view_origin.set(planets[i].position, scene.camera);
                  break;
              }else if(i==8)
              {
-                 scene.camera.translation = -sun.drawable.uniform.transform.translation;
+                 view_origin.set(sun.position, scene.camera);
                  break;
              }else if(i==9){
-                 scene.camera.translation = -moon.drawable.uniform.transform.translation;
+                 view_origin.set(moon.position, scene.camera);
                  break;
              }
          }
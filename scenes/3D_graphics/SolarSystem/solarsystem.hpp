@@ -17,6 +17,12 @@ struct gui_scene_structure
     bool wireframe   = false;
     bool surface     = true;
     bool skeleton    = false;
+    bool impostors   = true;
+    bool shadows     = true;  // analytic shadows of the bodies and of the Saturn ring
+    bool true_scale  = false; // display the real radii and distances of the bodies
+    bool order_independent_transparency = false; // weighted blended transparency instead of sorted blending
+    int texture_budget = 256; // memory of the streamed textures (in MB)
+    bool virtual_texturing = true; // the rocky planets sample their virtual textures (only the visible tiles are resident)
     bool stars[10] = {false, false, false, false, false, false, false, false, false, false};
 
 };
@@ -24,15 +30,20 @@ struct gui_scene_structure
 struct star {
     float radius;
     float mass;
-    GLuint texture;
+    unsigned int texture_layer; // layer in the texture array shared by all spheres
+    int virtual_texture = -1;   // index in scene_model::virtual_textures, -1 if none
+    unsigned int lod_level = 0; // level of detail selected at the previous frame
+    float display_scale = 1.0f; // exaggeration of the radius when the true scale is not displayed
+    vcl::vec2 shadow_occluders = {-1,-1}; // bodies which may eclipse the sun seen from this one (indices in scene_model::shadows)
     vcl::mesh_drawable drawable;
-    vcl::vec3 p ;
-    vcl::vec3 v ;
+    vcl::dvec3 p ;
+    vcl::dvec3 v ;
+    vcl::dvec3 position = vcl::make_dvec3(0,0,0); // displayed world position (p, or shifted away from the sun out of true scale)
 };
 
 struct planet: star {
     float inclination;
-    vcl::vec3 force;
+    vcl::dvec3 force;
     float orbit_radius; // axis a
     float vel_rot;
     float hour =0;
@@ -55,6 +66,8 @@ struct scene_model : scene_base
 
     void setup_data(std::map<std::string,GLuint>& shaders, scene_structure& scene, gui_structure& gui);
     void frame_draw(std::map<std::string,GLuint>& shaders, scene_structure& scene, gui_structure& gui);
+    /** Stop the loading threads and release their OpenGL objects, before the context is destroyed */
+    void cleanup();
 
     void set_gui(vcl::timer_basic& timer);
     void camera_position_at_each_star(scene_structure& scene);
@@ -71,19 +84,20 @@ struct scene_model : scene_base
     void setup_uranus();
     void setup_neptune();
     void setup_moon();
+    void setup_spheres();
+    void setup_sphere_levels(bool barycentric);
+    unsigned int load_sphere_texture(const std::string& filename);
 
     // Draw functions
-    void draw_universe(std::map<std::string,GLuint>& shaders, scene_structure& scene);
-    void draw_sun(std::map<std::string,GLuint>& shaders, scene_structure& scene);
-    void draw_planets(std::map<std::string,GLuint>& shaders, scene_structure& scene);
-    void draw_moon(std::map<std::string,GLuint>& shaders, scene_structure& scene);
-    void draw_saturn_ring(std::map<std::string,GLuint>& shaders, scene_structure& scene);
-    void draw_sun_ring(std::map<std::string,GLuint>& shaders, scene_structure& scene);
+    void fill_render_queue(std::map<std::string,GLuint>& shaders, scene_structure& scene, const vcl::frustum& view_frustum);
 
     // Update data functions
     void update_position_planets(float dt);
     void update_position_moon(float dt);
     void update_position_saturn_ring();
+    void update_relative_positions(std::map<std::string,GLuint>& shaders, const vcl::camera_scene& camera);
+    void update_shadows(std::map<std::string,GLuint>& shaders);
+    void update_spheres_instances(const vcl::frustum& view_frustum, const vcl::camera_scene& camera, float viewport_height);
 
     // visual representation of a surface
     gui_scene_structure gui_scene;
@@ -92,7 +106,7 @@ struct scene_model : scene_base
     vcl::timer_interval timer;    // Timer allowing to indicate periodic events
 
     // Universe
-    vcl::mesh_drawable universe;
+    vcl::skybox universe;
 
     // Sun
     star sun;
@@ -107,9 +121,26 @@ struct scene_model : scene_base
     // Moon
     planet moon;
 
-    // Textures
-    GLuint texture_universe_id;
-    GLuint texture_sun_id;
+    // All spherical bodies (sun, planets, moon) drawn with one instanced call per level of detail
+    //  Level 0 of sphere_lod: ray-traced impostors, level k>0: spheres[k-1]
+    std::vector<vcl::mesh_drawable_instanced> spheres;
+    vcl::mesh_drawable_instanced sphere_impostors;
+    GLuint sphere_texture_array = 0;
+    bool spheres_barycentric = false; // the levels use split triangles to display the wireframe
+    vcl::level_of_detail sphere_lod;
+    std::vector<std::string> sphere_texture_files; // layers of the texture array, until it is created
+    std::unique_ptr<vcl::texture_loader> texture_loading; // decoding threads, only during setup_data
+    std::unique_ptr<vcl::texture_streaming> streaming;    // textures sharpened during the first frames
+    std::unique_ptr<vcl::virtual_texture_system> virtual_textures; // surfaces of the rocky planets, finer than the texture array
+
+    // Draw packets of the current frame
+    vcl::render_queue queue;
+
+    // World positions are in double precision, and sent to the GPU relatively to the camera target
+    vcl::floating_origin view_origin;
+
+    // Eclipses: the planets and the moon cast analytic soft shadows from the sun
+    vcl::sphere_shadows shadows;
 };
 
 
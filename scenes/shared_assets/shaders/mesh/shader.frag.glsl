@@ -1,44 +1,236 @@
 #version 330 core
 
+// Features (see shader_feature): UNLIT, NO_SPECULAR, TEXTURED, VERTEX_COLOR, INSTANCED, WEIGHTED_BLENDED, VIRTUAL_TEXTURE
+
 in struct fragment_data
 {
     vec4 position;
     vec4 normal;
     vec4 color;
-    vec2 texture_uv;
+    vec3 texture_uvw; // (u,v, layer of the texture array)
+    vec3 barycentric;
 } fragment;
 
+#ifdef INSTANCED
+flat in vec3 fragment_shading; // (ambiant, diffuse, specular)
+flat in ivec2 fragment_occluders; // indices in occluders, -1 if none
+#endif
+
+#ifdef TEXTURED
+#ifdef INSTANCED
+uniform sampler2DArray texture_sampler;
+#else
 uniform sampler2D texture_sampler;
+#endif
+#endif
+
+#ifdef VIRTUAL_TEXTURE
+// Virtual texture of the instance (see virtual_texture_system), -1 if it samples the texture array
+flat in int fragment_virtual_texture;
+uniform usampler2DArray page_table; // layer: virtual texture*virtual_levels + level, (slot x, slot y, level of the tile, resident) per page
+uniform sampler2D tile_atlas;
+uniform ivec2 virtual_size;
+uniform int virtual_levels;
+uniform int tile_size;
+uniform int tile_border;
+uniform int slot_size; // tile and its borders in the atlas
+
+// Finest resident tile covering uv at a level, alpha is 0 if there is none
+vec4 virtual_texture_fetch(vec2 uv, int level)
+{
+    ivec2 size = max(virtual_size>>level, ivec2(1));
+    ivec2 page = clamp(ivec2(uv*vec2(size))/tile_size, ivec2(0), (size+tile_size-1)/tile_size-1);
+    uvec4 entry = texelFetch(page_table, ivec3(page, fragment_virtual_texture*virtual_levels+level), 0);
+    if(entry.w==0u)
+        return vec4(0.0);
+
+    // The tile may be coarser than the level (parent displayed until the tile is loaded)
+    ivec2 tile_level_size = max(virtual_size>>int(entry.z), ivec2(1));
+    vec2 texel = uv*vec2(tile_level_size);
+    vec2 tile_page = clamp(floor(texel/float(tile_size)), vec2(0.0), vec2((tile_level_size+tile_size-1)/tile_size-1));
+    vec2 atlas_texel = vec2(entry.xy)*float(slot_size) + float(tile_border) + texel-tile_page*float(tile_size);
+    return vec4(textureLod(tile_atlas, atlas_texel/vec2(textureSize(tile_atlas,0)), 0.0).rgb, 1.0);
+}
 
+// Trilinear filtering between the two levels around level
+vec4 virtual_texture_sample(vec2 uv, float level)
+{
+    int level0 = int(level);
+    vec4 c0 = virtual_texture_fetch(uv, level0);
+    vec4 c1 = virtual_texture_fetch(uv, min(level0+1, virtual_levels-1));
+    return mix(c0, c1, fract(level));
+}
+#endif
+
+#ifdef WEIGHTED_BLENDED
+// Weighted blended order independent transparency (see weighted_blended_oit)
+layout (location = 0) out vec4 accumulation; // (weight*alpha*color, alpha)
+layout (location = 1) out vec4 weight;       // (weight*alpha, 0, 0, alpha)
+#else
 out vec4 FragColor;
+#endif
 
 uniform vec3 camera_position;
 uniform vec3 color     = vec3(1.0, 1.0, 1.0);
 uniform float color_alpha = 1.0;
+#ifndef INSTANCED
 uniform float ambiant  = 0.2;
 //uniform float diffuse  = 0.8;
 uniform float diffuse  = 1.0;
 uniform float specular = 0.5;
+uniform ivec2 object_occluders = ivec2(-1,-1); // indices in occluders, -1 if none
+#endif
 uniform int specular_exponent = 128;
 
+// single pass wireframe: the edges are blended where a barycentric coordinate is close to 0
+uniform bool wireframe = false;
+uniform vec3 wireframe_color = vec3(0.0, 0.0, 0.5);
+uniform float wireframe_width = 1.0; // in pixels
+
+#ifdef LOG_DEPTH
+// logarithmic depth (see perspective_structure)
+uniform float depth_log_coefficient = 0.0;
+#endif
+
+#ifndef UNLIT
 // vec3 light = vec3(camera_position.x, camera_position.y, camera_position.z);
-vec3 light = vec3(0, 0, 0);
+uniform vec3 light = vec3(0.0, 0.0, 0.0); // position of the light, in the same frame as the vertices
+
+// Analytic soft shadows: visible fraction of the light disc (radius light_radius) hidden by spheres (see sphere_shadows)
+uniform vec4 occluders[16]; // (center, radius), in the same frame as the vertices
+uniform float light_radius = 1.0;
+// Annulus (Saturn ring) casting a shadow of constant opacity, disabled if ring_opacity is 0
+uniform vec3 ring_center = vec3(0.0, 0.0, 0.0);
+uniform vec3 ring_normal = vec3(0.0, 0.0, 1.0);
+uniform float ring_radius_interior = 0.0;
+uniform float ring_radius_exterior = 0.0;
+uniform float ring_opacity = 0.0;
+
+float sphere_visibility(vec3 p, vec4 occluder)
+{
+    vec3 to_light = light-p;
+    vec3 to_occluder = occluder.xyz-p;
+    float d_light = length(to_light);
+    float d_occluder = length(to_occluder);
+    if(d_occluder>=d_light)
+        return 1.0;
+
+    // Apparent radii of the light and of the occluder, and angle between their centers (small angles)
+    float a_light = light_radius/d_light;
+    float a_occluder = occluder.w/d_occluder;
+    float separation = acos(clamp(dot(to_light,to_occluder)/(d_light*d_occluder), -1.0, 1.0));
+
+    // Fully covered light disc (umbra), or ring of light around the occluder (antumbra), faded out in the penumbra
+    float covered = min(1.0, (a_occluder*a_occluder)/(a_light*a_light));
+    return 1.0 - covered*(1.0-smoothstep(abs(a_light-a_occluder), a_light+a_occluder, separation));
+}
+
+float ring_visibility(vec3 p)
+{
+    if(ring_opacity<=0.0)
+        return 1.0;
+    // Intersection of the segment p->light with the ring plane
+    vec3 to_light = light-p;
+    float t = dot(ring_center-p, ring_normal)/dot(to_light, ring_normal);
+    if(!(t>0.0 && t<1.0))
+        return 1.0;
+    float r = length(p+t*to_light-ring_center);
+    return (r>ring_radius_interior && r<ring_radius_exterior) ? 1.0-ring_opacity : 1.0;
+}
+#endif
 
 void main()
 {
-    vec3 n = normalize(fragment.normal.xyz);
-    vec3 u = normalize(light-fragment.position.xyz);
-    vec3 r = reflect(u,n);
-    vec3 t = normalize(fragment.position.xyz-camera_position);
+#ifdef INSTANCED
+    float ambiant  = fragment_shading.x;
+    float diffuse  = fragment_shading.y;
+    float specular = fragment_shading.z;
+    ivec2 shadow_occluders = fragment_occluders;
+#else
+    ivec2 shadow_occluders = object_occluders;
+#endif
+
+#ifdef VIRTUAL_TEXTURE
+    // Level of the virtual texture from the footprint of the pixel (derivatives: outside of the branches)
+    vec2 virtual_texel = fragment.texture_uvw.xy*vec2(virtual_size);
+    float virtual_level = clamp(0.5*log2(max(dot(dFdx(virtual_texel),dFdx(virtual_texel)), dot(dFdy(virtual_texel),dFdy(virtual_texel)))), 0.0, float(virtual_levels-1));
+#endif
+
+    float diffuse_value  = 0.0;
+    float specular_value = 0.0;
+#ifndef UNLIT
+    // Instances may still be unlit (the sun): the branch is coherent over each instance
+#ifdef NO_SPECULAR
+    if(diffuse>0.0)
+#else
+    if(diffuse>0.0 || specular>0.0)
+#endif
+    {
+        vec3 n = normalize(fragment.normal.xyz);
+        vec3 u = normalize(light-fragment.position.xyz);
 
+        float shadow = ring_visibility(fragment.position.xyz);
+        if(shadow_occluders.x>=0)
+            shadow *= sphere_visibility(fragment.position.xyz, occluders[shadow_occluders.x]);
+        if(shadow_occluders.y>=0)
+            shadow *= sphere_visibility(fragment.position.xyz, occluders[shadow_occluders.y]);
 
-    float diffuse_value  = diffuse * clamp( dot(u,n), 0.0, 1.0);
-    float specular_value = specular * pow( clamp( dot(r,t), 0.0, 1.0), specular_exponent);
+        diffuse_value  = shadow * diffuse * clamp( dot(u,n), 0.0, 1.0);
+#ifndef NO_SPECULAR
+        vec3 r = reflect(u,n);
+        vec3 t = normalize(fragment.position.xyz-camera_position);
+        specular_value = shadow * specular * pow( clamp( dot(r,t), 0.0, 1.0), specular_exponent);
+#endif
+    }
+#endif
 
+    vec4 c_base = vec4(color, color_alpha);
+#ifdef VERTEX_COLOR
+    c_base *= fragment.color;
+#endif
+#ifdef TEXTURED
+#ifdef INSTANCED
+    vec4 c_texture = texture(texture_sampler, fragment.texture_uvw);
+#ifdef VIRTUAL_TEXTURE
+    // The texture array layer is displayed until a tile is resident
+    if(fragment_virtual_texture>=0) {
+        vec4 c_virtual = virtual_texture_sample(clamp(fragment.texture_uvw.xy, 0.0, 1.0), virtual_level);
+        if(c_virtual.a>0.0)
+            c_texture = c_virtual;
+    }
+#endif
+    c_base *= c_texture;
+#else
+    c_base *= texture(texture_sampler, fragment.texture_uvw.xy);
+#endif
+#endif
 
     vec3 white = vec3(1.0);
-    vec4 color_texture = texture(texture_sampler, fragment.texture_uv);
-    vec3 c = (ambiant+diffuse_value)*color.rgb*fragment.color.rgb*color_texture.rgb + specular_value*white;
+    vec3 c = (ambiant+diffuse_value)*c_base.rgb + specular_value*white;
+
+    vec3 b = fragment.barycentric;
+    if(wireframe && b.x+b.y+b.z>0.5) {
+        vec3 edge = smoothstep(vec3(0.0), wireframe_width*fwidth(b), b);
+        c = mix(wireframe_color, c, min(min(edge.x, edge.y), edge.z));
+    }
+
+    float alpha = c_base.a;
+
+#ifdef LOG_DEPTH
+    // 1/gl_FragCoord.w is the clip-space w, i.e. the distance to the camera along the view axis
+    float depth = 0.5*depth_log_coefficient*log2(1.0+1.0/gl_FragCoord.w);
+    gl_FragDepth = depth;
+#else
+    // The depth is not written: the early depth test stays enabled
+    float depth = gl_FragCoord.z;
+#endif
 
-    FragColor = vec4(c, color_texture.a*fragment.color.a*color_alpha);
+#ifdef WEIGHTED_BLENDED
+    // Close and opaque fragments have a larger weight (McGuire and Bavoil, equation 10)
+    float w = clamp(pow(min(1.0, alpha*10.0)+0.01, 3.0) * 1e8 * pow(1.0-0.9*depth, 3.0), 1e-2, 3e3);
+    accumulation = vec4(c*alpha*w, alpha);
+    weight = vec4(alpha*w, 0.0, 0.0, alpha);
+#else
+    FragColor = vec4(c, alpha);
+#endif
 }
@@ -1,24 +1,48 @@
 #version 330 core
 
+// Features (see shader_feature): INSTANCED, VIRTUAL_TEXTURE
+
 layout (location = 0) in vec4 position;
 layout (location = 1) in vec4 normal;
 layout (location = 2) in vec4 color;
 layout (location = 3) in vec2 texture_uv;
+layout (location = 9) in vec3 barycentric; // (0,0,0) if the triangles are not split
+
+#ifdef INSTANCED
+// per-instance model transformation
+layout (location = 4) in vec3 rotation_row0;
+layout (location = 5) in vec3 rotation_row1;
+layout (location = 6) in vec3 rotation_row2;
+layout (location = 7) in vec4 translation_scaling; // (tx,ty,tz, scaling)
+layout (location = 8) in vec4 shading_layer;       // (ambiant, diffuse, specular, texture layer)
+layout (location = 10) in vec2 occluder_indices;   // shadow casting spheres, -1 if none
+#ifdef VIRTUAL_TEXTURE
+layout (location = 11) in float virtual_texture;   // index of the virtual texture, -1 if none
+#endif
+#endif
 
 out struct fragment_data
 {
     vec4 position;
     vec4 normal;
     vec4 color;
-    vec2 texture_uv;
+    vec3 texture_uvw; // (u,v, layer of the texture array)
+    vec3 barycentric;
 } fragment;
 
-
+#ifdef INSTANCED
+flat out vec3 fragment_shading;
+flat out ivec2 fragment_occluders;
+#ifdef VIRTUAL_TEXTURE
+flat out int fragment_virtual_texture;
+#endif
+#else
 // model transformation
 uniform vec3 translation = vec3(0.0, 0.0, 0.0);                      // user defined translation
 uniform mat3 rotation = mat3(1.0,0.0,0.0, 0.0,1.0,0.0, 0.0,0.0,1.0); // user defined rotation
 uniform float scaling = 1.0;                                         // user defined scaling
 uniform vec3 scaling_axis = vec3(1.0,1.0,1.0);                       // user defined scaling
+#endif
 
 
 // view transform
@@ -30,19 +54,29 @@ uniform mat4 perspective;
 
 void main()
 {
-    // scaling matrix
-    mat4 S = mat4(scaling*scaling_axis.x,0.0,0.0,0.0, 0.0,scaling*scaling_axis.y,0.0,0.0, 0.0,0.0,scaling*scaling_axis.z,0.0, 0.0,0.0,0.0,1.0);
-    // 4x4 rotation matrix
-    mat4 R = mat4(rotation);
-    // 4D translation
-    vec4 T = vec4(translation,0.0);
-
+#ifdef INSTANCED
+    // rotation is sent row by row
+    mat3 R = transpose(mat3(rotation_row0, rotation_row1, rotation_row2));
+    vec3 S = vec3(translation_scaling.w);
+    vec3 T = translation_scaling.xyz;
+    fragment.texture_uvw = vec3(texture_uv, shading_layer.w);
+    fragment_shading = shading_layer.xyz;
+    fragment_occluders = ivec2(occluder_indices);
+#ifdef VIRTUAL_TEXTURE
+    fragment_virtual_texture = int(virtual_texture);
+#endif
+#else
+    mat3 R = rotation;
+    vec3 S = scaling*scaling_axis;
+    vec3 T = translation;
+    fragment.texture_uvw = vec3(texture_uv, 0.0);
+#endif
 
     fragment.color = color;
-    fragment.texture_uv = texture_uv;
+    fragment.barycentric = barycentric;
 
-    fragment.normal = R*normal;
-    vec4 position_transformed = R*S*position + T;
+    fragment.normal = vec4(R*normal.xyz, 0.0);
+    vec4 position_transformed = vec4(R*(S*position.xyz) + T, 1.0);
 
     fragment.position = position_transformed;
     gl_Position = perspective * view * position_transformed;
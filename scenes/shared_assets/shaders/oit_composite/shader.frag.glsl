@@ -0,0 +1,19 @@
+#version 330 core
+
+in vec2 texture_uv;
+
+uniform sampler2D accumulation_sampler; // (sum weight*alpha*color, revealage)
+uniform sampler2D weight_sampler;       // (sum weight*alpha)
+
+out vec4 FragColor;
+
+void main()
+{
+    vec4 accumulation = texture(accumulation_sampler, texture_uv);
+    float revealage = accumulation.a;
+    if(revealage>=1.0)
+        discard; // no transparent element on this pixel
+
+    float weight = max(texture(weight_sampler, texture_uv).r, 1e-5);
+    FragColor = vec4(accumulation.rgb/weight, revealage);
+}
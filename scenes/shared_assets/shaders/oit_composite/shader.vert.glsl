@@ -0,0 +1,11 @@
+#version 330 core
+
+out vec2 texture_uv;
+
+void main()
+{
+    // Full screen triangle generated without vertex buffer
+    vec2 p = vec2(float((gl_VertexID<<1) & 2), float(gl_VertexID & 2));
+    texture_uv = p;
+    gl_Position = vec4(2.0*p-1.0, 0.0, 1.0);
+}
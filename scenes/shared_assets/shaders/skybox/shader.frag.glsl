@@ -0,0 +1,15 @@
+#version 330 core
+
+in struct fragment_data
+{
+    vec3 direction;
+} fragment;
+
+uniform samplerCube image_skybox;
+
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(texture(image_skybox, fragment.direction).rgb, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+
+layout (location = 0) in vec4 position;
+
+out struct fragment_data
+{
+    vec3 direction;
+} fragment;
+
+uniform mat4 view;
+uniform mat4 perspective;
+
+void main()
+{
+    // Only the rotation of the camera is applied: the sky box is always centered on the camera
+    vec4 p = perspective * vec4(mat3(view) * position.xyz, 1.0);
+    fragment.direction = position.xyz;
+
+    // z=w: the sky box is projected on the far plane
+    gl_Position = p.xyww;
+}
@@ -0,0 +1,142 @@
+#version 330 core
+
+in struct fragment_data
+{
+    vec4 position;
+} fragment;
+
+flat in vec4 sphere;           // (center, radius)
+flat in mat3 sphere_rotation;
+flat in vec4 fragment_shading; // (ambiant, diffuse, specular, texture layer)
+flat in ivec2 fragment_occluders; // indices in occluders, -1 if none
+
+uniform sampler2DArray texture_sampler;
+
+out vec4 FragColor;
+
+uniform vec3 camera_position;
+uniform vec3 color     = vec3(1.0, 1.0, 1.0);
+uniform float color_alpha = 1.0;
+uniform int specular_exponent = 128;
+
+// view transform
+uniform mat4 view;
+// perspective matrix
+uniform mat4 perspective;
+
+#ifdef LOG_DEPTH
+// logarithmic depth (see perspective_structure)
+uniform float depth_log_coefficient = 0.0;
+#endif
+
+uniform vec3 light = vec3(0.0, 0.0, 0.0); // position of the light, in the same frame as the vertices
+
+// Same soft shadows as the instanced meshes (see sphere_shadows)
+uniform vec4 occluders[16]; // (center, radius)
+uniform float light_radius = 1.0;
+uniform vec3 ring_center = vec3(0.0, 0.0, 0.0);
+uniform vec3 ring_normal = vec3(0.0, 0.0, 1.0);
+uniform float ring_radius_interior = 0.0;
+uniform float ring_radius_exterior = 0.0;
+uniform float ring_opacity = 0.0;
+
+const float pi = 3.14159265;
+
+float sphere_visibility(vec3 p, vec4 occluder)
+{
+    vec3 to_light = light-p;
+    vec3 to_occluder = occluder.xyz-p;
+    float d_light = length(to_light);
+    float d_occluder = length(to_occluder);
+    if(d_occluder>=d_light)
+        return 1.0;
+
+    float a_light = light_radius/d_light;
+    float a_occluder = occluder.w/d_occluder;
+    float separation = acos(clamp(dot(to_light,to_occluder)/(d_light*d_occluder), -1.0, 1.0));
+
+    float covered = min(1.0, (a_occluder*a_occluder)/(a_light*a_light));
+    return 1.0 - covered*(1.0-smoothstep(abs(a_light-a_occluder), a_light+a_occluder, separation));
+}
+
+float ring_visibility(vec3 p)
+{
+    if(ring_opacity<=0.0)
+        return 1.0;
+    vec3 to_light = light-p;
+    float t = dot(ring_center-p, ring_normal)/dot(to_light, ring_normal);
+    if(!(t>0.0 && t<1.0))
+        return 1.0;
+    float r = length(p+t*to_light-ring_center);
+    return (r>ring_radius_interior && r<ring_radius_exterior) ? 1.0-ring_opacity : 1.0;
+}
+
+void main()
+{
+    // Ray from the camera through the current fragment
+    vec3 ray = normalize(fragment.position.xyz-camera_position);
+    vec3 oc = camera_position-sphere.xyz;
+    float b = dot(oc,ray);
+    float c = dot(oc,oc)-sphere.w*sphere.w;
+    float h = b*b-c;
+    if(h<0.0)
+        discard;
+
+    // First intersection with the sphere: exact position, normal and depth
+    vec3 p = camera_position + (-b-sqrt(h))*ray;
+    vec3 n = (p-sphere.xyz)/sphere.w;
+
+    // The depth of the sphere replaces the one of the billboard, in both depth modes
+    vec4 p_clip = perspective * view * vec4(p,1.0);
+#ifdef LOG_DEPTH
+    gl_FragDepth = 0.5*depth_log_coefficient*log2(1.0+p_clip.w);
+#else
+    gl_FragDepth = 0.5*(p_clip.z/p_clip.w) + 0.5;
+#endif
+
+    // Texture coordinates following mesh_primitive_sphere parameterization: (theta/pi, phi/(2pi))
+    vec3 q = transpose(sphere_rotation)*n;
+    float theta = acos(clamp(q.z,-1.0,1.0))/pi;
+    float phi = atan(q.y,q.x)/(2.0*pi);
+    float phi0 = fract(phi);           // discontinuous at phi=0
+    float phi1 = fract(phi+0.5)-0.5;   // discontinuous at phi=1/2
+    // Derivatives from the continuous parameterization to avoid sampling artifacts along the seam
+    vec2 dx = vec2(dFdx(theta), abs(dFdx(phi0))<abs(dFdx(phi1)) ? dFdx(phi0) : dFdx(phi1));
+    vec2 dy = vec2(dFdy(theta), abs(dFdy(phi0))<abs(dFdy(phi1)) ? dFdy(phi0) : dFdy(phi1));
+    vec4 color_texture = textureGrad(texture_sampler, vec3(theta, phi0, fragment_shading.w), dx, dy);
+
+    // Same illumination model as the instanced meshes
+    float ambiant  = fragment_shading.x;
+    float diffuse  = fragment_shading.y;
+    float specular = fragment_shading.z;
+
+    float diffuse_value  = 0.0;
+    float specular_value = 0.0;
+    // The sun is unlit: the branch is coherent over each instance
+#ifdef NO_SPECULAR
+    if(diffuse>0.0)
+#else
+    if(diffuse>0.0 || specular>0.0)
+#endif
+    {
+        vec3 u = normalize(light-p);
+
+        float shadow = ring_visibility(p);
+        if(fragment_occluders.x>=0)
+            shadow *= sphere_visibility(p, occluders[fragment_occluders.x]);
+        if(fragment_occluders.y>=0)
+            shadow *= sphere_visibility(p, occluders[fragment_occluders.y]);
+
+        diffuse_value  = shadow * diffuse * clamp( dot(u,n), 0.0, 1.0);
+#ifndef NO_SPECULAR
+        vec3 r = reflect(u,n);
+        vec3 t = normalize(p-camera_position);
+        specular_value = shadow * specular * pow( clamp( dot(r,t), 0.0, 1.0), specular_exponent);
+#endif
+    }
+
+    vec3 white = vec3(1.0);
+    vec3 c_out = (ambiant+diffuse_value)*color.rgb*color_texture.rgb + specular_value*white;
+
+    FragColor = vec4(c_out, color_texture.a*color_alpha);
+}
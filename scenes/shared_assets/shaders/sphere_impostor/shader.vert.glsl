@@ -0,0 +1,56 @@
+#version 330 core
+
+// Camera facing quad covering the silhouette of a sphere, the sphere itself is ray-traced in the fragment shader
+layout (location = 0) in vec4 position; // quad corners in [-1,1]^2
+
+// per-instance sphere parameters (same layout as the instanced meshes)
+layout (location = 4) in vec3 rotation_row0;
+layout (location = 5) in vec3 rotation_row1;
+layout (location = 6) in vec3 rotation_row2;
+layout (location = 7) in vec4 translation_scaling; // (center, radius)
+layout (location = 8) in vec4 shading_layer;       // (ambiant, diffuse, specular, texture layer)
+layout (location = 10) in vec2 occluder_indices;   // shadow casting spheres, -1 if none
+
+out struct fragment_data
+{
+    vec4 position;
+} fragment;
+
+flat out vec4 sphere;           // (center, radius)
+flat out mat3 sphere_rotation;
+flat out vec4 fragment_shading; // (ambiant, diffuse, specular, texture layer)
+flat out ivec2 fragment_occluders;
+
+
+uniform vec3 camera_position;
+// view transform
+uniform mat4 view;
+// perspective matrix
+uniform mat4 perspective;
+
+
+void main()
+{
+    vec3 center = translation_scaling.xyz;
+    float radius = translation_scaling.w;
+
+    // Frame facing the camera
+    vec3 to_camera = camera_position-center;
+    float d = length(to_camera);
+    vec3 w = to_camera/d;
+    vec3 up = abs(w.z)<0.999 ? vec3(0.0,0.0,1.0) : vec3(0.0,1.0,0.0);
+    vec3 u = normalize(cross(up,w));
+    vec3 v = cross(w,u);
+
+    // The quad is placed in the plane of the center: its size is enlarged to cover the silhouette seen in perspective
+    float s = radius * d / sqrt(max(d*d-radius*radius, 1e-12));
+    vec3 p = center + s*(position.x*u + position.y*v);
+
+    sphere = translation_scaling;
+    sphere_rotation = transpose(mat3(rotation_row0, rotation_row1, rotation_row2));
+    fragment_shading = shading_layer;
+    fragment_occluders = ivec2(occluder_indices);
+
+    fragment.position = vec4(p,1.0);
+    gl_Position = perspective * view * vec4(p,1.0);
+}
@@ -0,0 +1,44 @@
+#version 330 core
+
+// Feedback of the virtual textures (see virtual_texture_system): page needed by each pixel.
+// Used with the INSTANCED and VIRTUAL_TEXTURE variant of the mesh vertex shader.
+
+in struct fragment_data
+{
+    vec4 position;
+    vec4 normal;
+    vec4 color;
+    vec3 texture_uvw;
+    vec3 barycentric;
+} fragment;
+
+flat in int fragment_virtual_texture; // -1 if none
+
+layout (location = 0) out uvec4 feedback; // (page x, page y, level, virtual texture+1), 0 if no virtual texture
+
+uniform ivec2 virtual_size;
+uniform int virtual_levels;
+uniform int tile_size;
+uniform float feedback_level_bias = 0.0; // the framebuffer is smaller than the viewport: larger derivatives
+
+#ifdef LOG_DEPTH
+// logarithmic depth (see perspective_structure)
+uniform float depth_log_coefficient = 0.0;
+#endif
+
+void main()
+{
+    // Same level as the mesh shader (finest of the two filtered levels)
+    vec2 texel = fragment.texture_uvw.xy*vec2(virtual_size);
+    float level = 0.5*log2(max(dot(dFdx(texel),dFdx(texel)), dot(dFdy(texel),dFdy(texel)))) + feedback_level_bias;
+    int l = int(clamp(level, 0.0, float(virtual_levels-1)));
+
+    ivec2 size = max(virtual_size>>l, ivec2(1));
+    vec2 uv = clamp(fragment.texture_uvw.xy, 0.0, 1.0);
+    ivec2 page = clamp(ivec2(uv*vec2(size))/tile_size, ivec2(0), (size+tile_size-1)/tile_size-1);
+    feedback = fragment_virtual_texture>=0 ? uvec4(page, l, fragment_virtual_texture+1) : uvec4(0u);
+
+#ifdef LOG_DEPTH
+    gl_FragDepth = 0.5*depth_log_coefficient*log2(1.0+1.0/gl_FragCoord.w);
+#endif
+}
@@ -0,0 +1,199 @@
+#include "asset_pack.hpp"
+
+#include "vcl/base/file/file.hpp"
+#include "vcl/base/file_mapping/file_mapping.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace vcl
+{
+
+static const char asset_pack_magic[8] = {'v','c','l','p','a','c','k','1'};
+
+struct asset_pack_header
+{
+    char magic[8];
+    uint32_t number_entries;
+    uint32_t names_size;
+};
+
+struct asset_pack_entry
+{
+    uint64_t offset; // from the beginning of the pack
+    uint64_t size;
+    uint32_t name_offset; // in the names
+    uint32_t name_size;
+};
+
+// Mounted pack: the index is used in place in the mapping
+static file_mapping pack;
+static const asset_pack_entry* pack_entries = nullptr;
+static const char* pack_names = nullptr;
+static uint32_t pack_number_entries = 0;
+
+// Path as stored in the pack: '/' separators, without leading "./"
+static std::string asset_name(const std::string& filename)
+{
+    std::string name = filename;
+    std::replace(name.begin(), name.end(), '\\', '/');
+    while(name.compare(0, 2, "./")==0)
+        name.erase(0, 2);
+    return name;
+}
+
+static size_t align_offset(size_t offset)
+{
+    return (offset+asset_pack_alignment-1)/asset_pack_alignment*asset_pack_alignment;
+}
+
+bool asset_pack_build(const std::string& pack_filename, const std::vector<std::string>& directories)
+{
+    // The files are read from the disk, not from a previous pack
+    asset_pack_unmount();
+
+    std::vector<std::string> names;
+    for(const std::string& directory : directories) {
+        for(const std::string& filename : list_files(directory)) {
+            const std::string name = asset_name(filename);
+            const bool program = name.size()>=8 && name.compare(name.size()-8, 8, ".program")==0;
+            if(!program && name!=asset_name(pack_filename))
+                names.push_back(name);
+        }
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+
+    std::vector<file_mapping> files(names.size());
+    std::vector<asset_pack_entry> entries(names.size());
+    std::string names_data;
+    for(size_t k=0; k<names.size(); ++k) {
+        if(!files[k].open(names[k])) {
+            std::cerr<<"Cannot read "<<names[k]<<" for the asset pack"<<std::endl;
+            return false;
+        }
+        entries[k].name_offset = uint32_t(names_data.size());
+        entries[k].name_size = uint32_t(names[k].size());
+        entries[k].size = files[k].size();
+        names_data += names[k];
+    }
+
+    size_t offset = align_offset(sizeof(asset_pack_header) + entries.size()*sizeof(asset_pack_entry) + names_data.size());
+    for(asset_pack_entry& entry : entries) {
+        entry.offset = offset;
+        offset = align_offset(offset + size_t(entry.size));
+    }
+
+    asset_pack_header header;
+    std::memcpy(header.magic, asset_pack_magic, 8);
+    header.number_entries = uint32_t(entries.size());
+    header.names_size = uint32_t(names_data.size());
+
+    std::ofstream stream(pack_filename, std::ios::binary);
+    if(!stream.is_open()) {
+        std::cerr<<"Cannot write the asset pack "<<pack_filename<<std::endl;
+        return false;
+    }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if(!entries.empty())
+        stream.write(reinterpret_cast<const char*>(&entries[0]), std::streamsize(entries.size()*sizeof(asset_pack_entry)));
+    stream.write(names_data.data(), std::streamsize(names_data.size()));
+
+    const char padding[asset_pack_alignment] = {};
+    size_t position = sizeof(asset_pack_header) + entries.size()*sizeof(asset_pack_entry) + names_data.size();
+    for(size_t k=0; k<entries.size(); ++k) {
+        stream.write(padding, std::streamsize(entries[k].offset-position));
+        if(files[k].size()>0)
+            stream.write(reinterpret_cast<const char*>(files[k].data()), std::streamsize(files[k].size()));
+        position = size_t(entries[k].offset + entries[k].size);
+        files[k].close();
+    }
+    stream.write(padding, std::streamsize(offset-position));
+    stream.close();
+    if(!stream) {
+        std::cerr<<"Cannot write the asset pack "<<pack_filename<<std::endl;
+        return false;
+    }
+
+    std::cout<<"Asset pack "<<pack_filename<<": "<<entries.size()<<" files, "<<offset/1024<<" KB"<<std::endl;
+    return true;
+}
+
+bool asset_pack_mount(const std::string& pack_filename)
+{
+    asset_pack_unmount();
+    if(!pack.open(pack_filename)) {
+        std::cerr<<"Cannot open the asset pack "<<pack_filename<<std::endl;
+        return false;
+    }
+
+    // Check the whole index once: the lookups then trust it
+    const unsigned char* const data = pack.data();
+    const size_t size = pack.size();
+    bool valid = size>=sizeof(asset_pack_header) && std::memcmp(data, asset_pack_magic, 8)==0;
+    asset_pack_header header;
+    if(valid) {
+        std::memcpy(&header, data, sizeof(header));
+        const size_t index_end = sizeof(asset_pack_header) + size_t(header.number_entries)*sizeof(asset_pack_entry);
+        valid = index_end + header.names_size <= size;
+        for(uint32_t k=0; valid && k<header.number_entries; ++k) {
+            asset_pack_entry entry;
+            std::memcpy(&entry, data + sizeof(asset_pack_header) + k*sizeof(asset_pack_entry), sizeof(entry));
+            valid = uint64_t(entry.name_offset)+entry.name_size <= header.names_size && entry.offset<=size && entry.size<=size-entry.offset;
+        }
+    }
+    if(!valid) {
+        std::cerr<<"Invalid asset pack "<<pack_filename<<std::endl;
+        pack.close();
+        return false;
+    }
+
+    pack_entries = reinterpret_cast<const asset_pack_entry*>(data + sizeof(asset_pack_header));
+    pack_names = reinterpret_cast<const char*>(data + sizeof(asset_pack_header) + size_t(header.number_entries)*sizeof(asset_pack_entry));
+    pack_number_entries = header.number_entries;
+    std::cout<<"Mount asset pack "<<pack_filename<<" ("<<pack_number_entries<<" files)"<<std::endl;
+    return true;
+}
+
+void asset_pack_unmount()
+{
+    pack_entries = nullptr;
+    pack_names = nullptr;
+    pack_number_entries = 0;
+    pack.close();
+}
+
+bool asset_pack_mounted()
+{
+    return pack_entries!=nullptr;
+}
+
+bool asset_pack_find(const std::string& filename, asset_view& view)
+{
+    if(pack_entries==nullptr)
+        return false;
+
+    // Binary search in the index sorted by name
+    const std::string name = asset_name(filename);
+    uint32_t first = 0, last = pack_number_entries;
+    while(first<last) {
+        const uint32_t middle = first + (last-first)/2;
+        const asset_pack_entry& entry = pack_entries[middle];
+        const int comparison = name.compare(0, std::string::npos, pack_names+entry.name_offset, entry.name_size);
+        if(comparison==0) {
+            view.data = pack.data() + entry.offset;
+            view.size = size_t(entry.size);
+            return true;
+        }
+        if(comparison<0)
+            last = middle;
+        else
+            first = middle+1;
+    }
+    return false;
+}
+
+}
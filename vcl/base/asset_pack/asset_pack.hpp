@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace vcl
+{
+
+/** Single file archive of the assets (shaders, png images, cached compressed textures and page files, meshes), memory mapped once.
+ *
+ * Layout: header (magic "vclpack1", number of entries, size of the names), index of the entries sorted by name
+ *  (offset, size, name offset, name size), names, then the content of each file aligned on asset_pack_alignment bytes.
+ * A file is identified by its path at packing time, relative to the working directory (ex. "scenes/shared_assets/shaders/mesh/shader.vert.glsl").
+ *
+ * Once a pack is mounted, assert_file_exist, read_file_text, file_size, file_mapping::open and image_load_png look in it first,
+ * and fall back to the file system for the files it does not contain: the program no longer needs to run from the root directory.
+ * The caches missing from the pack (ex. a pack built before the procedural textures were generated) are then written to,
+ * and read from, the cache directory (see set_cache_directory).
+ * file_mapping::open returns a view of the pack without copy, valid until asset_pack_unmount.
+ * Mount and unmount before and after the loadings: the lookup itself can be called from several threads. */
+
+static const size_t asset_pack_alignment = 64;
+
+/** Content of a packed file */
+struct asset_view
+{
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+};
+
+/** Write a pack containing all the files of the directories (recursively), return false if it cannot be written.
+ * Shader program binaries (*.program) are skipped: they depend on the driver. */
+bool asset_pack_build(const std::string& pack_filename, const std::vector<std::string>& directories);
+
+/** Map a pack and use it for the following loadings (replace the previous one), return false if it cannot be opened or is invalid */
+bool asset_pack_mount(const std::string& pack_filename);
+void asset_pack_unmount();
+bool asset_pack_mounted();
+
+/** Look for a file in the mounted pack, return false if there is none or it does not contain the file */
+bool asset_pack_find(const std::string& filename, asset_view& view);
+
+}
@@ -5,7 +5,10 @@
 #include "types/types.hpp"
 #include "string/string.hpp"
 #include "file/file.hpp"
+#include "file_mapping/file_mapping.hpp"
+#include "asset_pack/asset_pack.hpp"
 #include "rand/rand.hpp"
 #include "error/error.hpp"
+#include "thread_pool/thread_pool.hpp"
 
 
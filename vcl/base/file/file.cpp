@@ -2,17 +2,43 @@
 
 #include <fstream>
 #include <iostream>
+#include <algorithm>
 #include <cassert>
 
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
 #include "../error/error.hpp"
+#include "../asset_pack/asset_pack.hpp"
 
 namespace vcl
 {
 
+static std::string& cache_directory()
+{
+    static std::string directory;
+    return directory;
+}
+
+static bool is_file(const std::string& path)
+{
+    return std::ifstream(path).is_open();
+}
+
 void assert_file_exist(const std::string& filename)
 {
+    asset_view view;
+    if( asset_pack_find(filename, view) )
+        return;
+
     // Open file
-    std::ifstream stream(filename);
+    std::ifstream stream(file_path(filename));
 
     // Abort program if the file cannot be opened
     if( !stream.is_open() ) {
@@ -23,7 +49,8 @@ void assert_file_exist(const std::string& filename)
                 "       Reminder: The program is exprected to run form the root directory\n"
                 "       (In QtCreator: set projects/Run directory)\n"
                 "       (In Command Line: change the directory such that you can access the file)\n"
-                "       (In Windows: you need to copy the directory containing this data at the same place than your executable)";
+                "       (In Windows: you need to copy the directory containing this data at the same place than your executable)\n"
+                "       (Or pack the assets with --build-pack assets.pack and place the pack next to the executable)";
 
         error_vcl(msg);
     }
@@ -33,10 +60,14 @@ void assert_file_exist(const std::string& filename)
 
 std::string read_file_text(const std::string& path)
 {
+    asset_view view;
+    if( asset_pack_find(path, view) )
+        return std::string(reinterpret_cast<const char*>(view.data), view.size);
+
     assert_file_exist(path);
 
     // Open file with pointer at last position
-    std::ifstream stream(path, std::ios::ate);
+    std::ifstream stream(file_path(path), std::ios::ate);
     assert(stream.is_open());
 
     std::string full_text;
@@ -59,4 +90,118 @@ std::string read_file_text(const std::string& path)
 
 }
 
+uint64_t file_size(const std::string& filename)
+{
+    asset_view view;
+    if(asset_pack_find(filename, view))
+        return view.size;
+
+    std::ifstream stream(file_path(filename), std::ios::binary | std::ios::ate);
+    if(!stream.is_open())
+        return 0;
+    return static_cast<uint64_t>(stream.tellg());
+}
+
+static void list_files(const std::string& directory, std::vector<std::string>& files)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE handle = FindFirstFileA((directory+"/*").c_str(), &data);
+    if(handle==INVALID_HANDLE_VALUE)
+        return;
+    do {
+        const std::string name = data.cFileName;
+        if(name=="." || name=="..")
+            continue;
+        if(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            list_files(directory+"/"+name, files);
+        else
+            files.push_back(directory+"/"+name);
+    } while(FindNextFileA(handle, &data));
+    FindClose(handle);
+#else
+    DIR* const stream = opendir(directory.c_str());
+    if(stream==nullptr)
+        return;
+    while(const dirent* entry = readdir(stream)) {
+        const std::string name = entry->d_name;
+        if(name=="." || name=="..")
+            continue;
+        const std::string path = directory+"/"+name;
+        struct stat status;
+        if(stat(path.c_str(), &status)!=0)
+            continue;
+        if(S_ISDIR(status.st_mode))
+            list_files(path, files);
+        else if(S_ISREG(status.st_mode))
+            files.push_back(path);
+    }
+    closedir(stream);
+#endif
+}
+
+std::vector<std::string> list_files(const std::string& directory)
+{
+    std::vector<std::string> files;
+    list_files(directory, files);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+void set_cache_directory(const std::string& directory)
+{
+    std::string& current = cache_directory();
+    current = directory;
+    std::replace(current.begin(), current.end(), '\\', '/');
+    while(current.size()>1 && current.back()=='/')
+        current.pop_back();
+}
+
+static bool is_absolute(const std::string& path)
+{
+    return (!path.empty() && (path[0]=='/' || path[0]=='\\')) || (path.size()>1 && path[1]==':');
+}
+
+static void create_directory(const std::string& path)
+{
+#ifdef _WIN32
+    CreateDirectoryA(path.c_str(), nullptr);
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+static std::string cached_path(const std::string& filename)
+{
+    // Same relative path as the source, under the cache directory (absolute sources keep their caches next to them)
+    const std::string& directory = cache_directory();
+    if(directory.empty() || is_absolute(filename))
+        return std::string();
+    std::string name = filename;
+    std::replace(name.begin(), name.end(), '\\', '/');
+    while(name.compare(0, 2, "./")==0)
+        name.erase(0, 2);
+    return directory+"/"+name;
+}
+
+std::string cache_file(const std::string& filename)
+{
+    std::string path = cached_path(filename);
+    if(path.empty())
+        path = filename;
+
+    // Create the missing directories (the existing ones only fail to be created again)
+    for(size_t separator = path.find('/', 1); separator!=std::string::npos; separator = path.find('/', separator+1))
+        create_directory(path.substr(0, separator));
+    return path;
+}
+
+std::string file_path(const std::string& filename)
+{
+    if(cache_directory().empty() || is_file(filename))
+        return filename;
+    const std::string path = cached_path(filename);
+    return !path.empty() && is_file(path) ? path : filename;
+}
+
 }
@@ -1,10 +1,14 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
 namespace vcl
 {
 
+// The files of a mounted asset pack (see asset_pack) are found before the ones of the file system
+
 /** Ensure that a file already exists and is accessible
  * Display an error message with some reminder on path setting in case the file cannot be accessed */
 void assert_file_exist(const std::string& filename);
@@ -12,4 +16,21 @@ void assert_file_exist(const std::string& filename);
 /** Read a file given by its path and return its content as a string */
 std::string read_file_text(const std::string& filename);
 
+/** Size of a file in bytes, 0 if it cannot be opened */
+uint64_t file_size(const std::string& filename);
+
+/** Path of all the files in a directory and its sub-directories (on the file system only), sorted */
+std::vector<std::string> list_files(const std::string& directory);
+
+/** Directory where the caches derived from the assets are written (compressed textures, page files, procedural textures...).
+ * Empty by default: each cache is written next to its source. Set it when the sources are not writable (ex. read from an asset pack):
+ * the files found neither in the pack nor in the file system are then looked up in this directory as well. Set it before the loadings. */
+void set_cache_directory(const std::string& directory);
+
+/** Path where the cache filename is written: its place in the cache directory, or filename itself without cache directory (the missing directories are created) */
+std::string cache_file(const std::string& filename);
+
+/** Path of filename on the file system: filename itself if it exists, otherwise its place in the cache directory if the cache has it */
+std::string file_path(const std::string& filename);
+
 }
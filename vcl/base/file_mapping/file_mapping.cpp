@@ -0,0 +1,134 @@
+#include "file_mapping.hpp"
+
+#include "../asset_pack/asset_pack.hpp"
+#include "../file/file.hpp"
+
+#include <fstream>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define VCL_FILE_MAPPING_MMAP
+#endif
+
+namespace vcl
+{
+
+file_mapping::file_mapping()
+    :address(nullptr), length(0), mapped(false), packed(false), buffer()
+{}
+
+file_mapping::~file_mapping()
+{
+    close();
+}
+
+file_mapping::file_mapping(file_mapping&& other)
+    :address(other.address), length(other.length), mapped(other.mapped), packed(other.packed), buffer(std::move(other.buffer))
+{
+    other.address = nullptr;
+    other.length = 0;
+    other.mapped = false;
+    other.packed = false;
+}
+
+file_mapping& file_mapping::operator=(file_mapping&& other)
+{
+    if(this!=&other) {
+        close();
+        address = other.address;
+        length = other.length;
+        mapped = other.mapped;
+        packed = other.packed;
+        buffer = std::move(other.buffer);
+        other.address = nullptr;
+        other.length = 0;
+        other.mapped = false;
+        other.packed = false;
+    }
+    return *this;
+}
+
+bool file_mapping::open(const std::string& filename)
+{
+    close();
+
+    asset_view view;
+    if(asset_pack_find(filename, view)) {
+        address = view.data;
+        length = view.size;
+        packed = true;
+        return true;
+    }
+
+    // Then the file system, and the cache directory
+    const std::string path = file_path(filename);
+#ifdef VCL_FILE_MAPPING_MMAP
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if(descriptor<0)
+        return false;
+    struct stat status;
+    if(fstat(descriptor, &status)==0 && status.st_size>0) {
+        void* const view = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if(view!=MAP_FAILED) {
+            // The mapping remains valid once the descriptor is closed
+            ::close(descriptor);
+            address = static_cast<const unsigned char*>(view);
+            length = size_t(status.st_size);
+            mapped = true;
+            return true;
+        }
+    }
+    ::close(descriptor);
+#endif
+
+    // Without mmap (or for an empty file): read the whole file
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if(!stream.is_open())
+        return false;
+    buffer.resize(size_t(stream.tellg()));
+    stream.seekg(0);
+    if(!buffer.empty())
+        stream.read(reinterpret_cast<char*>(&buffer[0]), std::streamsize(buffer.size()));
+    if(!stream) {
+        buffer.clear();
+        return false;
+    }
+    address = buffer.empty() ? nullptr : &buffer[0];
+    length = buffer.size();
+    return true;
+}
+
+void file_mapping::close()
+{
+#ifdef VCL_FILE_MAPPING_MMAP
+    if(mapped)
+        munmap(const_cast<unsigned char*>(address), length);
+#endif
+    address = nullptr;
+    length = 0;
+    mapped = false;
+    packed = false;
+    buffer.clear();
+    buffer.shrink_to_fit();
+}
+
+bool file_mapping::is_open() const
+{
+    return mapped || packed || !buffer.empty();
+}
+
+const unsigned char* file_mapping::data() const
+{
+    return address;
+}
+
+size_t file_mapping::size() const
+{
+    return length;
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace vcl
+{
+
+/** Read-only view of the whole content of a file.
+ * The file is memory mapped on POSIX systems (the pages are only read from the disk when accessed), and read into memory otherwise.
+ * A file of the mounted asset pack is a view of the pack, without copy (see asset_pack). */
+struct file_mapping
+{
+    file_mapping();
+    ~file_mapping();
+    file_mapping(file_mapping&& other);
+    file_mapping& operator=(file_mapping&& other);
+    file_mapping(const file_mapping&) = delete;
+    file_mapping& operator=(const file_mapping&) = delete;
+
+    /** Map the file, return false if it cannot be opened */
+    bool open(const std::string& filename);
+    void close();
+
+    bool is_open() const;
+    const unsigned char* data() const;
+    size_t size() const;
+
+private:
+    const unsigned char* address;
+    size_t length;
+    bool mapped;                       // address comes from mmap
+    bool packed;                       // address is in the mounted asset pack (not owned)
+    std::vector<unsigned char> buffer; // content of the file without mmap
+};
+
+}
@@ -0,0 +1,92 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace vcl
+{
+
+thread_pool::thread_pool(unsigned int number_threads)
+    :workers(), jobs(), mutex(), job_available(), job_done(), running(0), stop(false)
+{
+    if(number_threads==0)
+        number_threads = std::max(1u, std::thread::hardware_concurrency());
+    for(unsigned int k=0; k<number_threads; ++k)
+        workers.push_back(std::thread(&thread_pool::work, this));
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    job_available.notify_all();
+    for(std::thread& worker : workers)
+        worker.join();
+}
+
+void thread_pool::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    job_available.notify_one();
+}
+
+void thread_pool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    job_done.wait(lock, [this]{ return jobs.empty() && running==0; });
+}
+
+void thread_pool::wait_pending(size_t count)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    job_done.wait(lock, [this, count]{ return jobs.size()+running<=count; });
+}
+
+void thread_pool::cancel()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    jobs.clear();
+    job_done.wait(lock, [this]{ return running==0; });
+}
+
+size_t thread_pool::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs.size()+running;
+}
+
+size_t thread_pool::size() const
+{
+    return workers.size();
+}
+
+void thread_pool::work()
+{
+    while(true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            job_available.wait(lock, [this]{ return stop || !jobs.empty(); });
+            if(jobs.empty()) // stop requested and no remaining job
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            running++;
+        }
+
+        job();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running--;
+        }
+        job_done.notify_all();
+    }
+}
+
+}
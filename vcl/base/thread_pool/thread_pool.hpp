@@ -0,0 +1,47 @@
+#pragma once
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+namespace vcl
+{
+
+/** Fixed set of worker threads executing jobs in their order of submission.
+ * The jobs must not call OpenGL: the context is only current on the main thread.
+ * The destructor waits for the remaining jobs. */
+struct thread_pool
+{
+    /** number_threads=0: one thread per hardware thread */
+    explicit thread_pool(unsigned int number_threads=0);
+    ~thread_pool();
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    void submit(std::function<void()> job);
+    /** Block until all the submitted jobs are done */
+    void wait();
+    /** Block until at most count jobs are pending: as the jobs start in order, the oldest ones are done first */
+    void wait_pending(size_t count);
+    /** Drop the jobs not started yet, then block until the running ones are done */
+    void cancel();
+    /** Number of jobs submitted and not yet done */
+    size_t pending() const;
+    size_t size() const;
+
+private:
+    void work();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()> > jobs;
+    mutable std::mutex mutex;
+    std::condition_variable job_available;
+    std::condition_variable job_done;
+    size_t running;
+    bool stop;
+};
+
+}
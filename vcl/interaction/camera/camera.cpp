@@ -6,13 +6,20 @@ namespace vcl
 {
 
 perspective_structure::perspective_structure()
-    :angle_of_view(50*3.14159f/180), image_aspect(1), z_near(0), z_far(1)
+    :angle_of_view(50*3.14159f/180), image_aspect(1), z_near(0), z_far(1), depth_mode(depth_buffer_mode::standard)
 {}
 
-perspective_structure::perspective_structure(float angle_of_view_arg, float image_aspect_arg, float z_near_arg, float z_far_arg)
-    :angle_of_view(angle_of_view_arg), image_aspect(image_aspect_arg), z_near(z_near_arg), z_far(z_far_arg)
+perspective_structure::perspective_structure(float angle_of_view_arg, float image_aspect_arg, float z_near_arg, float z_far_arg, depth_buffer_mode depth_mode_arg)
+    :angle_of_view(angle_of_view_arg), image_aspect(image_aspect_arg), z_near(z_near_arg), z_far(z_far_arg), depth_mode(depth_mode_arg)
 {}
 
+float perspective_structure::depth_log_coefficient() const
+{
+    if(depth_mode==depth_buffer_mode::standard)
+        return 0.0f;
+    return 2.0f/std::log2(1.0f+z_far);
+}
+
 mat4 perspective_structure::matrix() const
 {
     const float fy = 1/std::tan(angle_of_view/2);
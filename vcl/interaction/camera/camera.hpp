@@ -7,18 +7,29 @@
 namespace vcl
 {
 
+/** Depth stored in the depth buffer
+ * - standard: z/w given by the perspective matrix (precision concentrated close to the near plane)
+ * - logarithmic: log2(1+w)/log2(1+z_far) written by the fragment shaders, with a constant relative precision.
+ *   It allows a ratio z_far/z_near of several orders of magnitude, but all shaders drawing in the scene must write this depth
+ *   (LOG_DEPTH variants, see shader_log_depth). */
+enum class depth_buffer_mode {standard, logarithmic};
+
 struct perspective_structure
 {
     float angle_of_view;
     float image_aspect;
     float z_near;
     float z_far;
+    depth_buffer_mode depth_mode;
 
     perspective_structure();
-    perspective_structure(float angle_of_view, float image_aspect, float z_near, float z_far);
+    perspective_structure(float angle_of_view, float image_aspect, float z_near, float z_far, depth_buffer_mode depth_mode = depth_buffer_mode::standard);
 
     mat4 matrix() const;
     mat4 matrix_inverse() const;
+
+    /** Coefficient 2/log2(1+z_far) of the logarithmic depth sent to the shaders (0 for the standard depth) */
+    float depth_log_coefficient() const;
 };
 
 enum camera_control_type {camera_control_trackball, camera_control_spherical_coordinates};
@@ -0,0 +1,31 @@
+#include "camera_path.hpp"
+
+#include "vcl/base/base.hpp"
+
+#include <algorithm>
+
+namespace vcl
+{
+
+void camera_path::apply(camera_scene& camera, float t) const
+{
+    assert_vcl(!keyframes.empty(), "Empty camera path");
+
+    const size_t N = keyframes.size();
+    const float s = std::min(std::max(t,0.0f),1.0f) * float(N-1);
+    const size_t k0 = std::min(size_t(s), N-1);
+    const size_t k1 = std::min(k0+1, N-1);
+    const float alpha = s-float(k0);
+
+    const camera_keyframe& a = keyframes[k0];
+    const camera_keyframe& b = keyframes[k1];
+    const float theta = (1-alpha)*a.theta + alpha*b.theta;
+    const float phi   = (1-alpha)*a.phi   + alpha*b.phi;
+
+    // apply_rotation moves the spherical coordinates by (x0-x1, y1-y0)
+    camera.camera_type = camera_control_spherical_coordinates;
+    camera.apply_rotation(0, 0, camera.spherical_coordinates.x-theta, phi-camera.spherical_coordinates.y);
+    camera.scale = (1-alpha)*a.scale + alpha*b.scale;
+}
+
+}
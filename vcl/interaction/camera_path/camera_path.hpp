@@ -0,0 +1,28 @@
+#pragma once
+
+#include "vcl/interaction/camera/camera.hpp"
+
+#include <vector>
+
+namespace vcl
+{
+
+/** Key position of a camera in spherical coordinates (see camera_control_spherical_coordinates) */
+struct camera_keyframe
+{
+    float theta;
+    float phi;
+    float scale;
+};
+
+/** Scripted camera motion: the keyframes are linearly interpolated, and evenly spaced along the parameter t in [0,1].
+ * Used to render reproducible sequences of frames without user interaction (ex. headless benchmarks). */
+struct camera_path
+{
+    std::vector<camera_keyframe> keyframes;
+
+    /** Place the camera (in spherical coordinates mode) at the parameter t of the path */
+    void apply(camera_scene& camera, float t) const;
+};
+
+}
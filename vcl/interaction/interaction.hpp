@@ -1,6 +1,7 @@
 #pragma once
 
 #include "camera/camera.hpp"
+#include "camera_path/camera_path.hpp"
 #include "camera_control_glfw/camera_control_glfw.hpp"
 #include "time_slider/time_slider.hpp"
 #include "screen_motion/screen_motion.hpp"
@@ -0,0 +1,50 @@
+#include "bounding_sphere.hpp"
+
+#include "vcl/math/helper_functions/helper_functions.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vcl
+{
+
+bounding_sphere::bounding_sphere()
+    :center({0,0,0}), radius(0.0f)
+{}
+
+bounding_sphere::bounding_sphere(const vec3& center_arg, float radius_arg)
+    :center(center_arg), radius(radius_arg)
+{}
+
+bounding_sphere bounding_sphere_from_position(const buffer<vec3>& position)
+{
+    const size_t N = position.size();
+    if(N==0)
+        return bounding_sphere();
+
+    vec3 p_min = position[0];
+    vec3 p_max = position[0];
+    for(size_t k=1; k<N; ++k) {
+        const vec3& p = position[k];
+        p_min = {std::min(p_min.x,p.x), std::min(p_min.y,p.y), std::min(p_min.z,p.z)};
+        p_max = {std::max(p_max.x,p.x), std::max(p_max.y,p.y), std::max(p_max.z,p.z)};
+    }
+
+    const vec3 center = (p_min+p_max)/2.0f;
+    float radius = 0.0f;
+    for(size_t k=0; k<N; ++k)
+        radius = std::max(radius, norm(position[k]-center));
+
+    return {center, radius};
+}
+
+bounding_sphere transform(const bounding_sphere& sphere, const affine_transform& T)
+{
+    const vec3& s = T.scaling_axis;
+    const float scaling_max = T.scaling * std::max(std::abs(s.x), std::max(std::abs(s.y), std::abs(s.z)));
+
+    const vec3 center = T.rotation*(T.scaling*(s*sphere.center)) + T.translation;
+    return {center, sphere.radius*std::abs(scaling_max)};
+}
+
+}
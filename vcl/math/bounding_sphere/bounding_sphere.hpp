@@ -0,0 +1,29 @@
+#pragma once
+
+#include "vcl/math/vec/vec.hpp"
+#include "vcl/math/transformation/affine_transform/affine_transform.hpp"
+#include "vcl/containers/buffer/buffer.hpp"
+
+namespace vcl
+{
+
+/** \brief Sphere enclosing a shape, used for visibility tests
+ * \ingroup math */
+struct bounding_sphere
+{
+    bounding_sphere();
+    bounding_sphere(const vec3& center, float radius);
+
+    vec3 center;
+    float radius;
+};
+
+/** Sphere enclosing a set of positions (centered on their bounding box)
+ * \relates bounding_sphere */
+bounding_sphere bounding_sphere_from_position(const buffer<vec3>& position);
+
+/** Apply the affine transform to the sphere. Anisotropic scaling is bounded by its largest component.
+ * \relates bounding_sphere */
+bounding_sphere transform(const bounding_sphere& sphere, const affine_transform& T);
+
+}
@@ -0,0 +1,94 @@
+#include "frustum.hpp"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=1)
+#define VCL_FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace vcl
+{
+
+frustum frustum_from_matrix(const mat4& M)
+{
+    const vec4 r0 = M.row(0);
+    const vec4 r1 = M.row(1);
+    const vec4 r2 = M.row(2);
+    const vec4 r3 = M.row(3);
+
+    frustum f;
+    f.planes[0] = r3+r0; // left
+    f.planes[1] = r3-r0; // right
+    f.planes[2] = r3+r1; // bottom
+    f.planes[3] = r3-r1; // top
+    f.planes[4] = r3+r2; // near
+    f.planes[5] = r3-r2; // far
+
+    for(vec4& p : f.planes) {
+        const float n = std::sqrt(p.x*p.x+p.y*p.y+p.z*p.z);
+        if(n>0)
+            p = p/n;
+    }
+    return f;
+}
+
+bool is_visible(const frustum& f, const bounding_sphere& sphere)
+{
+    const vec3& c = sphere.center;
+    for(const vec4& p : f.planes)
+        if( p.x*c.x+p.y*c.y+p.z*c.z+p.w < -sphere.radius )
+            return false;
+    return true;
+}
+
+static void frustum_test_scalar(const frustum& f, const float* x, const float* y, const float* z, const float* radius, size_t k0, size_t N, unsigned char* visible)
+{
+    for(size_t k=k0; k<N; ++k) {
+        unsigned char inside = 1;
+        for(const vec4& p : f.planes)
+            inside &= static_cast<unsigned char>( p.x*x[k]+p.y*y[k]+p.z*z[k]+p.w >= -radius[k] );
+        visible[k] = inside;
+    }
+}
+
+void frustum_test(const frustum& f, const float* x, const float* y, const float* z, const float* radius, size_t N, unsigned char* visible)
+{
+    size_t k0 = 0;
+
+#ifdef VCL_FRUSTUM_SSE
+    __m128 px[6], py[6], pz[6], pw[6];
+    for(int i=0; i<6; ++i) {
+        px[i] = _mm_set1_ps(f.planes[i].x);
+        py[i] = _mm_set1_ps(f.planes[i].y);
+        pz[i] = _mm_set1_ps(f.planes[i].z);
+        pw[i] = _mm_set1_ps(f.planes[i].w);
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    for(; k0+4<=N; k0+=4) {
+        const __m128 cx = _mm_loadu_ps(x+k0);
+        const __m128 cy = _mm_loadu_ps(y+k0);
+        const __m128 cz = _mm_loadu_ps(z+k0);
+        const __m128 minus_r = _mm_sub_ps(zero, _mm_loadu_ps(radius+k0));
+
+        // Signed distance to each plane, compared to -radius
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+        for(int i=0; i<6; ++i) {
+            const __m128 d = _mm_add_ps( _mm_add_ps(_mm_mul_ps(px[i],cx), _mm_mul_ps(py[i],cy)), _mm_add_ps(_mm_mul_ps(pz[i],cz), pw[i]) );
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, minus_r));
+        }
+
+        const int mask = _mm_movemask_ps(inside);
+        visible[k0  ] = static_cast<unsigned char>( mask     & 1);
+        visible[k0+1] = static_cast<unsigned char>((mask>>1) & 1);
+        visible[k0+2] = static_cast<unsigned char>((mask>>2) & 1);
+        visible[k0+3] = static_cast<unsigned char>((mask>>3) & 1);
+    }
+#endif
+
+    // Remaining spheres (or all of them without SSE)
+    frustum_test_scalar(f, x, y, z, radius, k0, N, visible);
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "vcl/math/vec/vec.hpp"
+#include "vcl/math/mat/mat.hpp"
+#include "vcl/math/bounding_sphere/bounding_sphere.hpp"
+
+#include <cstddef>
+
+namespace vcl
+{
+
+/** \brief View frustum stored as 6 planes (left, right, bottom, top, near, far).
+ * Each plane (a,b,c,d) is normalized, with the normal (a,b,c) pointing inside: a point p is inside when a*p.x+b*p.y+c*p.z+d >= 0.
+ * \ingroup math */
+struct frustum
+{
+    vec4 planes[6];
+};
+
+/** Extract the frustum planes from a projection*view matrix
+ * \relates frustum */
+frustum frustum_from_matrix(const mat4& projection_view);
+
+/** Check if a sphere intersects the frustum (conservative test: spheres near the corners may be kept)
+ * \relates frustum */
+bool is_visible(const frustum& f, const bounding_sphere& sphere);
+
+/** Test N spheres given as a structure of arrays (x,y,z,radius) against the frustum.
+ * visible[k] is set to 1 if the sphere k intersects the frustum, 0 otherwise.
+ * Four spheres are processed at once when SSE is available.
+ * \relates frustum */
+void frustum_test(const frustum& f, const float* x, const float* y, const float* z, const float* radius, size_t N, unsigned char* visible);
+
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace vcl
+{
+
+/** \f$\pi\f$ in single precision
+ * \ingroup math */
+constexpr float pi = 3.14159265358979f;
+
+}
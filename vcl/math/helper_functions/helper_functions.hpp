@@ -1,4 +1,5 @@
 #pragma once
 
+#include "constants/constants.hpp"
 #include "linspace/linspace.hpp"
 #include "norm/norm.hpp"
@@ -11,7 +11,7 @@ namespace vcl
 /** \relates buffer_stack \ingroup math */
 template <size_t N> float dot(buffer_stack<float,N> const& a, buffer_stack<float,N> const& b);
 /** \relates buffer_stack */
-template <size_t N> float dot(buffer_stack<double,N> const& a, buffer_stack<double,N> const& b);
+template <size_t N> double dot(buffer_stack<double,N> const& a, buffer_stack<double,N> const& b);
 ///@}
 
 /** \name Norm
@@ -59,7 +59,7 @@ template <size_t N> float norm(const buffer_stack<float,N>& v)
 {
     return std::sqrt(dot(v,v));
 }
-template <size_t N> float norm(const buffer_stack<double,N>& v)
+template <size_t N> double norm(const buffer_stack<double,N>& v)
 {
     return std::sqrt(dot(v,v));
 }
@@ -88,7 +88,8 @@ template <size_t N> buffer_stack<double,N> normalize(buffer_stack<double,N> cons
     if(n==0)
         u[0]=1;
     else
-        u = v/n;
+        for(size_t k=0; k<N; ++k)
+            u[k] = v[k]/n;
     return u;
 }
 #ifdef __linux__
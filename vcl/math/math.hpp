@@ -4,6 +4,8 @@
 #include "mat/mat.hpp"
 #include "transformation/transformation.hpp"
 #include "helper_functions/helper_functions.hpp"
+#include "bounding_sphere/bounding_sphere.hpp"
+#include "frustum/frustum.hpp"
 
 /** @defgroup math Mathematical structures and functions
  *  \brief Basic mathematical objects: vec, mat, transformations
@@ -0,0 +1,24 @@
+#include "dvec3.hpp"
+
+namespace vcl {
+
+dvec3 make_dvec3(double x, double y, double z)
+{
+    dvec3 p;
+    p[0] = x;
+    p[1] = y;
+    p[2] = z;
+    return p;
+}
+
+dvec3 to_dvec3(const vec3& p)
+{
+    return make_dvec3(p.x, p.y, p.z);
+}
+
+vec3 to_vec3(const dvec3& p)
+{
+    return {float(p[0]), float(p[1]), float(p[2])};
+}
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "vcl/math/vec/vec3/vec3.hpp"
+
+namespace vcl {
+
+/** dvec3 is an alias on a generic buffer_stack<double, 3>.
+ * It stores large coordinates (world positions at astronomical scale) in double precision on the CPU.
+ * The GPU only receives vec3 expressed relatively to a close origin (see floating_origin).
+ * \ingroup math
+*/
+using dvec3 = buffer_stack<double, 3>;
+
+/** Build a dvec3 from its coordinates */
+dvec3 make_dvec3(double x, double y, double z);
+
+/** Conversion between the float and double precision coordinates */
+dvec3 to_dvec3(const vec3& p);
+vec3 to_vec3(const dvec3& p);
+
+}
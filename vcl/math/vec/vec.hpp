@@ -4,3 +4,4 @@
 #include "vec2/vec2.hpp"
 #include "vec3/vec3.hpp"
 #include "vec4/vec4.hpp"
+#include "dvec3/dvec3.hpp"
@@ -2,6 +2,7 @@
 
 #include "debug/opengl_debug.hpp"
 #include "shader/shader.hpp"
+#include "shader_cache/shader_cache.hpp"
 #include "uniform/uniform.hpp"
 #include "texture/texture.hpp"
 
@@ -1,8 +1,10 @@
 #include "shader.hpp"
 
 #include "vcl/base/base.hpp"
+#include "vcl/opengl/shader_cache/shader_cache.hpp"
 
 #include <vector>
+#include <map>
 #include <iostream>
 #include <cassert>
 
@@ -79,15 +81,35 @@ GLuint compile_shader(const std::string& shader_str, const GLenum shader_type)
 }
 
 
-GLuint create_shader_program(const std::string& vertex_shader_path, const std::string& fragment_shader_path)
+static std::string insert_defines(const std::string& shader_str, const std::vector<std::string>& defines)
 {
-    const std::string vertex_shader_str   = read_file_text(vertex_shader_path);
-    const std::string fragment_shader_str = read_file_text(fragment_shader_path);
+    // The #version directive must remain the first line
+    std::string defines_str;
+    for(const std::string& name : defines)
+        defines_str += "#define "+name+"\n";
+
+    const size_t version = shader_str.find("#version");
+    const size_t line_end = version==std::string::npos ? std::string::npos : shader_str.find('\n', version);
+    if(line_end==std::string::npos)
+        return defines_str+shader_str;
+    return shader_str.substr(0,line_end+1) + defines_str + shader_str.substr(line_end+1);
+}
+
+/** Link the program from its sources (geometry shader is optional), or load it from the cache file if it was stored from the same sources and driver */
+static GLuint link_shader_program(const std::string& vertex_shader_str, const std::string& geometry_shader_str, const std::string& fragment_shader_str, const std::string& cache_path)
+{
+    const uint64_t key = shader_cache_key({vertex_shader_str, geometry_shader_str, fragment_shader_str});
+    const GLuint cached_program = shader_cache_load(cache_path, key);
+    if(cached_program!=0)
+        return cached_program;
 
+    const bool has_geometry = !geometry_shader_str.empty();
     const GLuint vertex_shader   = compile_shader(vertex_shader_str, GL_VERTEX_SHADER);
+    const GLuint geometry_shader = has_geometry ? compile_shader(geometry_shader_str, GL_GEOMETRY_SHADER) : 0;
     const GLuint fragment_shader = compile_shader(fragment_shader_str, GL_FRAGMENT_SHADER);
 
     assert( glIsShader(vertex_shader) );
+    assert( !has_geometry || glIsShader(geometry_shader) );
     assert( glIsShader(fragment_shader) );
 
     // Create Program
@@ -96,55 +118,80 @@ GLuint create_shader_program(const std::string& vertex_shader_path, const std::s
 
     // Attach Shader to Program
     glAttachShader( program, vertex_shader );
+    if(has_geometry)
+        glAttachShader( program, geometry_shader );
     glAttachShader( program, fragment_shader );
 
     // Link Program
+    shader_cache_prepare( program );
     glLinkProgram( program );
 
     check_link(vertex_shader, fragment_shader, program);
 
     // Shader can be detached.
     glDetachShader( program, vertex_shader);
+    if(has_geometry)
+        glDetachShader( program, geometry_shader);
     glDetachShader( program, fragment_shader);
 
+    shader_cache_store(program, cache_path, key);
 
     return program;
 }
 
+/** One cache file for each combination of shader files and defines */
+static std::string shader_cache_path(const std::string& vertex_shader_path, const std::string& geometry_shader_path, const std::string& fragment_shader_path, const std::vector<std::string>& defines)
+{
+    std::vector<std::string> names = {vertex_shader_path, geometry_shader_path, fragment_shader_path};
+    names.insert(names.end(), defines.begin(), defines.end());
+    return shader_cache_file(names);
+}
+
+GLuint create_shader_program(const std::string& vertex_shader_path, const std::string& fragment_shader_path)
+{
+    return create_shader_program(vertex_shader_path, fragment_shader_path, std::vector<std::string>());
+}
+
+GLuint create_shader_program(const std::string& vertex_shader_path, const std::string& fragment_shader_path, const std::vector<std::string>& defines)
+{
+    const std::string vertex_shader_str   = insert_defines(read_file_text(vertex_shader_path), defines);
+    const std::string fragment_shader_str = insert_defines(read_file_text(fragment_shader_path), defines);
+    return link_shader_program(vertex_shader_str, "", fragment_shader_str, shader_cache_path(vertex_shader_path, "", fragment_shader_path, defines));
+}
+
 GLuint create_shader_program(const std::string& vertex_shader_path, const std::string& geometry_shader_path, const std::string& fragment_shader_path)
 {
     const std::string vertex_shader_str   = read_file_text(vertex_shader_path);
     const std::string geometry_shader_str = read_file_text(geometry_shader_path);
     const std::string fragment_shader_str = read_file_text(fragment_shader_path);
+    return link_shader_program(vertex_shader_str, geometry_shader_str, fragment_shader_str, shader_cache_path(vertex_shader_path, geometry_shader_path, fragment_shader_path, {}));
+}
 
-    const GLuint vertex_shader   = compile_shader(vertex_shader_str, GL_VERTEX_SHADER);
-    const GLuint geometry_shader = compile_shader(geometry_shader_str, GL_GEOMETRY_SHADER);
-    const GLuint fragment_shader = compile_shader(fragment_shader_str, GL_FRAGMENT_SHADER);
-
-    assert( glIsShader(vertex_shader) );
-    assert( glIsShader(geometry_shader) );
-    assert( glIsShader(fragment_shader) );
-
-    // Create Program
-    const GLuint program = glCreateProgram();
-    assert( glIsProgram(program) );
-
-    // Attach Shader to Program
-    glAttachShader( program, vertex_shader );
-    glAttachShader( program, geometry_shader );
-    glAttachShader( program, fragment_shader );
-
-    // Link Program
-    glLinkProgram( program );
-
-    check_link(vertex_shader, fragment_shader, program);
+std::vector<std::string> shader_defines(unsigned int features)
+{
+    const std::vector<std::pair<shader_feature,std::string> > names = {
+        {shader_unlit, "UNLIT"}, {shader_no_specular, "NO_SPECULAR"}, {shader_textured, "TEXTURED"},
+        {shader_vertex_color, "VERTEX_COLOR"}, {shader_instanced, "INSTANCED"}, {shader_weighted_blended, "WEIGHTED_BLENDED"},
+        {shader_virtual_texture, "VIRTUAL_TEXTURE"}, {shader_log_depth, "LOG_DEPTH"} };
+
+    std::vector<std::string> defines;
+    for(const auto& it : names)
+        if(features & it.first)
+            defines.push_back(it.second);
+    return defines;
+}
 
-    // Shader can be detached.
-    glDetachShader( program, vertex_shader);
-    glDetachShader( program, geometry_shader);
-    glDetachShader( program, fragment_shader);
+GLuint shader_variant(const std::string& vertex_shader_path, const std::string& fragment_shader_path, unsigned int features)
+{
+    static std::map<std::string,GLuint> variants;
 
+    const std::string key = vertex_shader_path+"|"+fragment_shader_path+"|"+std::to_string(features);
+    auto it = variants.find(key);
+    if(it!=variants.end())
+        return it->second;
 
+    const GLuint program = create_shader_program(vertex_shader_path, fragment_shader_path, shader_defines(features));
+    variants[key] = program;
     return program;
 }
 
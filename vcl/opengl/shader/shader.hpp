@@ -3,6 +3,7 @@
 #include "vcl/wrapper/glad/glad.hpp"
 
 #include <string>
+#include <vector>
 
 namespace vcl
 {
@@ -18,4 +19,29 @@ GLuint create_shader_program(const std::string& vertex_shader_path, const std::s
 
 GLuint create_shader_program(const std::string& vertex_shader_path, const std::string& geometry_shader_path, const std::string& fragment_shader_path);
 
+/** Same as above, with a "#define" line inserted after the #version line of both shaders for each of the given names. */
+GLuint create_shader_program(const std::string& vertex_shader_path, const std::string& fragment_shader_path, const std::vector<std::string>& defines);
+
+
+/** Optional features of a shader, enabled at compile time by a preprocessor definition (given in comment).
+ * The code of the disabled features is removed from the variant, instead of being executed with neutral parameters. */
+enum shader_feature : unsigned int
+{
+    shader_unlit            = 1u<<0, // UNLIT: ambiant term only (no light, shadow, nor specular)
+    shader_no_specular      = 1u<<1, // NO_SPECULAR
+    shader_textured         = 1u<<2, // TEXTURED
+    shader_vertex_color     = 1u<<3, // VERTEX_COLOR
+    shader_instanced        = 1u<<4, // INSTANCED: per-instance transformation and shading (see mesh_drawable_instanced)
+    shader_weighted_blended = 1u<<5, // WEIGHTED_BLENDED: outputs of the weighted blended transparency (see weighted_blended_oit)
+    shader_virtual_texture  = 1u<<6, // VIRTUAL_TEXTURE: instances sampling a virtual texture (see virtual_texture_system), requires INSTANCED
+    shader_log_depth        = 1u<<7  // LOG_DEPTH: logarithmic depth written by the fragment shader (see depth_buffer_mode), disables the early depth test
+};
+
+/** Preprocessor definitions of a combination of shader_feature */
+std::vector<std::string> shader_defines(unsigned int features);
+
+/** Shader program compiled with a combination of shader_feature.
+ * Each combination is compiled once: the following calls return the cached program. */
+GLuint shader_variant(const std::string& vertex_shader_path, const std::string& fragment_shader_path, unsigned int features);
+
 }
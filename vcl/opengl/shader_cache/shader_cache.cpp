@@ -0,0 +1,165 @@
+#include "shader_cache.hpp"
+
+#include "vcl/base/file/file.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+
+namespace vcl
+{
+
+// Program binary entry points and enums (OpenGL 4.1)
+typedef void (APIENTRYP get_program_binary_function)(GLuint program, GLsizei buffer_size, GLsizei* length, GLenum* binary_format, void* binary);
+typedef void (APIENTRYP program_binary_function)(GLuint program, GLenum binary_format, const void* binary, GLsizei length);
+typedef void (APIENTRYP program_parameteri_function)(GLuint program, GLenum name, GLint value);
+static const GLenum program_binary_retrievable_hint = 0x8257;
+static const GLenum program_binary_length = 0x8741;
+static const GLenum num_program_binary_formats = 0x87FE;
+
+static get_program_binary_function get_program_binary = nullptr;
+static program_binary_function program_binary = nullptr;
+static program_parameteri_function program_parameteri = nullptr;
+static bool enabled = false;
+
+static const char shader_cache_magic[8] = {'v','c','l','p','r','o','g','1'};
+
+void shader_cache_init(void* (*get_proc_address)(const char* name))
+{
+    get_program_binary = reinterpret_cast<get_program_binary_function>(get_proc_address("glGetProgramBinary"));
+    program_binary = reinterpret_cast<program_binary_function>(get_proc_address("glProgramBinary"));
+    program_parameteri = reinterpret_cast<program_parameteri_function>(get_proc_address("glProgramParameteri"));
+
+    GLint number_formats = 0;
+    if(get_program_binary!=nullptr && program_binary!=nullptr) {
+        glGetIntegerv(num_program_binary_formats, &number_formats);
+        glGetError(); // the enum is unknown without the extension
+    }
+    enabled = number_formats>0;
+}
+
+bool shader_cache_enabled()
+{
+    return enabled;
+}
+
+static void hash_append(uint64_t& hash, const char* data, size_t size)
+{
+    // FNV-1a
+    for(size_t k=0; k<size; ++k) {
+        hash ^= uint64_t(static_cast<unsigned char>(data[k]));
+        hash *= 1099511628211ull;
+    }
+}
+
+static uint64_t hash_strings(const std::vector<std::string>& strings)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for(const std::string& str : strings)
+        hash_append(hash, str.c_str(), str.size()+1); // includes the separating '\0'
+    return hash;
+}
+
+std::string shader_cache_file(const std::vector<std::string>& names)
+{
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(hash_strings(names)));
+    return cache_file(std::string("shader_cache/")+hash+".program");
+}
+
+uint64_t shader_cache_key(const std::vector<std::string>& sources)
+{
+    uint64_t hash = hash_strings(sources);
+
+    // A binary is only valid for the driver which produced it
+    for(const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const char* value = reinterpret_cast<const char*>(glGetString(name));
+        if(value!=nullptr)
+            hash_append(hash, value, std::strlen(value)+1);
+    }
+    return hash;
+}
+
+GLuint shader_cache_load(const std::string& cache_path, uint64_t key)
+{
+    if(!enabled)
+        return 0;
+
+    std::ifstream stream(cache_path, std::ios::binary);
+    if(!stream.is_open())
+        return 0;
+
+    char magic[8];
+    uint64_t stored_key = 0;
+    uint32_t format = 0;
+    uint32_t length = 0;
+    stream.read(magic, 8);
+    stream.read(reinterpret_cast<char*>(&stored_key), sizeof(stored_key));
+    stream.read(reinterpret_cast<char*>(&format), sizeof(format));
+    stream.read(reinterpret_cast<char*>(&length), sizeof(length));
+    if(!stream || std::memcmp(magic, shader_cache_magic, 8)!=0 || stored_key!=key || length==0)
+        return 0;
+
+    std::vector<char> binary(length);
+    stream.read(&binary[0], std::streamsize(length));
+    if(!stream)
+        return 0;
+
+    // The driver may still reject the binary (ex. after an update)
+    const GLuint program = glCreateProgram();
+    program_binary(program, GLenum(format), &binary[0], GLsizei(length));
+    GLint is_linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &is_linked);
+    if(is_linked==GL_FALSE) {
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    shader_cache_stats().loaded++;
+    return program;
+}
+
+void shader_cache_prepare(GLuint program)
+{
+    if(enabled && program_parameteri!=nullptr)
+        program_parameteri(program, program_binary_retrievable_hint, GL_TRUE);
+}
+
+void shader_cache_store(GLuint program, const std::string& cache_path, uint64_t key)
+{
+    shader_cache_stats().compiled++;
+    if(!enabled)
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, program_binary_length, &length);
+    if(length<=0)
+        return;
+
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum format = 0;
+    get_program_binary(program, length, &length, &format, &binary[0]);
+
+    std::ofstream stream(cache_path, std::ios::binary);
+    if(!stream.is_open()) {
+        std::cout<<"Cannot write shader cache "<<cache_path<<std::endl;
+        return;
+    }
+
+    const uint32_t format_stored = uint32_t(format);
+    const uint32_t length_stored = uint32_t(length);
+    stream.write(shader_cache_magic, 8);
+    stream.write(reinterpret_cast<const char*>(&key), sizeof(key));
+    stream.write(reinterpret_cast<const char*>(&format_stored), sizeof(format_stored));
+    stream.write(reinterpret_cast<const char*>(&length_stored), sizeof(length_stored));
+    stream.write(&binary[0], std::streamsize(length_stored));
+}
+
+shader_cache_statistics& shader_cache_stats()
+{
+    static shader_cache_statistics stats;
+    return stats;
+}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "vcl/wrapper/glad/glad.hpp"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace vcl
+{
+
+/** Cache of the linked shader programs on disk (glGetProgramBinary: OpenGL 4.1, or ARB_get_program_binary).
+ * The loaded OpenGL 3.3 functions do not contain the program binary entry points: they are queried from the context by shader_cache_init.
+ * The cache is disabled if the driver does not provide them, or does not support any binary format.
+ * A cached program is identified by a key hashing its sources and the driver (vendor, renderer, version): it is compiled again on any mismatch. */
+
+/** Query the program binary functions with the loader of the current context (ex. a wrapper of glfwGetProcAddress) */
+void shader_cache_init(void* (*get_proc_address)(const char* name));
+
+/** True if the programs binaries can be stored and loaded */
+bool shader_cache_enabled();
+
+/** Cache file of a program identified by names (ex. its shader files and defines): shader_cache/[FNV-1a hash of the names].program,
+ * in the cache directory if one is set (see cache_file), otherwise relative to the working directory */
+std::string shader_cache_file(const std::vector<std::string>& names);
+
+/** Key of a program from its shader sources and the current driver */
+uint64_t shader_cache_key(const std::vector<std::string>& sources);
+
+/** Program loaded from the cache file, or 0 if the file is missing, built for an other key, or rejected by the driver */
+GLuint shader_cache_load(const std::string& cache_path, uint64_t key);
+
+/** Store the binary of a linked program (created after shader_cache_prepare) */
+void shader_cache_store(GLuint program, const std::string& cache_path, uint64_t key);
+
+/** Hint the driver that the binary of the program will be retrieved, must be called before linking */
+void shader_cache_prepare(GLuint program);
+
+/** Number of programs loaded from the cache, and compiled from their sources */
+struct shader_cache_statistics
+{
+    unsigned int loaded = 0;
+    unsigned int compiled = 0;
+};
+shader_cache_statistics& shader_cache_stats();
+
+}
@@ -1,6 +1,23 @@
 #include "image.hpp"
 
 #include "vcl/math/math.hpp"
+#include "vcl/base/thread_pool/thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define VCL_IMAGE_SSE2
+#endif
+
+// SSSE3 path compiled whatever the build flags (function attributes), and selected at run time
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define VCL_IMAGE_SSSE3
+#endif
 
 namespace vcl
 {
@@ -8,8 +25,8 @@ namespace vcl
 image_raw::image_raw()
     :width(0), height(0), color_type(image_color_type::rgb), data()
 {}
-image_raw::image_raw(unsigned int width_arg, unsigned int height_arg, image_color_type color_type_arg, std::vector<unsigned char> const& data_arg)
-    :width(width_arg), height(height_arg), color_type(color_type_arg), data(data_arg)
+image_raw::image_raw(unsigned int width_arg, unsigned int height_arg, image_color_type color_type_arg, std::vector<unsigned char> data_arg)
+    :width(width_arg), height(height_arg), color_type(color_type_arg), data(std::move(data_arg))
 {}
 
 buffer2D<vec3> image_raw::to_buffer_rgb() const
@@ -17,18 +34,374 @@ buffer2D<vec3> image_raw::to_buffer_rgb() const
     buffer2D<vec3> b;
     b.resize(width, height);
 
-    for(size_t i=0; i<width; ++i){
-        for(size_t j=0; j<height; ++j){
-            size_t const k = i+width*j;
-
-            if(color_type==image_color_type::rgb)
-                b(i,height-1-j) = {data[3*k]/255.0f, data[3*k+1]/255.0f, data[3*k+2]/255.0f};
-            else
-                b(i,height-1-j) = {data[4*k]/255.0f, data[4*k+1]/255.0f, data[4*k+2]/255.0f};
+    // vec3 are packed floats: an rgb row is converted at once in its flipped row
+    std::vector<float> row(color_type==image_color_type::rgba ? 4*size_t(width) : 0);
+    for(size_t j=0; width>0 && j<height; ++j) {
+        float* const destination = &b(0,height-1-j).x;
+        if(color_type==image_color_type::rgb)
+            image_bytes_to_float(&data[3*width*j], destination, 3*size_t(width));
+        else {
+            image_bytes_to_float(&data[4*width*j], &row[0], 4*size_t(width));
+            for(size_t i=0; i<width; ++i)
+                std::memcpy(destination+3*i, &row[4*i], 3*sizeof(float));
         }
     }
 
     return b;
 }
 
+#ifdef VCL_IMAGE_SSSE3
+
+// 4 pixels per shuffle (the 16 bytes load reads 4 bytes beyond the 12 used), return the number of pixels converted
+__attribute__((target("ssse3"))) static size_t rgb_to_rgba_ssse3(const unsigned char* rgb, unsigned char* rgba, size_t pixels)
+{
+    const __m128i shuffle = _mm_setr_epi8(0,1,2,-1, 3,4,5,-1, 6,7,8,-1, 9,10,11,-1);
+    const __m128i alpha = _mm_set1_epi32(int(0xff000000u));
+    size_t k = 0;
+    for(; 3*k+16<=3*pixels; k+=4) {
+        const __m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb+3*k));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba+4*k), _mm_or_si128(_mm_shuffle_epi8(source, shuffle), alpha));
+    }
+    return k;
+}
+
+static bool has_ssse3()
+{
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+}
+
+#endif
+
+void image_rgb_to_rgba(const unsigned char* rgb, unsigned char* rgba, size_t pixels)
+{
+    size_t k = 0;
+#ifdef VCL_IMAGE_SSSE3
+    if(has_ssse3())
+        k = rgb_to_rgba_ssse3(rgb, rgba, pixels);
+#endif
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__==__ORDER_LITTLE_ENDIAN__) || defined(_M_X64) || defined(_M_IX86)
+    // 4 pixels from 3 words (little endian)
+    for(; k+4<=pixels; k+=4) {
+        uint32_t w[3], p[4];
+        std::memcpy(w, rgb+3*k, 12);
+        p[0] = w[0] | 0xff000000u;
+        p[1] = (w[0]>>24) | (w[1]<<8) | 0xff000000u;
+        p[2] = (w[1]>>16) | (w[2]<<16) | 0xff000000u;
+        p[3] = (w[2]>>8) | 0xff000000u;
+        std::memcpy(rgba+4*k, p, 16);
+    }
+#endif
+    for(; k<pixels; ++k) {
+        rgba[4*k] = rgb[3*k];
+        rgba[4*k+1] = rgb[3*k+1];
+        rgba[4*k+2] = rgb[3*k+2];
+        rgba[4*k+3] = 255;
+    }
+}
+
+void image_bytes_to_float(const unsigned char* bytes, float* values, size_t n)
+{
+    size_t k = 0;
+#ifdef VCL_IMAGE_SSE2
+    // 16 bytes widened to 4x4 integers (a division keeps the exact value/255.0f)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(255.0f);
+    for(; k+16<=n; k+=16) {
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes+k));
+        const __m128i low = _mm_unpacklo_epi8(b, zero), high = _mm_unpackhi_epi8(b, zero);
+        _mm_storeu_ps(values+k,    _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale));
+        _mm_storeu_ps(values+k+4,  _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale));
+        _mm_storeu_ps(values+k+8,  _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale));
+        _mm_storeu_ps(values+k+12, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale));
+    }
+#endif
+    for(; k<n; ++k)
+        values[k] = bytes[k]/255.0f;
+}
+
+void image_flip_rows(const unsigned char* source, unsigned char* destination, size_t row_bytes, size_t rows)
+{
+    for(size_t j=0; j<rows; ++j)
+        std::memcpy(destination+row_bytes*j, source+row_bytes*(rows-1-j), row_bytes);
+}
+
+image_raw image_rgba(image_raw im)
+{
+    if(im.color_type==image_color_type::rgba)
+        return im;
+
+    image_raw out(im.width, im.height, image_color_type::rgba, std::vector<unsigned char>(4*size_t(im.width)*size_t(im.height)));
+    if(!out.data.empty())
+        image_rgb_to_rgba(&im.data[0], &out.data[0], size_t(im.width)*size_t(im.height));
+    return out;
+}
+
+image_raw image_resize(image_raw const& im, unsigned int width, unsigned int height)
+{
+    assert_vcl(im.width>0 && im.height>0, "Cannot resize an empty image");
+
+    const size_t channels = (im.color_type==image_color_type::rgb)? 3 : 4;
+    image_raw out(width, height, image_color_type::rgba, std::vector<unsigned char>(4*size_t(width)*size_t(height)));
+
+    // Sample at pixel centers in the source image
+    const float sx = float(im.width)/float(width);
+    const float sy = float(im.height)/float(height);
+    for(size_t j=0; j<height; ++j) {
+        const float y = std::min(std::max((j+0.5f)*sy-0.5f, 0.0f), float(im.height-1));
+        const size_t y0 = size_t(y);
+        const size_t y1 = std::min(y0+1, size_t(im.height-1));
+        const float ty = y-float(y0);
+
+        for(size_t i=0; i<width; ++i) {
+            const float x = std::min(std::max((i+0.5f)*sx-0.5f, 0.0f), float(im.width-1));
+            const size_t x0 = size_t(x);
+            const size_t x1 = std::min(x0+1, size_t(im.width-1));
+            const float tx = x-float(x0);
+
+            const unsigned char* p00 = &im.data[channels*(x0+im.width*y0)];
+            const unsigned char* p10 = &im.data[channels*(x1+im.width*y0)];
+            const unsigned char* p01 = &im.data[channels*(x0+im.width*y1)];
+            const unsigned char* p11 = &im.data[channels*(x1+im.width*y1)];
+
+            unsigned char* q = &out.data[4*(i+width*j)];
+            for(size_t c=0; c<channels; ++c) {
+                const float v = (1-tx)*(1-ty)*p00[c] + tx*(1-ty)*p10[c] + (1-tx)*ty*p01[c] + tx*ty*p11[c];
+                q[c] = static_cast<unsigned char>(v+0.5f);
+            }
+            if(channels==3)
+                q[3] = 255;
+        }
+    }
+
+    return out;
+}
+
+// ************************** //
+// Downsampling filter
+// ************************** //
+
+// sRGB encoding of the 8-bit colors, tables built once.
+// Plain arrays (trivially destructible): they stay valid during the exit while decoding threads may still use them.
+static const size_t linear_table_size = 65536;
+
+struct srgb_tables
+{
+    float to_linear[256];
+    unsigned char to_srgb[linear_table_size]; // indexed by linear*(linear_table_size-1): steps far below one 8-bit level, even near black
+
+    srgb_tables()
+    {
+        for(size_t k=0; k<256; ++k) {
+            const float c = k/255.0f;
+            to_linear[k] = c<=0.04045f ? c/12.92f : std::pow((c+0.055f)/1.055f, 2.4f);
+        }
+        for(size_t k=0; k<linear_table_size; ++k) {
+            const float c = float(k)/float(linear_table_size-1);
+            const float s = c<=0.0031308f ? 12.92f*c : 1.055f*std::pow(c, 1/2.4f)-0.055f;
+            to_srgb[k] = static_cast<unsigned char>(255*s+0.5f);
+        }
+    }
+};
+
+static const srgb_tables& srgb_conversion()
+{
+    static const srgb_tables tables;
+    return tables;
+}
+
+static float lanczos3(float x)
+{
+    x = std::abs(x);
+    if(x<1e-6f)
+        return 1.0f;
+    if(x>=3.0f)
+        return 0.0f;
+    const float px = 3.14159265f*x;
+    return 3*std::sin(px)*std::sin(px/3)/(px*px);
+}
+
+// Source texels and weights of each destination texel along an axis
+struct filter_axis
+{
+    size_t taps = 0;
+    std::vector<unsigned int> index; // [destination*taps+k], clamped to the edges
+    std::vector<float> weight;       // normalized
+};
+
+static filter_axis lanczos_axis(unsigned int source, unsigned int destination)
+{
+    // The kernel is stretched by the reduction factor (no aliasing)
+    const float ratio = float(source)/float(destination);
+    const float scale = std::max(1.0f, ratio);
+    const float radius = 3*scale;
+
+    filter_axis axis;
+    axis.taps = size_t(std::ceil(2*radius))+1;
+    axis.index.resize(size_t(destination)*axis.taps);
+    axis.weight.resize(size_t(destination)*axis.taps);
+    for(size_t x=0; x<destination; ++x) {
+        const float center = (x+0.5f)*ratio;
+        const int first = int(std::floor(center-radius));
+        float sum = 0.0f;
+        for(size_t k=0; k<axis.taps; ++k) {
+            const int i = first+int(k);
+            const float w = lanczos3((i+0.5f-center)/scale);
+            axis.index[x*axis.taps+k] = unsigned(std::min(std::max(i,0), int(source)-1));
+            axis.weight[x*axis.taps+k] = w;
+            sum += w;
+        }
+        for(size_t k=0; k<axis.taps; ++k)
+            axis.weight[x*axis.taps+k] /= sum;
+    }
+
+    // Last tap null for all the texels (ex. exact halving): removed
+    bool last_null = true;
+    for(size_t x=0; x<destination; ++x)
+        last_null = last_null && axis.weight[x*axis.taps+axis.taps-1]==0.0f;
+    if(last_null && axis.taps>1) {
+        for(size_t x=0; x<destination; ++x) {
+            for(size_t k=0; k+1<axis.taps; ++k) {
+                axis.index[x*(axis.taps-1)+k] = axis.index[x*axis.taps+k];
+                axis.weight[x*(axis.taps-1)+k] = axis.weight[x*axis.taps+k];
+            }
+        }
+        --axis.taps;
+        axis.index.resize(size_t(destination)*axis.taps);
+        axis.weight.resize(size_t(destination)*axis.taps);
+    }
+    return axis;
+}
+
+// Row of rgba texels, in linear space with the color premultiplied by the alpha
+static void decode_row(const unsigned char* row, size_t channels, unsigned int width, float* texels)
+{
+    const float* linear = srgb_conversion().to_linear;
+    for(size_t i=0; i<width; ++i) {
+        const unsigned char* p = row+channels*i;
+        const float a = channels==4 ? p[3]/255.0f : 1.0f;
+        texels[4*i]   = linear[p[0]]*a;
+        texels[4*i+1] = linear[p[1]]*a;
+        texels[4*i+2] = linear[p[2]]*a;
+        texels[4*i+3] = a;
+    }
+}
+
+static void encode_row(const float* texels, unsigned int width, unsigned char* row)
+{
+    // The negative lobes of the filter can leave the [0,1] range
+    const unsigned char* srgb = srgb_conversion().to_srgb;
+    const float last = float(linear_table_size-1);
+    for(size_t i=0; i<width; ++i) {
+        const float* t = texels+4*i;
+        const float a = std::min(std::max(t[3], 0.0f), 1.0f);
+        const float inverse = a>0.0f ? 1.0f/a : 0.0f;
+        for(size_t c=0; c<3; ++c)
+            row[4*i+c] = srgb[size_t(std::min(std::max(t[c]*inverse, 0.0f), 1.0f)*last+0.5f)];
+        row[4*i+3] = static_cast<unsigned char>(255*a+0.5f);
+    }
+}
+
+// destination[x] = sum_k weight * texels[index] (one rgba texel per SSE register)
+static void filter_row(const float* texels, const filter_axis& axis, unsigned int width, float* destination)
+{
+    for(size_t x=0; x<width; ++x) {
+        const unsigned int* index = &axis.index[x*axis.taps];
+        const float* weight = &axis.weight[x*axis.taps];
+#ifdef VCL_IMAGE_SSE2
+        __m128 sum = _mm_setzero_ps();
+        for(size_t k=0; k<axis.taps; ++k)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight[k]), _mm_loadu_ps(texels+4*index[k])));
+        _mm_storeu_ps(destination+4*x, sum);
+#else
+        float sum[4] = {0,0,0,0};
+        for(size_t k=0; k<axis.taps; ++k)
+            for(size_t c=0; c<4; ++c)
+                sum[c] += weight[k]*texels[4*index[k]+c];
+        std::memcpy(destination+4*x, sum, sizeof(sum));
+#endif
+    }
+}
+
+// sum[k] += weight*values[k], n multiple of 4
+static void accumulate(const float* values, float weight, size_t n, float* sum)
+{
+#ifdef VCL_IMAGE_SSE2
+    const __m128 w = _mm_set1_ps(weight);
+    for(size_t k=0; k<n; k+=4)
+        _mm_storeu_ps(sum+k, _mm_add_ps(_mm_loadu_ps(sum+k), _mm_mul_ps(w, _mm_loadu_ps(values+k))));
+#else
+    for(size_t k=0; k<n; ++k)
+        sum[k] += weight*values[k];
+#endif
+}
+
+// Rows [y0,y1[ of the downsampled image: the source rows they use are filtered horizontally, then combined vertically
+static void downsample_rows(image_raw const& im, const filter_axis& horizontal, const filter_axis& vertical, unsigned int y0, unsigned int y1, image_raw& out)
+{
+    const size_t channels = im.color_type==image_color_type::rgb ? 3 : 4;
+    const size_t row_size = 4*size_t(out.width);
+
+    unsigned int first = im.height, last = 0;
+    for(size_t k=size_t(y0)*vertical.taps; k<size_t(y1)*vertical.taps; ++k) {
+        first = std::min(first, vertical.index[k]);
+        last = std::max(last, vertical.index[k]);
+    }
+
+    std::vector<float> texels(4*size_t(im.width));
+    std::vector<float> filtered(row_size*(last-first+1));
+    for(unsigned int r=first; r<=last; ++r) {
+        decode_row(&im.data[channels*im.width*r], channels, im.width, &texels[0]);
+        filter_row(&texels[0], horizontal, out.width, &filtered[row_size*(r-first)]);
+    }
+
+    std::vector<float> sum(row_size);
+    for(size_t y=y0; y<y1; ++y) {
+        std::fill(sum.begin(), sum.end(), 0.0f);
+        for(size_t k=0; k<vertical.taps; ++k) {
+            const float w = vertical.weight[y*vertical.taps+k];
+            if(w!=0.0f)
+                accumulate(&filtered[row_size*(vertical.index[y*vertical.taps+k]-first)], w, row_size, &sum[0]);
+        }
+        encode_row(&sum[0], out.width, &out.data[row_size*y]);
+    }
+}
+
+image_raw image_downsample(image_raw const& im, unsigned int width, unsigned int height, unsigned int number_threads)
+{
+    assert_vcl(im.width>0 && im.height>0 && width>0 && height>0, "Cannot downsample an empty image");
+
+    const filter_axis horizontal = lanczos_axis(im.width, width);
+    const filter_axis vertical = lanczos_axis(im.height, height);
+    image_raw out(width, height, image_color_type::rgba, std::vector<unsigned char>(4*size_t(width)*size_t(height)));
+
+    // Blocks of rows: the source rows shared by two blocks are filtered twice
+    const unsigned int rows = 64;
+    if(number_threads==1 || height<=rows) {
+        for(unsigned int y=0; y<height; y+=rows)
+            downsample_rows(im, horizontal, vertical, y, std::min(y+rows,height), out);
+    }
+    else {
+        thread_pool workers(number_threads);
+        for(unsigned int y=0; y<height; y+=rows) {
+            const unsigned int y1 = std::min(y+rows, height);
+            workers.submit([&im, &horizontal, &vertical, y, y1, &out](){ downsample_rows(im, horizontal, vertical, y, y1, out); });
+        }
+        workers.wait();
+    }
+    return out;
+}
+
+std::vector<image_raw> image_mipmaps(image_raw im, unsigned int number_threads)
+{
+    std::vector<image_raw> mipmaps;
+    mipmaps.push_back( image_rgba(std::move(im)) );
+    while(mipmaps.back().width>1 || mipmaps.back().height>1) {
+        const image_raw& previous = mipmaps.back();
+        image_raw next = image_downsample(previous, std::max(1u,previous.width/2), std::max(1u,previous.height/2), number_threads);
+        mipmaps.push_back(std::move(next));
+    }
+    return mipmaps;
+}
+
 }
@@ -14,16 +14,40 @@ enum class image_color_type {rgb, rgba};
 struct image_raw
 {
     image_raw();
-    image_raw(unsigned int width_arg, unsigned int height_arg, image_color_type color_type_arg, std::vector<unsigned char> const& data_arg);
+    /** The data is moved: pass a temporary (or std::move) to avoid a copy */
+    image_raw(unsigned int width_arg, unsigned int height_arg, image_color_type color_type_arg, std::vector<unsigned char> data_arg);
 
     unsigned int width;
     unsigned int height;
     image_color_type color_type;
     std::vector<unsigned char> data;
 
+    /** Color in [0,1], flipped vertically (first row at the bottom) */
     buffer2D<vec3> to_buffer_rgb() const;
 };
 
+/** Expand rgb pixels to rgba (alpha=255). rgb and rgba must not overlap. */
+void image_rgb_to_rgba(const unsigned char* rgb, unsigned char* rgba, size_t pixels);
+/** Convert n bytes to floats in [0,1] (value/255) */
+void image_bytes_to_float(const unsigned char* bytes, float* values, size_t n);
+/** Copy rows in the reverse order (first row of source = last row of destination) */
+void image_flip_rows(const unsigned char* source, unsigned char* destination, size_t row_bytes, size_t rows);
+
+/** The image as rgba: an rgba image is moved without copy, an rgb one is expanded */
+image_raw image_rgba(image_raw im);
+
+/** Resample an image to a new dimension using bilinear interpolation. The resulting image is always rgba. */
+image_raw image_resize(image_raw const& im, unsigned int width, unsigned int height);
+
+/** Reduce an image with a Lanczos-3 filter (stretched by the reduction factor), in linear space and premultiplied alpha.
+ * The colors are sRGB encoded 8-bit values, the texels outside of the image are clamped to its edges. The result is always rgba.
+ * The rows are computed by blocks on number_threads threads (0: one per hardware thread, 1: calling thread). */
+image_raw image_downsample(image_raw const& im, unsigned int width, unsigned int height, unsigned int number_threads=1);
+
+/** Mipmap chain of an image: level 0 is the image (as rgba), each level is image_downsample of the previous one down to 1x1.
+ * Level 0 is moved from im: pass std::move(im) when the image is no longer needed. */
+std::vector<image_raw> image_mipmaps(image_raw im, unsigned int number_threads=1);
+
 
 
 }
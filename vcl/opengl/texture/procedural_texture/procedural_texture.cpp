@@ -0,0 +1,301 @@
+#include "procedural_texture.hpp"
+
+#include "vcl/base/base.hpp"
+#include "vcl/wrapper/perlin/perlin.hpp"
+#include "third_party/lodepng/lodepng.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace vcl
+{
+
+static const char procedural_texture_version[] = "procedural1"; // to change with the generation: invalidates the cached files
+
+static void hash_append(uint64_t& hash, const void* data, size_t size)
+{
+    // FNV-1a
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for(size_t k=0; k<size; ++k) {
+        hash ^= uint64_t(bytes[k]);
+        hash *= 1099511628211ull;
+    }
+}
+
+uint64_t procedural_texture_hash(const procedural_texture_parameters& p)
+{
+    // Field by field: the padding of the structure is not hashed
+    uint64_t hash = 14695981039346656037ull;
+    const int type = int(p.type), layout = int(p.layout);
+    hash_append(hash, procedural_texture_version, sizeof(procedural_texture_version));
+    hash_append(hash, &type, sizeof(type));
+    hash_append(hash, &layout, sizeof(layout));
+    hash_append(hash, &p.width, sizeof(p.width));
+    hash_append(hash, &p.height, sizeof(p.height));
+    hash_append(hash, &p.seed, sizeof(p.seed));
+    hash_append(hash, &p.color_low.x, 3*sizeof(float));
+    hash_append(hash, &p.color_high.x, 3*sizeof(float));
+    hash_append(hash, &p.frequency, sizeof(p.frequency));
+    hash_append(hash, &p.octave, sizeof(p.octave));
+    hash_append(hash, &p.persistency, sizeof(p.persistency));
+    hash_append(hash, &p.bands, sizeof(p.bands));
+    hash_append(hash, &p.turbulence, sizeof(p.turbulence));
+    hash_append(hash, &p.density, sizeof(p.density));
+    return hash;
+}
+
+// Unit direction of the texel (i,j) of a cross, false outside of it (inverse of cross_uv in texture_cubemap_gpu)
+static bool cross_direction(const procedural_texture_parameters& p, unsigned int i, unsigned int j, float& x, float& y, float& z)
+{
+    const float u = (i+0.5f)/p.width;
+    const float v = (j+0.5f)/p.height;
+    const int cell_u = std::min(int(4*u), 3), cell_v = std::min(int(3*v), 2);
+    if(cell_v==1) {
+        z = 3-6*v;
+        switch(cell_u) {
+        case 0: x = -1; y = 1-8*u; break;
+        case 1: y = -1; x = 8*(u-0.25f)-1; break;
+        case 2: x = 1; y = 8*(u-0.5f)-1; break;
+        default: y = 1; x = 1-8*(u-0.75f); break;
+        }
+    }
+    else if(cell_u==1) {
+        x = 8*(u-0.25f)-1;
+        z = cell_v==0 ? 1.0f : -1.0f;
+        y = cell_v==0 ? 1-6*v : 6*v-5;
+    }
+    else
+        return false;
+
+    const float norm = std::sqrt(x*x+y*y+z*z);
+    x /= norm; y /= norm; z /= norm;
+    return true;
+}
+
+// Integer hash of a texel (stars)
+static float texel_random(unsigned int i, unsigned int j, unsigned int seed)
+{
+    uint32_t h = i*73856093u ^ j*19349663u ^ (seed+1)*83492791u;
+    h ^= h>>16; h *= 0x7feb352du;
+    h ^= h>>15; h *= 0x846ca68bu;
+    h ^= h>>16;
+    return float(h>>8)/float(1u<<24);
+}
+
+static float clamp01(float x)
+{
+    return std::min(std::max(x, 0.0f), 1.0f);
+}
+
+// Fractal noise at the points (p+offset)*frequency, normalized to [0,1] (mean 0.5). By chunks: no full size temporary.
+static void fractal_noise(const float* x, const float* y, const float* z, size_t n, const vec3& offset, float frequency, int octave, float persistency, float* value)
+{
+    float amplitude = 0.0f, a = 1.0f;
+    for(int o=0; o<octave; ++o) {
+        amplitude += a;
+        a *= persistency;
+    }
+
+    const size_t chunk = 1024;
+    float xf[chunk], yf[chunk], zf[chunk];
+    for(size_t start=0; start<n; start+=chunk) {
+        const size_t m = std::min(chunk, n-start);
+        for(size_t k=0; k<m; ++k) {
+            xf[k] = (x[start+k]+offset.x)*frequency;
+            yf[k] = (y[start+k]+offset.y)*frequency;
+            zf[k] = (z[start+k]+offset.z)*frequency;
+        }
+        perlin_batch(xf, yf, zf, value+start, m, octave, persistency, 2.0f);
+        for(size_t k=0; k<m; ++k)
+            value[start+k] /= amplitude;
+    }
+}
+
+// Angles of the sphere layout along the width (theta) and the height (phi)
+struct sphere_angles
+{
+    std::vector<float> sin_theta, cos_theta, sin_phi, cos_phi;
+};
+
+static void generate_rows(const procedural_texture_parameters& p, const sphere_angles& angles, unsigned int row_begin, unsigned int row_end, unsigned char* rgb)
+{
+    const size_t n = size_t(p.width)*(row_end-row_begin);
+    std::vector<float> x(n), y(n), z(n);
+    std::vector<char> inside(n, 1);
+    for(unsigned int j=row_begin; j<row_end; ++j) {
+        for(unsigned int i=0; i<p.width; ++i) {
+            const size_t k = size_t(j-row_begin)*p.width+i;
+            if(p.layout==procedural_texture_layout::sphere) {
+                x[k] = angles.sin_theta[i]*angles.cos_phi[j];
+                y[k] = angles.sin_theta[i]*angles.sin_phi[j];
+                z[k] = angles.cos_theta[i];
+            }
+            else
+                inside[k] = cross_direction(p, i, j, x[k], y[k], z[k]);
+        }
+    }
+
+    // The seed moves the sampled region of the noise (periodic every 256 units)
+    const vec3 offset = vec3(float((p.seed*73u)%251u), float((p.seed*151u)%241u), float((p.seed*37u)%239u))/p.frequency;
+    std::vector<float> value(n), detail;
+    fractal_noise(&x[0], &y[0], &z[0], n, offset, p.frequency, p.octave, p.persistency, &value[0]);
+    if(p.type==procedural_texture_type::rocky) {
+        detail.resize(n);
+        fractal_noise(&x[0], &y[0], &z[0], n, offset, 8*p.frequency, 3, 0.5f, &detail[0]);
+    }
+
+    for(size_t k=0; k<n; ++k) {
+        unsigned char* texel = rgb + 3*k;
+        if(!inside[k]) {
+            texel[0] = texel[1] = texel[2] = 0;
+            continue;
+        }
+
+        const unsigned int i = unsigned(k%p.width), j = row_begin+unsigned(k/p.width);
+        vec3 color;
+        if(p.type==procedural_texture_type::rocky) {
+            const float relief = clamp01(0.5f+2.5f*(value[k]-0.5f));
+            const float shade = 0.9f+0.5f*(detail[k]-0.5f);
+            color = ((1-relief)*p.color_low + relief*p.color_high)*shade;
+        }
+        else if(p.type==procedural_texture_type::gas_giant) {
+            const float latitude = p.layout==procedural_texture_layout::sphere ? (i+0.5f)/p.width : std::acos(std::min(std::max(z[k], -1.0f), 1.0f))/3.14159265f;
+            const float band = 0.5f+0.5f*std::sin(3.14159265f*p.bands*(latitude + p.turbulence*(value[k]-0.5f)));
+            color = (1-band)*p.color_low + band*p.color_high;
+        }
+        else {
+            const float nebula = clamp01(2*(value[k]-0.5f)+0.5f);
+            color = p.color_low*(0.5f+nebula*nebula*nebula);
+            const float r = texel_random(i, j, p.seed);
+            if(r<p.density) {
+                const float brightness = 0.3f+0.7f*(r/p.density)*(r/p.density);
+                color = color + brightness*p.color_high;
+            }
+        }
+        texel[0] = static_cast<unsigned char>(255*clamp01(color.x)+0.5f);
+        texel[1] = static_cast<unsigned char>(255*clamp01(color.y)+0.5f);
+        texel[2] = static_cast<unsigned char>(255*clamp01(color.z)+0.5f);
+    }
+}
+
+image_raw procedural_texture_generate(const procedural_texture_parameters& parameters, unsigned int number_threads)
+{
+    assert_vcl(parameters.width>0 && parameters.height>0, "Empty procedural texture");
+    image_raw im(parameters.width, parameters.height, image_color_type::rgb, std::vector<unsigned char>(size_t(parameters.width)*parameters.height*3));
+
+    sphere_angles angles;
+    if(parameters.layout==procedural_texture_layout::sphere) {
+        for(unsigned int i=0; i<parameters.width; ++i) {
+            const float theta = 3.14159265f*(i+0.5f)/parameters.width;
+            angles.sin_theta.push_back(std::sin(theta));
+            angles.cos_theta.push_back(std::cos(theta));
+        }
+        for(unsigned int j=0; j<parameters.height; ++j) {
+            const float phi = 2*3.14159265f*(j+0.5f)/parameters.height;
+            angles.sin_phi.push_back(std::sin(phi));
+            angles.cos_phi.push_back(std::cos(phi));
+        }
+    }
+
+    // Blocks of rows as independent jobs (a few thousand texels each)
+    const unsigned int rows = std::max(1u, 16384u/parameters.width);
+    thread_pool workers(number_threads);
+    for(unsigned int row=0; row<parameters.height; row+=rows) {
+        const unsigned int row_end = std::min(row+rows, parameters.height);
+        unsigned char* const data = &im.data[size_t(row)*parameters.width*3];
+        workers.submit([&parameters, &angles, row, row_end, data](){ generate_rows(parameters, angles, row, row_end, data); });
+    }
+    workers.wait();
+    return im;
+}
+
+std::string procedural_texture_file(const procedural_texture_parameters& parameters, const std::string& directory, unsigned int number_threads)
+{
+    std::ostringstream name;
+    name<<directory<<"/procedural_"<<std::hex<<std::setw(16)<<std::setfill('0')<<procedural_texture_hash(parameters)<<".png";
+    const std::string filename = name.str();
+    if(file_size(filename)>0)
+        return filename;
+
+    std::cout<<"Generate procedural texture "<<filename<<" ("<<parameters.width<<"x"<<parameters.height<<")"<<std::endl;
+    const image_raw im = procedural_texture_generate(parameters, number_threads);
+
+    // Written once: faster compression settings than image_save_png
+    lodepng::State state;
+    state.info_raw.colortype = LCT_RGB;
+    state.info_png.color.colortype = LCT_RGB;
+    state.encoder.auto_convert = 0;
+    state.encoder.filter_strategy = LFS_ZERO;
+    state.encoder.zlibsettings.windowsize = 1024;
+    state.encoder.zlibsettings.nicematch = 32;
+    state.encoder.zlibsettings.lazymatching = 0;
+    std::vector<unsigned char> png;
+    unsigned error = lodepng::encode(png, im.data, im.width, im.height, state);
+    const std::string written_filename = cache_file(filename);
+    if(!error)
+        error = lodepng::save_file(png, written_filename);
+    if(error) {
+        std::cout<<"Cannot write the procedural texture "<<written_filename<<" ("<<lodepng_error_text(error)<<")"<<std::endl;
+        return std::string();
+    }
+    return filename;
+}
+
+struct procedural_fallback
+{
+    procedural_texture_parameters parameters;
+    std::string directory;
+    std::once_flag generated;
+    std::string source;
+};
+
+static std::mutex& fallbacks_mutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::map<std::string, std::unique_ptr<procedural_fallback> >& fallbacks()
+{
+    static std::map<std::string, std::unique_ptr<procedural_fallback> > entries;
+    return entries;
+}
+
+void procedural_texture_fallback(const std::string& filename, const procedural_texture_parameters& parameters, const std::string& directory)
+{
+    std::lock_guard<std::mutex> lock(fallbacks_mutex());
+    std::unique_ptr<procedural_fallback>& entry = fallbacks()[filename];
+    assert_vcl(entry==nullptr, "Procedural fallback of "+filename+" already set");
+    entry.reset(new procedural_fallback());
+    entry->parameters = parameters;
+    entry->directory = directory;
+}
+
+std::string procedural_texture_source(const std::string& filename)
+{
+    if(file_size(filename)>0)
+        return filename;
+
+    procedural_fallback* entry = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(fallbacks_mutex());
+        auto it = fallbacks().find(filename);
+        if(it!=fallbacks().end())
+            entry = it->second.get();
+    }
+    if(entry==nullptr)
+        return filename;
+
+    // The entries are never removed: the generation happens out of the lock, other files are resolved meanwhile
+    std::call_once(entry->generated, [entry](){ entry->source = procedural_texture_file(entry->parameters, entry->directory); });
+    return entry->source.empty() ? filename : entry->source;
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../image/image.hpp"
+#include "vcl/math/vec/vec3/vec3.hpp"
+
+#include <string>
+#include <cstdint>
+
+namespace vcl
+{
+
+/** Kind of procedural texture
+ *  - rocky: fractal relief between color_low (low lands) and color_high (high lands), shaded by a finer noise
+ *  - gas_giant: latitude bands alternating between color_low and color_high, distorted by a turbulence
+ *  - starfield: stars of color_high over a background color_low with a faint nebula */
+enum class procedural_texture_type {rocky, gas_giant, starfield};
+
+/** Layout of the texture
+ *  - sphere: parameterization of mesh_primitive_sphere (theta/pi along the width, phi/(2pi) along the height)
+ *  - cube_cross: cross of 4x3 cells read by image_cubemap_from_cross (sky box), the cells outside of the cross are black */
+enum class procedural_texture_layout {sphere, cube_cross};
+
+/** Parameters of a procedural texture. The noise is evaluated at the 3D direction of each texel: the texture has no seam. */
+struct procedural_texture_parameters
+{
+    procedural_texture_type type = procedural_texture_type::rocky;
+    procedural_texture_layout layout = procedural_texture_layout::sphere;
+    unsigned int width = 4096;
+    unsigned int height = 2048;
+    unsigned int seed = 0;
+    vec3 color_low = {0.25f,0.25f,0.25f};
+    vec3 color_high = {0.8f,0.8f,0.8f};
+    float frequency = 2.0f;   // of the first octave, on the unit sphere
+    int octave = 6;
+    float persistency = 0.5f;
+    float bands = 14.0f;      // gas_giant: number of bands from pole to pole
+    float turbulence = 0.05f; // gas_giant: distortion of the bands
+    float density = 0.002f;   // starfield: proportion of texels holding a star
+};
+
+/** Hash of the parameters (FNV-1a), identifies the cached file */
+uint64_t procedural_texture_hash(const procedural_texture_parameters& parameters);
+
+/** Generate an rgb texture. The rows are computed by blocks on number_threads threads (0: one per hardware thread),
+ * the fractal noise of each block with perlin_batch. */
+image_raw procedural_texture_generate(const procedural_texture_parameters& parameters, unsigned int number_threads=0);
+
+/** Png file of the texture in a directory, named after the hash of its parameters: generated and written only if it does not exist yet
+ * (in the cache directory if one is set, see cache_file). The file can then be loaded as any other texture (streaming, compression cache, asset pack).
+ * Return an empty string if the file cannot be written. */
+std::string procedural_texture_file(const procedural_texture_parameters& parameters, const std::string& directory, unsigned int number_threads=0);
+
+/** Use the procedural texture of parameters (file in directory) in place of filename when filename does not exist.
+ * Nothing is generated here: the texture is generated by the first procedural_texture_source asking for it. */
+void procedural_texture_fallback(const std::string& filename, const procedural_texture_parameters& parameters, const std::string& directory);
+
+/** File to load for filename: filename itself if it exists or has no fallback (or if the fallback cannot be written), the procedural texture file otherwise.
+ * Thread safe, meant for the loading threads: a texture is generated once, the concurrent calls for the same file wait for it. */
+std::string procedural_texture_source(const std::string& filename);
+
+}
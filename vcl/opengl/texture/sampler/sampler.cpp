@@ -0,0 +1,85 @@
+#include "sampler.hpp"
+
+#include <map>
+#include <tuple>
+
+namespace vcl
+{
+
+GLuint sampler_object(GLint wrap_s, GLint wrap_t, GLint min_filter, GLint mag_filter, GLint wrap_r)
+{
+    static std::map<std::tuple<GLint,GLint,GLint,GLint,GLint>, GLuint> samplers;
+
+    const auto key = std::make_tuple(wrap_s, wrap_t, min_filter, mag_filter, wrap_r);
+    auto it = samplers.find(key);
+    if(it!=samplers.end())
+        return it->second;
+
+    GLuint id = 0;
+    glGenSamplers(1, &id);
+    glSamplerParameteri(id, GL_TEXTURE_WRAP_S, wrap_s);
+    glSamplerParameteri(id, GL_TEXTURE_WRAP_T, wrap_t);
+    glSamplerParameteri(id, GL_TEXTURE_WRAP_R, wrap_r);
+    glSamplerParameteri(id, GL_TEXTURE_MIN_FILTER, min_filter);
+    glSamplerParameteri(id, GL_TEXTURE_MAG_FILTER, mag_filter);
+    samplers[key] = id;
+    return id;
+}
+
+// Bindings recorded by bind_texture on the first units: texture of each target (2D, 2D array, cube map) and sampler
+static const GLuint unknown_binding = ~GLuint(0);
+static const GLuint cached_units = 4;
+struct texture_unit_binding
+{
+    GLuint textures[3];
+    GLuint sampler;
+};
+static texture_unit_binding bindings[cached_units];
+static bool binding_cache_enabled = false;
+
+static unsigned int target_index(GLenum target)
+{
+    switch(target) {
+    case GL_TEXTURE_2D_ARRAY: return 1;
+    case GL_TEXTURE_CUBE_MAP: return 2;
+    default: return 0;
+    }
+}
+
+void bind_texture(GLenum target, GLuint texture_id, GLuint sampler, GLuint unit)
+{
+    const bool cached = binding_cache_enabled && unit<cached_units;
+    GLuint dummy_texture = unknown_binding, dummy_sampler = unknown_binding;
+    GLuint& current_texture = cached ? bindings[unit].textures[target_index(target)] : dummy_texture;
+    GLuint& current_sampler = cached ? bindings[unit].sampler : dummy_sampler;
+
+    if(current_texture!=texture_id) {
+        if(unit!=0)
+            glActiveTexture(GL_TEXTURE0+unit);
+        glBindTexture(target, texture_id);
+        if(unit!=0)
+            glActiveTexture(GL_TEXTURE0);
+        current_texture = texture_id;
+    }
+    if(current_sampler!=sampler) {
+        glBindSampler(unit, sampler);
+        current_sampler = sampler;
+    }
+}
+
+void texture_binding_cache_begin()
+{
+    for(texture_unit_binding& binding : bindings) {
+        for(GLuint& texture : binding.textures)
+            texture = unknown_binding;
+        binding.sampler = unknown_binding;
+    }
+    binding_cache_enabled = true;
+}
+
+void texture_binding_cache_end()
+{
+    binding_cache_enabled = false;
+}
+
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "vcl/wrapper/glad/glad.hpp"
+
+namespace vcl
+{
+
+/** Sampler objects (OpenGL 3.3): wrapping and filtering of a texture unit, whatever texture is bound to it.
+ * A bound sampler overrides the parameters of the texture. Each combination of parameters is created once, on the first call,
+ *  and never modified afterwards: the drawables only select a sampler instead of changing the state of their textures. */
+GLuint sampler_object(GLint wrap_s, GLint wrap_t, GLint min_filter=GL_LINEAR_MIPMAP_LINEAR, GLint mag_filter=GL_LINEAR, GLint wrap_r=GL_CLAMP_TO_EDGE);
+
+/** Bind a texture and a sampler (0: parameters of the texture) to a texture unit. The active unit is left to GL_TEXTURE0.
+ * While the binding cache is enabled, each binding is skipped if it is already the current one (consecutive draws sharing their texture). */
+void bind_texture(GLenum target, GLuint texture_id, GLuint sampler, GLuint unit=0);
+
+/** Record the bindings of bind_texture on the CPU, without querying OpenGL. The current bindings are unknown at the start.
+ * Only valid while the textures and samplers are bound through bind_texture (ex. during render_queue::submit) */
+void texture_binding_cache_begin();
+/** Stop recording: bind_texture binds again unconditionally */
+void texture_binding_cache_end();
+
+}
@@ -1,3 +1,11 @@
 
 #include "image/image.hpp"
 #include "texture_gpu/texture_gpu.hpp"
+#include "texture_array_gpu/texture_array_gpu.hpp"
+#include "texture_cubemap_gpu/texture_cubemap_gpu.hpp"
+#include "sampler/sampler.hpp"
+#include "texture_loader/texture_loader.hpp"
+#include "texture_compressed/texture_compressed.hpp"
+#include "texture_streaming/texture_streaming.hpp"
+#include "virtual_texture/virtual_texture.hpp"
+#include "procedural_texture/procedural_texture.hpp"
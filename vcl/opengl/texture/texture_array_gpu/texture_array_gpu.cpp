@@ -0,0 +1,68 @@
+#include "texture_array_gpu.hpp"
+
+#include "vcl/base/base.hpp"
+
+namespace vcl
+{
+
+GLuint create_texture_array_gpu(std::vector<image_raw> const& images, GLsizei width, GLsizei height, GLint wrap_s, GLint wrap_t)
+{
+    assert_vcl(images.size()>0, "Cannot create a texture array without image");
+
+    // Allocate all layers, then fill them one by one
+    const GLuint id = create_texture_array_gpu(GLsizei(images.size()), width, height, wrap_s, wrap_t);
+    for(size_t k=0; k<images.size(); ++k)
+        update_texture_array_gpu(id, GLint(k), images[k]);
+    update_texture_array_mipmap_gpu(id);
+
+    return id;
+}
+
+GLuint create_texture_array_gpu(GLsizei layers, GLsizei width, GLsizei height, GLint wrap_s, GLint wrap_t)
+{
+    assert_vcl(layers>0, "Cannot create a texture array without layer");
+
+    GLuint id = 0;
+    glGenTextures(1,&id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY,id);
+
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    // Set default texture behavior
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, wrap_s);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, wrap_t);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY,0);
+
+    return id;
+}
+
+void update_texture_array_gpu(GLuint texture_id, GLint layer, image_raw const& im)
+{
+    glBindTexture(GL_TEXTURE_2D_ARRAY,texture_id);
+
+    GLint width = 0, height = 0;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D_ARRAY, 0, GL_TEXTURE_HEIGHT, &height);
+
+    if(GLint(im.width)==width && GLint(im.height)==height && im.color_type==image_color_type::rgba)
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0,0,layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, &im.data[0]);
+    else {
+        image_raw const resized = image_resize(im, unsigned(width), unsigned(height));
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0,0,layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, &resized.data[0]);
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY,0);
+}
+
+void update_texture_array_mipmap_gpu(GLuint texture_id)
+{
+    glBindTexture(GL_TEXTURE_2D_ARRAY,texture_id);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY,0);
+}
+
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "vcl/wrapper/glad/glad.hpp"
+#include "../image/image.hpp"
+
+#include <vector>
+
+namespace vcl
+{
+
+/** Create a GL_TEXTURE_2D_ARRAY where each image is stored in one layer (layer k = images[k]).
+ * All layers share the same dimension (width,height): images with a different size are resampled. */
+GLuint create_texture_array_gpu(std::vector<image_raw> const& images, GLsizei width, GLsizei height, GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE);
+
+/** Create a GL_TEXTURE_2D_ARRAY with uninitialized layers, filled afterwards with update_texture_array_gpu */
+GLuint create_texture_array_gpu(GLsizei layers, GLsizei width, GLsizei height, GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE);
+
+/** Fill one layer of a texture array (resampled if needed). The mipmaps are not updated: see update_texture_array_mipmap_gpu. */
+void update_texture_array_gpu(GLuint texture_id, GLint layer, image_raw const& im);
+
+/** Generate the mipmaps of all the layers once they are filled */
+void update_texture_array_mipmap_gpu(GLuint texture_id);
+
+}
@@ -0,0 +1,418 @@
+#include "texture_compressed.hpp"
+
+#include "vcl/base/base.hpp"
+#include "vcl/wrapper/lodepng/lodepng.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace vcl
+{
+
+bool texture_compression_supported()
+{
+    GLint number_extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &number_extensions);
+    for(GLint k=0; k<number_extensions; ++k) {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, GLuint(k)));
+        if(name!=nullptr && std::strcmp(name, "GL_EXT_texture_compression_s3tc")==0)
+            return true;
+    }
+    return false;
+}
+
+GLenum texture_compression_format(texture_compression compression)
+{
+    assert_vcl(compression==texture_compression::bc1 || compression==texture_compression::bc3, "The compression must be bc1 or bc3");
+    return compression==texture_compression::bc1 ? texture_format_bc1 : texture_format_bc3;
+}
+
+size_t compressed_level_size(GLenum internal_format, unsigned int width, unsigned int height)
+{
+    if(internal_format==GL_RGBA8)
+        return 4*size_t(width)*size_t(height);
+    const size_t block_size = internal_format==texture_format_bc1 ? 8 : 16;
+    return size_t((width+3)/4) * size_t((height+3)/4) * block_size;
+}
+
+
+// ************************** //
+// Block compression
+// ************************** //
+
+static uint16_t pack_565(const float c[3])
+{
+    const unsigned int r = unsigned(std::min(std::max(c[0],0.0f),255.0f)*31.0f/255.0f+0.5f);
+    const unsigned int g = unsigned(std::min(std::max(c[1],0.0f),255.0f)*63.0f/255.0f+0.5f);
+    const unsigned int b = unsigned(std::min(std::max(c[2],0.0f),255.0f)*31.0f/255.0f+0.5f);
+    return uint16_t((r<<11) | (g<<5) | b);
+}
+
+static void unpack_565(uint16_t c, int rgb[3])
+{
+    const int r = (c>>11)&31, g = (c>>5)&63, b = c&31;
+    rgb[0] = (r<<3) | (r>>2);
+    rgb[1] = (g<<2) | (g>>4);
+    rgb[2] = (b<<3) | (b>>2);
+}
+
+// 4x4 texels (rgba) of a block starting at (x,y), repeating the border texels outside of the image
+static void fetch_block(image_raw const& im, unsigned int x, unsigned int y, unsigned char block[16][4])
+{
+    const size_t channels = im.color_type==image_color_type::rgb ? 3 : 4;
+    for(unsigned int j=0; j<4; ++j) {
+        for(unsigned int i=0; i<4; ++i) {
+            const size_t u = std::min(x+i, im.width-1);
+            const size_t v = std::min(y+j, im.height-1);
+            const unsigned char* p = &im.data[channels*(u+im.width*v)];
+            unsigned char* q = block[4*j+i];
+            q[0] = p[0]; q[1] = p[1]; q[2] = p[2];
+            q[3] = channels==4 ? p[3] : 255;
+        }
+    }
+}
+
+// Color block of BC1/BC3: 2 endpoints in rgb565, and 2 bits per texel selecting one of the 4 colors interpolated between them
+static void compress_color_block(const unsigned char block[16][4], unsigned char* out)
+{
+    float mean[3] = {0,0,0};
+    for(unsigned int k=0; k<16; ++k)
+        for(unsigned int c=0; c<3; ++c)
+            mean[c] += block[k][c]/16.0f;
+
+    float covariance[6] = {0,0,0,0,0,0}; // xx xy xz yy yz zz
+    for(unsigned int k=0; k<16; ++k) {
+        const float d[3] = {block[k][0]-mean[0], block[k][1]-mean[1], block[k][2]-mean[2]};
+        covariance[0] += d[0]*d[0]; covariance[1] += d[0]*d[1]; covariance[2] += d[0]*d[2];
+        covariance[3] += d[1]*d[1]; covariance[4] += d[1]*d[2]; covariance[5] += d[2]*d[2];
+    }
+
+    // Principal axis by power iterations
+    float axis[3] = {1,1,1};
+    for(unsigned int iteration=0; iteration<8; ++iteration) {
+        const float next[3] = {
+            covariance[0]*axis[0] + covariance[1]*axis[1] + covariance[2]*axis[2],
+            covariance[1]*axis[0] + covariance[3]*axis[1] + covariance[4]*axis[2],
+            covariance[2]*axis[0] + covariance[4]*axis[1] + covariance[5]*axis[2]};
+        const float norm = std::max(std::max(std::abs(next[0]),std::abs(next[1])),std::abs(next[2]));
+        if(norm<1e-6f)
+            break;
+        for(unsigned int c=0; c<3; ++c)
+            axis[c] = next[c]/norm;
+    }
+
+    // Endpoints: texels with the extreme projections on the axis
+    unsigned int k_min = 0, k_max = 0;
+    float t_min = 0, t_max = 0;
+    for(unsigned int k=0; k<16; ++k) {
+        const float t = (block[k][0]-mean[0])*axis[0] + (block[k][1]-mean[1])*axis[1] + (block[k][2]-mean[2])*axis[2];
+        if(k==0 || t<t_min) { t_min = t; k_min = k; }
+        if(k==0 || t>t_max) { t_max = t; k_max = k; }
+    }
+    const float e0[3] = {float(block[k_max][0]), float(block[k_max][1]), float(block[k_max][2])};
+    const float e1[3] = {float(block[k_min][0]), float(block[k_min][1]), float(block[k_min][2])};
+    uint16_t c0 = pack_565(e0);
+    uint16_t c1 = pack_565(e1);
+    if(c0<c1)
+        std::swap(c0, c1);
+
+    // c0>c1 selects the 4 colors mode of BC1 (no transparent texel)
+    uint32_t indices = 0;
+    if(c0!=c1) {
+        int palette[4][3];
+        unpack_565(c0, palette[0]);
+        unpack_565(c1, palette[1]);
+        for(unsigned int c=0; c<3; ++c) {
+            palette[2][c] = (2*palette[0][c]+palette[1][c])/3;
+            palette[3][c] = (palette[0][c]+2*palette[1][c])/3;
+        }
+        for(unsigned int k=0; k<16; ++k) {
+            unsigned int best = 0;
+            int best_distance = 0;
+            for(unsigned int p=0; p<4; ++p) {
+                const int dr = block[k][0]-palette[p][0], dg = block[k][1]-palette[p][1], db = block[k][2]-palette[p][2];
+                const int distance = dr*dr + dg*dg + db*db;
+                if(p==0 || distance<best_distance) { best = p; best_distance = distance; }
+            }
+            indices |= uint32_t(best) << (2*k);
+        }
+    }
+
+    out[0] = uint8_t(c0&0xFF); out[1] = uint8_t(c0>>8);
+    out[2] = uint8_t(c1&0xFF); out[3] = uint8_t(c1>>8);
+    for(unsigned int b=0; b<4; ++b)
+        out[4+b] = uint8_t((indices>>(8*b))&0xFF);
+}
+
+// Alpha block of BC3: 2 endpoints, and 3 bits per texel selecting one of the 8 values interpolated between them
+static void compress_alpha_block(const unsigned char block[16][4], unsigned char* out)
+{
+    unsigned char a0 = 0, a1 = 255;
+    for(unsigned int k=0; k<16; ++k) {
+        a0 = std::max(a0, block[k][3]);
+        a1 = std::min(a1, block[k][3]);
+    }
+
+    uint64_t indices = 0;
+    if(a0!=a1) {
+        int palette[8] = {a0, a1, 0, 0, 0, 0, 0, 0};
+        for(int p=2; p<8; ++p)
+            palette[p] = ((8-p)*a0 + (p-1)*a1)/7;
+        for(unsigned int k=0; k<16; ++k) {
+            unsigned int best = 0;
+            for(unsigned int p=1; p<8; ++p)
+                if(std::abs(block[k][3]-palette[p]) < std::abs(block[k][3]-palette[best]))
+                    best = p;
+            indices |= uint64_t(best) << (3*k);
+        }
+    }
+
+    out[0] = a0;
+    out[1] = a1;
+    for(unsigned int b=0; b<6; ++b)
+        out[2+b] = uint8_t((indices>>(8*b))&0xFF);
+}
+
+static bool has_transparency(image_raw const& im)
+{
+    if(im.color_type==image_color_type::rgb)
+        return false;
+    for(size_t k=3; k<im.data.size(); k+=4)
+        if(im.data[k]<255)
+            return true;
+    return false;
+}
+
+std::vector<unsigned char> image_compress(image_raw const& im, texture_compression compression)
+{
+    if(compression==texture_compression::automatic)
+        compression = has_transparency(im) ? texture_compression::bc3 : texture_compression::bc1;
+    const GLenum format = texture_compression_format(compression);
+    const size_t block_size = format==texture_format_bc1 ? 8 : 16;
+
+    std::vector<unsigned char> data(compressed_level_size(format, im.width, im.height));
+    unsigned char block[16][4];
+    unsigned char* out = data.empty() ? nullptr : &data[0];
+    for(unsigned int y=0; y<im.height; y+=4) {
+        for(unsigned int x=0; x<im.width; x+=4) {
+            fetch_block(im, x, y, block);
+            if(format==texture_format_bc3) {
+                compress_alpha_block(block, out);
+                compress_color_block(block, out+8);
+            }
+            else
+                compress_color_block(block, out);
+            out += block_size;
+        }
+    }
+    return data;
+}
+
+
+// ************************** //
+// KTX (version 1) files
+// ************************** //
+
+static const unsigned char ktx_identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+static const uint32_t ktx_endianness = 0x04030201;
+static const char ktx_source_size_key[] = "vclSourceSize";
+static const char ktx_mipmaps_key[] = "vclMipmaps";
+static const char ktx_mipmaps_value[] = "lanczos3-linear"; // to change with image_mipmaps: invalidates the cached files
+
+// Fields following the identifier
+struct ktx_header
+{
+    uint32_t endianness;
+    uint32_t gl_type;
+    uint32_t gl_type_size;
+    uint32_t gl_format;
+    uint32_t gl_internal_format;
+    uint32_t gl_base_internal_format;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t number_array_elements;
+    uint32_t number_faces;
+    uint32_t number_mipmap_levels;
+    uint32_t bytes_key_value_data;
+};
+
+static size_t mipmaps_count(unsigned int width, unsigned int height)
+{
+    size_t count = 1;
+    while(width>1 || height>1) {
+        width = std::max(1u, width/2);
+        height = std::max(1u, height/2);
+        ++count;
+    }
+    return count;
+}
+
+template <typename T>
+static void append(std::vector<unsigned char>& data, const T& value)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+    data.insert(data.end(), bytes, bytes+sizeof(T));
+}
+
+static void append_key_value(std::vector<unsigned char>& data, const std::string& key, const std::string& value)
+{
+    const uint32_t key_value_size = uint32_t(key.size()+1 + value.size()+1);
+    append(data, key_value_size);
+    data.insert(data.end(), key.c_str(), key.c_str()+key.size()+1);
+    data.insert(data.end(), value.c_str(), value.c_str()+value.size()+1);
+    data.insert(data.end(), (4-key_value_size%4)%4, 0);
+}
+
+static std::vector<unsigned char> ktx_encode(GLenum format, unsigned int width, unsigned int height, std::vector<std::vector<unsigned char> > const& levels, uint64_t source_size)
+{
+    // The size of the png and the mipmap filter are stored as key/value pairs: the cache is created again if one of them changes
+    std::vector<unsigned char> key_values;
+    append_key_value(key_values, ktx_source_size_key, str(source_size));
+    append_key_value(key_values, ktx_mipmaps_key, ktx_mipmaps_value);
+
+    ktx_header header;
+    header.endianness = ktx_endianness;
+    header.gl_type = format==GL_RGBA8 ? GL_UNSIGNED_BYTE : 0; // 0: compressed
+    header.gl_type_size = 1;
+    header.gl_format = format==GL_RGBA8 ? GL_RGBA : 0;
+    header.gl_internal_format = format;
+    header.gl_base_internal_format = format==texture_format_bc1 ? GL_RGB : GL_RGBA;
+    header.pixel_width = width;
+    header.pixel_height = height;
+    header.pixel_depth = 0;
+    header.number_array_elements = 0;
+    header.number_faces = 1;
+    header.number_mipmap_levels = uint32_t(levels.size());
+    header.bytes_key_value_data = uint32_t(key_values.size());
+
+    std::vector<unsigned char> data(ktx_identifier, ktx_identifier+12);
+    append(data, header);
+    data.insert(data.end(), key_values.begin(), key_values.end());
+
+    // Block and rgba texel sizes are multiples of 4: no padding is needed between the levels
+    for(std::vector<unsigned char> const& level : levels) {
+        append(data, uint32_t(level.size()));
+        data.insert(data.end(), level.begin(), level.end());
+    }
+    return data;
+}
+
+static bool ktx_parse(const unsigned char* data, size_t size, texture_compression compression, unsigned int width, unsigned int height, uint64_t source_size, compressed_texture& texture)
+{
+    ktx_header header;
+    if(data==nullptr || size<12+sizeof(header) || std::memcmp(data, ktx_identifier, 12)!=0)
+        return false;
+    std::memcpy(&header, data+12, sizeof(header));
+
+    bool format_valid = false;
+    if(compression==texture_compression::none)
+        format_valid = header.gl_internal_format==GL_RGBA8;
+    else if(compression==texture_compression::automatic)
+        format_valid = header.gl_internal_format==texture_format_bc1 || header.gl_internal_format==texture_format_bc3;
+    else
+        format_valid = header.gl_internal_format==texture_compression_format(compression);
+    if(header.endianness!=ktx_endianness || !format_valid || header.number_faces!=1 || header.number_array_elements!=0)
+        return false;
+    if( (width>0 && height>0) && (header.pixel_width!=width || header.pixel_height!=height) )
+        return false;
+
+    // Key/value pairs: the size of the source png and the mipmap filter are checked
+    size_t offset = 12 + sizeof(header);
+    const size_t key_value_end = offset + header.bytes_key_value_data;
+    if(key_value_end>size)
+        return false;
+    bool source_valid = false, mipmaps_valid = false;
+    while(offset+4<=key_value_end) {
+        uint32_t pair_size = 0;
+        std::memcpy(&pair_size, data+offset, 4);
+        offset += 4;
+        if(offset+pair_size>key_value_end)
+            return false;
+        const std::string pair(reinterpret_cast<const char*>(data+offset), pair_size);
+        const size_t separator = pair.find('\0');
+        if(separator!=std::string::npos) {
+            const std::string key = pair.substr(0,separator);
+            const std::string value = pair.substr(separator+1, pair.find('\0',separator+1)-separator-1);
+            if(key==ktx_source_size_key)
+                source_valid = value==str(source_size);
+            else if(key==ktx_mipmaps_key)
+                mipmaps_valid = value==ktx_mipmaps_value;
+        }
+        offset += pair_size + (4-pair_size%4)%4;
+    }
+    if(!source_valid || !mipmaps_valid)
+        return false;
+
+    // Complete mipmap chain
+    texture.levels.clear();
+    unsigned int w = header.pixel_width, h = header.pixel_height;
+    for(uint32_t level=0; level<header.number_mipmap_levels; ++level) {
+        uint32_t level_size = 0;
+        if(offset+4>size)
+            return false;
+        std::memcpy(&level_size, data+offset, 4);
+        offset += 4;
+        if(level_size!=compressed_level_size(header.gl_internal_format, w, h) || offset+level_size>size)
+            return false;
+        texture.levels.push_back(data+offset);
+        offset += level_size;
+        w = std::max(1u, w/2);
+        h = std::max(1u, h/2);
+    }
+    if(texture.levels.size()!=mipmaps_count(header.pixel_width, header.pixel_height))
+        return false;
+
+    texture.internal_format = header.gl_internal_format;
+    texture.width = header.pixel_width;
+    texture.height = header.pixel_height;
+    return true;
+}
+
+compressed_texture compressed_texture_load(const std::string& filename, texture_compression compression, unsigned int width, unsigned int height)
+{
+    const std::string cache_filename = filename + (compression==texture_compression::none ? ".rgba.ktx" : ".ktx");
+    const uint64_t source_size = file_size(filename);
+
+    compressed_texture texture;
+    if(texture.file.open(cache_filename) && ktx_parse(texture.file.data(), texture.file.size(), compression, width, height, source_size, texture))
+        return texture;
+    texture.file.close();
+
+    std::cout<<(compression==texture_compression::none ? "Compute mipmaps of " : "Compress texture ")<<filename<<" (cached in "<<cache_filename<<")"<<std::endl;
+    image_raw im = image_load_png(filename);
+    if(width>0 && height>0 && (im.width!=width || im.height!=height))
+        im = image_resize(im, width, height);
+    if(compression==texture_compression::automatic)
+        compression = has_transparency(im) ? texture_compression::bc3 : texture_compression::bc1;
+
+    std::vector<image_raw> mipmaps = image_mipmaps(std::move(im));
+    const unsigned int level_width = mipmaps[0].width, level_height = mipmaps[0].height;
+    std::vector<std::vector<unsigned char> > levels;
+    for(image_raw& level : mipmaps) {
+        if(compression==texture_compression::none)
+            levels.push_back(std::move(level.data));
+        else
+            levels.push_back(image_compress(level, compression));
+        level = image_raw();
+    }
+    const GLenum format = compression==texture_compression::none ? GLenum(GL_RGBA8) : texture_compression_format(compression);
+    texture.memory = ktx_encode(format, level_width, level_height, levels, source_size);
+
+    const std::string written_filename = cache_file(cache_filename);
+    std::ofstream stream(written_filename, std::ios::binary);
+    if(stream.is_open())
+        stream.write(reinterpret_cast<const char*>(&texture.memory[0]), std::streamsize(texture.memory.size()));
+    else
+        std::cout<<"Cannot write texture cache "<<written_filename<<std::endl;
+
+    if(!ktx_parse(&texture.memory[0], texture.memory.size(), compression, width, height, source_size, texture))
+        error_vcl("Invalid compressed texture "+filename);
+    return texture;
+}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "vcl/wrapper/glad/glad.hpp"
+#include "vcl/base/file_mapping/file_mapping.hpp"
+#include "../image/image.hpp"
+
+#include <string>
+#include <vector>
+
+namespace vcl
+{
+
+/** Block compression of the textures (S3TC, EXT_texture_compression_s3tc: not in the OpenGL 3.3 core but exposed by the desktop drivers)
+ *  - bc1: opaque rgb, 4 bits per texel (1/8 of GL_RGBA8)
+ *  - bc3: rgba, 8 bits per texel (1/4 of GL_RGBA8)
+ *  - automatic: bc3 if the image has transparent texels, bc1 otherwise */
+enum class texture_compression {none, automatic, bc1, bc3};
+
+/** Internal formats of the compressed textures */
+const GLenum texture_format_bc1 = 0x83F0; // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+const GLenum texture_format_bc3 = 0x83F3; // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+
+/** True if the current context can sample S3TC textures */
+bool texture_compression_supported();
+
+/** Internal format of a compression (bc1 or bc3) */
+GLenum texture_compression_format(texture_compression compression);
+
+/** Number of bytes of a level of dimension (width,height): blocks of 4x4 texels, 8 bytes (bc1) or 16 bytes (bc3) each.
+ * GL_RGBA8 (no compression): 4 bytes per texel. */
+size_t compressed_level_size(GLenum internal_format, unsigned int width, unsigned int height);
+
+/** Compress an image (bc1 or bc3). Each 4x4 block uses the extremities of the principal axis of its colors. */
+std::vector<unsigned char> image_compress(image_raw const& im, texture_compression compression);
+
+/** Compressed mipmap chain (level 0 to 1x1), stored in a KTX file. internal_format is GL_RGBA8 without compression. */
+struct compressed_texture
+{
+    GLenum internal_format = 0;
+    unsigned int width = 0;
+    unsigned int height = 0;
+    std::vector<const unsigned char*> levels; // data of each level, of size compressed_level_size
+    file_mapping file;                        // mapped KTX file
+    std::vector<unsigned char> memory;        // KTX content when it has just been created
+};
+
+/** Compressed mipmap chain of a png file, resized to (width,height) if it is not (0,0). The levels are computed by image_mipmaps.
+ * The chain is cached in filename+".ktx" and mapped: the png is only decoded and compressed when the cache is missing,
+ *  or was created for an other compression, dimension, size of png file, or mipmap filter. Can be called from any thread.
+ * compression=none: uncompressed GL_RGBA8 levels, cached in filename+".rgba.ktx" (the mipmaps are computed once, then only mapped). */
+compressed_texture compressed_texture_load(const std::string& filename, texture_compression compression, unsigned int width=0, unsigned int height=0);
+
+}
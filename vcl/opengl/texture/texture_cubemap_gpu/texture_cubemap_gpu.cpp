@@ -0,0 +1,199 @@
+#include "texture_cubemap_gpu.hpp"
+
+#include "vcl/base/base.hpp"
+#include "vcl/wrapper/lodepng/lodepng.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace vcl
+{
+
+// Texture coordinates of the cross image seen in the direction d (same mapping as the former six quads of the sky box)
+static void cross_uv(float x, float y, float z, float& u, float& v)
+{
+    const float ax = std::abs(x), ay = std::abs(y), az = std::abs(z);
+    if(az>=ax && az>=ay) {
+        x/=az; y/=az;
+        u = 0.25f+(x+1)/8.0f;
+        v = z<0 ? 2/3.0f+(y+1)/6.0f : 1/3.0f-(y+1)/6.0f;
+    }
+    else if(ay>=ax) {
+        x/=ay; z/=ay;
+        u = y<0 ? 0.25f+(x+1)/8.0f : 0.75f+(1-x)/8.0f;
+        v = 2/3.0f-(z+1)/6.0f;
+    }
+    else {
+        y/=ax; z/=ax;
+        u = x>0 ? 0.5f+(y+1)/8.0f : (1-y)/8.0f;
+        v = 2/3.0f-(z+1)/6.0f;
+    }
+}
+
+// Bilinear rgba sample of an image at texture coordinates (u,v)
+static void sample_bilinear(image_raw const& im, float u, float v, unsigned char* rgba)
+{
+    const unsigned int channels = im.color_type==image_color_type::rgba ? 4 : 3;
+    const float x = std::min(std::max(u*im.width-0.5f, 0.0f), float(im.width-1));
+    const float y = std::min(std::max(v*im.height-0.5f, 0.0f), float(im.height-1));
+    const unsigned int x0 = static_cast<unsigned int>(x), y0 = static_cast<unsigned int>(y);
+    const unsigned int x1 = std::min(x0+1, im.width-1), y1 = std::min(y0+1, im.height-1);
+    const float fx = x-x0, fy = y-y0;
+
+    for(unsigned int c=0; c<4; ++c) {
+        if(c>=channels) { rgba[c] = 255; continue; }
+        const float p00 = im.data[(y0*im.width+x0)*channels+c];
+        const float p10 = im.data[(y0*im.width+x1)*channels+c];
+        const float p01 = im.data[(y1*im.width+x0)*channels+c];
+        const float p11 = im.data[(y1*im.width+x1)*channels+c];
+        const float p = (1-fy)*((1-fx)*p00+fx*p10) + fy*((1-fx)*p01+fx*p11);
+        rgba[c] = static_cast<unsigned char>(p+0.5f);
+    }
+}
+
+std::vector<image_raw> image_cubemap_from_cross(image_raw const& cross, unsigned int face_size)
+{
+    assert_vcl(cross.width>0 && cross.height>0, "Empty cross image");
+    if(face_size==0)
+        face_size = cross.width/4;
+
+    std::vector<image_raw> faces;
+    for(unsigned int f=0; f<6; ++f)
+    {
+        image_raw face(face_size, face_size, image_color_type::rgba, std::vector<unsigned char>(size_t(face_size)*face_size*4));
+        for(unsigned int j=0; j<face_size; ++j) {
+            for(unsigned int i=0; i<face_size; ++i) {
+                // Direction of the texel (i,j) following the OpenGL cubemap convention
+                const float sc = 2*(i+0.5f)/face_size-1;
+                const float tc = 2*(j+0.5f)/face_size-1;
+                float x=0, y=0, z=0;
+                switch(f) {
+                case 0: x= 1;  y=-tc; z=-sc; break;
+                case 1: x=-1;  y=-tc; z= sc; break;
+                case 2: x= sc; y= 1;  z= tc; break;
+                case 3: x= sc; y=-1;  z=-tc; break;
+                case 4: x= sc; y=-tc; z= 1;  break;
+                default:x=-sc; y=-tc; z=-1;  break;
+                }
+
+                float u=0, v=0;
+                cross_uv(x,y,z, u,v);
+                sample_bilinear(cross, u, v, &face.data[(size_t(j)*face_size+i)*4]);
+            }
+        }
+        faces.push_back(face);
+    }
+    return faces;
+}
+
+static const char cubemap_cache_magic[8] = {'v','c','l','c','u','b','e','2'};
+
+// Identifies the content of the source image (FNV-1a over 64-bit words, then the remaining bytes): a png replaced by another one of the same size is converted again
+static uint64_t cubemap_source_key(const std::string& filename)
+{
+    file_mapping file;
+    if(!file.open(filename))
+        return 0;
+    uint64_t hash = 14695981039346656037ull;
+    const unsigned char* const data = file.data();
+    const size_t size = file.size();
+    size_t k = 0;
+    for(; k+8<=size; k+=8) {
+        uint64_t word;
+        std::memcpy(&word, data+k, 8);
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    for(; k<size; ++k)
+        hash = (hash ^ uint64_t(data[k])) * 1099511628211ull;
+    return (hash ^ uint64_t(size)) * 1099511628211ull;
+}
+
+static bool cubemap_cache_read(const std::string& cache_filename, uint64_t source_key, std::vector<image_raw>& faces)
+{
+    // Mapped (or a view of the asset pack): the faces are then copied out of the mapping
+    file_mapping file;
+    if(!file.open(cache_filename))
+        return false;
+
+    const size_t header_size = 8 + sizeof(uint64_t) + sizeof(uint32_t);
+    uint64_t key = 0;
+    uint32_t face_size = 0;
+    if(file.size()<header_size || std::memcmp(file.data(), cubemap_cache_magic, 8)!=0)
+        return false;
+    std::memcpy(&key, file.data()+8, sizeof(key));
+    std::memcpy(&face_size, file.data()+8+sizeof(key), sizeof(face_size));
+    const size_t face_bytes = size_t(face_size)*face_size*4;
+    if(key!=source_key || face_size==0 || file.size()!=header_size+6*face_bytes)
+        return false;
+
+    faces.clear();
+    for(unsigned int f=0; f<6; ++f) {
+        const unsigned char* const data = file.data()+header_size+f*face_bytes;
+        faces.push_back(image_raw(face_size, face_size, image_color_type::rgba, std::vector<unsigned char>(data, data+face_bytes)));
+    }
+    return true;
+}
+
+static void cubemap_cache_write(const std::string& cache_filename, uint64_t source_key, std::vector<image_raw> const& faces)
+{
+    const std::string written_filename = cache_file(cache_filename);
+    std::ofstream stream(written_filename, std::ios::binary);
+    if(!stream.is_open()) {
+        std::cout<<"Cannot write cubemap cache "<<written_filename<<std::endl;
+        return;
+    }
+
+    const uint32_t face_size = faces[0].width;
+    stream.write(cubemap_cache_magic, 8);
+    stream.write(reinterpret_cast<const char*>(&source_key), sizeof(source_key));
+    stream.write(reinterpret_cast<const char*>(&face_size), sizeof(face_size));
+    for(image_raw const& face : faces)
+        stream.write(reinterpret_cast<const char*>(&face.data[0]), std::streamsize(face.data.size()));
+}
+
+std::vector<image_raw> image_load_cubemap_cross(const std::string& filename)
+{
+    const std::string cache_filename = filename+".cubemap";
+    const uint64_t source_key = cubemap_source_key(filename);
+
+    std::vector<image_raw> faces;
+    if(cubemap_cache_read(cache_filename, source_key, faces))
+        return faces;
+
+    std::cout<<"Convert cross image "<<filename<<" to cubemap (cached in "<<cache_filename<<")"<<std::endl;
+    faces = image_cubemap_from_cross(image_load_png(filename));
+    cubemap_cache_write(cache_filename, source_key, faces);
+    return faces;
+}
+
+GLuint create_texture_cubemap_gpu(std::vector<image_raw> const& faces)
+{
+    assert_vcl(faces.size()==6, "A cubemap requires 6 faces");
+
+    GLuint id = 0;
+    glGenTextures(1,&id);
+    glBindTexture(GL_TEXTURE_CUBE_MAP,id);
+
+    for(unsigned int f=0; f<6; ++f) {
+        image_raw const& face = faces[f];
+        const GLenum format = face.color_type==image_color_type::rgba ? GL_RGBA : GL_RGB;
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X+f, 0, GL_RGBA8, GLsizei(face.width), GLsizei(face.height), 0, format, GL_UNSIGNED_BYTE, &face.data[0]);
+    }
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+    glBindTexture(GL_TEXTURE_CUBE_MAP,0);
+
+    return id;
+}
+
+}
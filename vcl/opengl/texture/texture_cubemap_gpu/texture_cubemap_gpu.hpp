@@ -0,0 +1,24 @@
+#pragma once
+
+#include "vcl/wrapper/glad/glad.hpp"
+#include "../image/image.hpp"
+
+#include <string>
+#include <vector>
+
+namespace vcl
+{
+
+/** Convert a cross layout image into the six faces of a cubemap, in the OpenGL order (+x,-x,+y,-y,+z,-z).
+ * The cross is made of 4x3 cells: the four lateral faces (-x,-y,+x,+y) on the middle row, -z below the -y face and +z above it.
+ * Each face is resampled with bilinear interpolation and has a dimension face_size x face_size (cell width if face_size==0). */
+std::vector<image_raw> image_cubemap_from_cross(image_raw const& cross, unsigned int face_size = 0);
+
+/** Load a cross layout png image as cubemap faces.
+ * The converted faces are cached in the binary file filename+".cubemap" and reused as long as the png file keeps the same content (hash). */
+std::vector<image_raw> image_load_cubemap_cross(const std::string& filename);
+
+/** Create a GL_TEXTURE_CUBE_MAP from six faces given in the OpenGL order (+x,-x,+y,-y,+z,-z) */
+GLuint create_texture_cubemap_gpu(std::vector<image_raw> const& faces);
+
+}
@@ -1,5 +1,7 @@
 #include "texture_gpu.hpp"
 
+#include <utility>
+
 namespace vcl
 {
 
@@ -32,7 +34,39 @@ GLuint create_texture_gpu(std::vector<unsigned char> const& data, GLsizei width,
 
 GLuint create_texture_gpu(image_raw const& im, GLint wrap_s, GLint wrap_t)
 {
-    return create_texture_gpu(im.data, GLsizei(im.width), GLsizei(im.height), wrap_s, wrap_t);
+    return create_texture_gpu(image_mipmaps(im, 0), wrap_s, wrap_t);
+}
+
+GLuint create_texture_gpu(image_raw&& im, GLint wrap_s, GLint wrap_t)
+{
+    return create_texture_gpu(image_mipmaps(std::move(im), 0), wrap_s, wrap_t);
+}
+
+GLuint create_texture_gpu(std::vector<image_raw> const& mipmaps, GLint wrap_s, GLint wrap_t)
+{
+    assert_vcl(mipmaps.size()>0, "Cannot create a texture without image");
+
+    GLuint id = 0;
+    glGenTextures(1,&id);
+    glBindTexture(GL_TEXTURE_2D,id);
+
+    // Levels uploaded one by one (rgb rows are tightly packed)
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for(size_t level=0; level<mipmaps.size(); ++level) {
+        image_raw const& im = mipmaps[level];
+        const GLenum format = im.color_type==image_color_type::rgba ? GL_RGBA : GL_RGB;
+        glTexImage2D(GL_TEXTURE_2D, GLint(level), GL_RGBA8, GLsizei(im.width), GLsizei(im.height), 0, format, GL_UNSIGNED_BYTE, &im.data[0]);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(mipmaps.size()-1));
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glBindTexture(GL_TEXTURE_2D,0);
+
+    return id;
 }
 
 //void update_texture_gpu(GLuint texture_id, image_rgb const& im)
@@ -12,7 +12,12 @@ namespace vcl
 void update_texture_gpu(GLuint texture_id, buffer2D<vec3> const& im);
 
 GLuint create_texture_gpu(buffer2D<vec3> const& im, GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE);
+/** The mipmaps are computed on the CPU with image_mipmaps (all the hardware threads). The image is copied as level 0 */
 GLuint create_texture_gpu(image_raw const& im, GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE);
+/** Same, the image being moved as level 0 (ex. create_texture_gpu(image_load_png(filename))) */
+GLuint create_texture_gpu(image_raw&& im, GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE);
+/** Texture from a complete mipmap chain (level 0 to 1x1, ex. image_mipmaps), uploaded level by level */
+GLuint create_texture_gpu(std::vector<image_raw> const& mipmaps, GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE);
 GLuint create_texture_gpu(std::vector<unsigned char> const& data, GLsizei width, GLsizei height, GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE);
 
 }
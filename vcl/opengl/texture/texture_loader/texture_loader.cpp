@@ -0,0 +1,90 @@
+#include "texture_loader.hpp"
+
+#include "vcl/wrapper/lodepng/lodepng.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+namespace vcl
+{
+
+static float elapsed_ms(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+texture_loader::texture_loader(unsigned int number_threads)
+    :jobs(), mutex(), job_decoded(), workers(number_threads)
+{}
+
+void texture_loader::request(const std::string& name, decode_function decode, upload_function upload)
+{
+    std::shared_ptr<job> current = std::make_shared<job>();
+    current->name = name;
+    current->upload = upload;
+    jobs.push_back(current);
+
+    workers.submit([this, current, decode]()
+    {
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<image_raw> images = decode();
+        const float duration = elapsed_ms(start);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current->images = std::move(images);
+            current->decode_ms = duration;
+            current->decoded = true;
+        }
+        job_decoded.notify_all();
+    });
+}
+
+void texture_loader::request_png(const std::string& filename, std::function<void(image_raw& image)> upload, unsigned int width, unsigned int height)
+{
+    const decode_function decode = [filename, width, height]()
+    {
+        // Resizing right after the decoding avoids keeping the full resolution images until their upload
+        image_raw im = image_load_png(filename);
+        if(width>0 && height>0 && (im.width!=width || im.height!=height))
+            im = image_resize(im, width, height);
+        return std::vector<image_raw>(1, std::move(im));
+    };
+    request(filename, decode, [upload](std::vector<image_raw>& images){ upload(images[0]); });
+}
+
+void texture_loader::finish()
+{
+    const auto start = std::chrono::steady_clock::now();
+    float waiting_ms = 0.0f;
+
+    for(std::shared_ptr<job>& current : jobs)
+    {
+        const auto start_wait = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            job_decoded.wait(lock, [&current]{ return current->decoded; });
+        }
+        waiting_ms += elapsed_ms(start_wait);
+
+        const auto start_upload = std::chrono::steady_clock::now();
+        current->upload(current->images);
+        current->upload_ms = elapsed_ms(start_upload);
+
+        // Release the decoded images as soon as they are on the GPU
+        current->images.clear();
+        current->images.shrink_to_fit();
+    }
+
+    std::cout<<"\t [OK] "<<jobs.size()<<" textures loaded in "<<elapsed_ms(start)<<" ms ("<<workers.size()<<" decoding threads, "<<waiting_ms<<" ms waiting for the decoding)"<<std::endl;
+    std::cout<<std::fixed<<std::setprecision(1);
+    for(const std::shared_ptr<job>& current : jobs)
+        std::cout<<"\t\t decode "<<std::setw(8)<<current->decode_ms<<" ms, upload "<<std::setw(8)<<current->upload_ms<<" ms  "<<current->name<<std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout<<std::setprecision(6);
+
+    jobs.clear();
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../image/image.hpp"
+#include "vcl/base/thread_pool/thread_pool.hpp"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+namespace vcl
+{
+
+/** Load a set of textures with the image decoding on worker threads.
+ * Each request is decoded as soon as a worker is available, while its upload (the OpenGL calls) is deferred to finish():
+ *  the uploads run on the main thread in the order of the requests, each one waiting only for its own decoding.
+ * The decoding and upload times of each request are reported once all of them are done. */
+struct texture_loader
+{
+    /** Decoding on a worker thread (must not call OpenGL). Several images can be returned, ex. the faces of a cubemap. */
+    typedef std::function<std::vector<image_raw>()> decode_function;
+    /** Upload of the decoded images, called on the main thread */
+    typedef std::function<void(std::vector<image_raw>& images)> upload_function;
+
+    /** number_threads=0: one thread per hardware thread */
+    explicit texture_loader(unsigned int number_threads=0);
+
+    void request(const std::string& name, decode_function decode, upload_function upload);
+    /** Request a png file, resized on the worker thread if (width,height) is not (0,0) */
+    void request_png(const std::string& filename, std::function<void(image_raw& image)> upload, unsigned int width=0, unsigned int height=0);
+
+    /** Upload all the requests in order (waiting for their decoding), then print the timings. The loader can be reused afterwards. */
+    void finish();
+
+private:
+    struct job
+    {
+        std::string name;
+        upload_function upload;
+        std::vector<image_raw> images;
+        float decode_ms = 0.0f;
+        float upload_ms = 0.0f;
+        bool decoded = false;
+    };
+
+    std::vector<std::shared_ptr<job> > jobs;
+    std::mutex mutex;
+    std::condition_variable job_decoded;
+    thread_pool workers;
+};
+
+}
@@ -0,0 +1,490 @@
+#include "texture_streaming.hpp"
+
+#include "vcl/base/base.hpp"
+#include "../procedural_texture/procedural_texture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace vcl
+{
+
+// Size of the pixel buffer: a level is uploaded by chunks of rows fitting in it
+static const size_t pixel_buffer_size = size_t(2)<<20;
+
+static GLsizei level_size(GLsizei size, GLint level)
+{
+    return std::max(GLsizei(1), size>>level);
+}
+
+static GLint number_levels(GLsizei width, GLsizei height)
+{
+    GLint levels = 1;
+    while( (std::max(width,height)>>levels) > 0 )
+        ++levels;
+    return levels;
+}
+
+// Coarsest level with at least texels_width texels horizontally
+static GLint level_from_width(GLsizei width, GLint levels, float texels_width)
+{
+    GLint level = 0;
+    while(level<levels-1 && float(level_size(width,level+1))>=texels_width)
+        ++level;
+    return level;
+}
+
+static size_t level_bytes(GLenum internal_format, GLsizei width, GLsizei height)
+{
+    if(internal_format==GL_RGBA8)
+        return 4*size_t(width)*size_t(height);
+    return compressed_level_size(internal_format, unsigned(width), unsigned(height));
+}
+
+// Level of (width,height,layers) filled with a color, in the internal format
+static std::vector<unsigned char> placeholder_data(const vec4& color, GLenum internal_format, GLsizei width, GLsizei height, GLsizei layers)
+{
+    const unsigned char texel[4] = {
+        static_cast<unsigned char>(255*std::min(std::max(color.x,0.0f),1.0f)+0.5f),
+        static_cast<unsigned char>(255*std::min(std::max(color.y,0.0f),1.0f)+0.5f),
+        static_cast<unsigned char>(255*std::min(std::max(color.z,0.0f),1.0f)+0.5f),
+        static_cast<unsigned char>(255*std::min(std::max(color.w,0.0f),1.0f)+0.5f)};
+
+    // Compressed: the same block is repeated
+    std::vector<unsigned char> unit(texel, texel+4);
+    size_t count = size_t(width)*size_t(height)*size_t(layers);
+    if(internal_format!=GL_RGBA8) {
+        image_raw block(4, 4, image_color_type::rgba, std::vector<unsigned char>(64));
+        for(size_t k=0; k<16; ++k)
+            std::memcpy(&block.data[4*k], texel, 4);
+        unit = image_compress(block, internal_format==texture_format_bc1 ? texture_compression::bc1 : texture_compression::bc3);
+        count = level_bytes(internal_format, width, height)/unit.size()*size_t(layers);
+    }
+
+    std::vector<unsigned char> data(unit.size()*count);
+    for(size_t k=0; k<count; ++k)
+        std::memcpy(&data[unit.size()*k], &unit[0], unit.size());
+    return data;
+}
+
+static void allocate_level(GLenum target, GLenum internal_format, GLint level, GLsizei width, GLsizei height, GLsizei layers)
+{
+    const GLsizei bytes = GLsizei(level_bytes(internal_format, width, height)*size_t(layers));
+    if(target==GL_TEXTURE_2D_ARRAY) {
+        if(internal_format==GL_RGBA8)
+            glTexImage3D(target, level, GL_RGBA8, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        else
+            glCompressedTexImage3D(target, level, internal_format, width, height, layers, 0, bytes, nullptr);
+    }
+    else {
+        if(internal_format==GL_RGBA8)
+            glTexImage2D(target, level, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        else
+            glCompressedTexImage2D(target, level, internal_format, width, height, 0, bytes, nullptr);
+    }
+}
+
+// Release the storage of a level (zero size), which must not be used for the sampling (finer than GL_TEXTURE_BASE_LEVEL)
+static void free_level(GLenum target, GLenum internal_format, GLint level)
+{
+    if(target==GL_TEXTURE_2D_ARRAY) {
+        if(internal_format==GL_RGBA8)
+            glTexImage3D(target, level, GL_RGBA8, 0, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        else
+            glCompressedTexImage3D(target, level, internal_format, 0, 0, 0, 0, 0, nullptr);
+    }
+    else {
+        if(internal_format==GL_RGBA8)
+            glTexImage2D(target, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        else
+            glCompressedTexImage2D(target, level, internal_format, 0, 0, 0, 0, nullptr);
+    }
+}
+
+// Rows [y,y+height[ of layers [layer,layer+layers[ (data is an offset in the pixel buffer if one is bound)
+static void upload_region(GLenum target, GLenum internal_format, GLint level, GLint y, GLint layer, GLsizei width, GLsizei height, GLsizei layers, size_t bytes, const void* data)
+{
+    if(target==GL_TEXTURE_2D_ARRAY) {
+        if(internal_format==GL_RGBA8)
+            glTexSubImage3D(target, level, 0,y,layer, width, height, layers, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        else
+            glCompressedTexSubImage3D(target, level, 0,y,layer, width, height, layers, internal_format, GLsizei(bytes), data);
+    }
+    else {
+        if(internal_format==GL_RGBA8)
+            glTexSubImage2D(target, level, 0,y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        else
+            glCompressedTexSubImage2D(target, level, 0,y, width, height, internal_format, GLsizei(bytes), data);
+    }
+}
+
+static void set_texture_parameters(GLenum target, GLint wrap_s, GLint wrap_t)
+{
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, wrap_s);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, wrap_t);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+}
+
+texture_streaming::texture_streaming(unsigned int number_threads, float budget_ms_arg)
+    :budget_ms(budget_ms_arg), memory_budget(size_t(256)<<20), resident_size(128), textures(), texture_index(), memory_allocated(0), pixel_buffer(0), frame(0), mutex(), workers(number_threads)
+{}
+
+GLuint texture_streaming::create_texture_gpu(const std::string& filename, const vec4& placeholder, GLint wrap_s, GLint wrap_t, texture_compression compression)
+{
+    std::unique_ptr<streamed_texture> texture(new streamed_texture());
+    texture->target = GL_TEXTURE_2D;
+    texture->compression = (compression==texture_compression::none || texture_compression_supported()) ? compression : texture_compression::none;
+    texture->filenames.push_back(filename);
+    texture->compressed.resize(1);
+    texture->decoded.resize(1, false);
+
+    // Single texel until the dimension of the image is known
+    glGenTextures(1, &texture->id);
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &placeholder_data(placeholder,GL_RGBA8,1,1,1)[0]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    set_texture_parameters(GL_TEXTURE_2D, wrap_s, wrap_t);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    request_source(*texture);
+    texture_index[texture->id] = texture.get();
+    textures.push_back(std::move(texture));
+    return textures.back()->id;
+}
+
+GLuint texture_streaming::create_texture_array_gpu(const std::vector<std::string>& filenames, GLsizei width, GLsizei height, const vec4& placeholder, GLint wrap_s, GLint wrap_t, texture_compression compression)
+{
+    assert_vcl(filenames.size()>0, "Cannot create a texture array without image");
+    assert_vcl(compression!=texture_compression::automatic, "The layers of a texture array must have the same compression");
+
+    std::unique_ptr<streamed_texture> texture(new streamed_texture());
+    texture->target = GL_TEXTURE_2D_ARRAY;
+    texture->compression = (compression==texture_compression::none || texture_compression_supported()) ? compression : texture_compression::none;
+    texture->internal_format = texture->compression==texture_compression::none ? GL_RGBA8 : texture_compression_format(texture->compression);
+    texture->width = width;
+    texture->height = height;
+    texture->layers = GLsizei(filenames.size());
+    texture->levels = number_levels(width, height);
+    texture->filenames = filenames;
+    texture->decode_width = width;
+    texture->decode_height = height;
+    texture->compressed.resize(filenames.size());
+    texture->decoded.resize(filenames.size(), false);
+
+    // The dimension is known: only the smallest level is allocated (the placeholder), the others when they are streamed
+    const GLint last = texture->levels-1;
+    const GLsizei last_width = level_size(width,last), last_height = level_size(height,last);
+    glGenTextures(1, &texture->id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture->id);
+    allocate_level(GL_TEXTURE_2D_ARRAY, texture->internal_format, last, last_width, last_height, texture->layers);
+    const std::vector<unsigned char> data = placeholder_data(placeholder, texture->internal_format, last_width, last_height, texture->layers);
+    upload_region(GL_TEXTURE_2D_ARRAY, texture->internal_format, last, 0, 0, last_width, last_height, texture->layers, data.size(), &data[0]);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, last);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, last);
+    set_texture_parameters(GL_TEXTURE_2D_ARRAY, wrap_s, wrap_t);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    // The placeholder is replaced by the first streamed level
+    texture->base_level = texture->levels;
+    texture->allocated_level = last;
+    texture->level = last;
+    memory_allocated += level_memory(*texture, last);
+
+    request_source(*texture);
+    texture_index[texture->id] = texture.get();
+    textures.push_back(std::move(texture));
+    return textures.back()->id;
+}
+
+void texture_streaming::require(GLuint texture_id, float texels_width)
+{
+    auto it = texture_index.find(texture_id);
+    if(it==texture_index.end())
+        return;
+    it->second->managed = true;
+    it->second->demand = std::max(it->second->demand, std::max(texels_width, 1.0f));
+}
+
+void texture_streaming::request_source(streamed_texture& texture)
+{
+    texture.source_requested = true;
+    streamed_texture* const current = &texture;
+    for(size_t k=0; k<texture.filenames.size(); ++k) {
+        const GLsizei layer = GLsizei(k);
+        workers.submit([this, current, layer](){ decode(current, layer); });
+    }
+}
+
+void texture_streaming::release_source(streamed_texture& texture)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for(size_t k=0; k<texture.decoded.size(); ++k) {
+        texture.compressed[k] = compressed_texture();
+        texture.decoded[k] = false;
+    }
+    texture.source_requested = false;
+}
+
+void texture_streaming::decode(streamed_texture* texture, GLsizei layer)
+{
+    // Decoding thread: the full mipmap chain is mapped from its cache (computed the first time), the main thread only copies it.
+    // A missing file with a procedural fallback is generated here as well.
+    const std::string filename = procedural_texture_source(texture->filenames[size_t(layer)]);
+    compressed_texture levels = compressed_texture_load(filename, texture->compression, unsigned(texture->decode_width), unsigned(texture->decode_height));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    texture->compressed[size_t(layer)] = std::move(levels);
+    texture->decoded[size_t(layer)] = true;
+}
+
+bool texture_streaming::is_decoded(const streamed_texture& texture, GLsizei layer) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return texture.decoded[size_t(layer)];
+}
+
+bool texture_streaming::is_source_loaded(const streamed_texture& texture) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::find(texture.decoded.begin(), texture.decoded.end(), false)==texture.decoded.end();
+}
+
+const unsigned char* texture_streaming::level_data(const streamed_texture& texture, GLsizei layer, GLint level) const
+{
+    return texture.compressed[size_t(layer)].levels[size_t(level)];
+}
+
+void texture_streaming::allocate(streamed_texture& texture)
+{
+    // GL_TEXTURE_2D once decoded: the placeholder is replaced by the smallest level of the image
+    const compressed_texture& levels = texture.compressed[0];
+    texture.internal_format = levels.internal_format;
+    texture.width = GLsizei(levels.width);
+    texture.height = GLsizei(levels.height);
+    texture.levels = number_levels(texture.width, texture.height);
+    const GLint last = texture.levels-1;
+    const GLsizei last_width = level_size(texture.width,last), last_height = level_size(texture.height,last);
+
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    free_level(GL_TEXTURE_2D, GL_RGBA8, 0);
+    allocate_level(GL_TEXTURE_2D, texture.internal_format, last, last_width, last_height, 1);
+    upload_region(GL_TEXTURE_2D, texture.internal_format, last, 0, 0, last_width, last_height, 1,
+                  level_bytes(texture.internal_format, last_width, last_height), level_data(texture, 0, last));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, last);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, last);
+
+    texture.base_level = last;
+    texture.allocated_level = last;
+    texture.level = last-1;
+    memory_allocated += level_memory(texture, last);
+}
+
+GLint texture_streaming::target_level(const streamed_texture& texture) const
+{
+    // Textures never required are streamed to their full resolution
+    if(!texture.managed)
+        return 0;
+    return level_from_width(texture.width, texture.levels, texture.required_width);
+}
+
+size_t texture_streaming::level_memory(const streamed_texture& texture, GLint level) const
+{
+    return level_bytes(texture.internal_format, level_size(texture.width,level), level_size(texture.height,level))*size_t(texture.layers);
+}
+
+size_t texture_streaming::memory_used() const
+{
+    return memory_allocated;
+}
+
+bool texture_streaming::evict_level(streamed_texture& texture)
+{
+    // The finest allocated level is released, unless it belongs to the resident levels
+    const GLint level = texture.allocated_level;
+    if(texture.width==0 || level>=texture.levels-1 || std::max(level_size(texture.width,level),level_size(texture.height,level))<=resident_size)
+        return false;
+
+    glBindTexture(texture.target, texture.id);
+    free_level(texture.target, texture.internal_format, level);
+    texture.allocated_level = level+1;
+    memory_allocated -= level_memory(texture, level);
+    if(texture.base_level<=level) {
+        texture.base_level = level+1;
+        glTexParameteri(texture.target, GL_TEXTURE_BASE_LEVEL, texture.base_level);
+    }
+
+    // A partially uploaded level is restarted
+    texture.level = texture.base_level-1;
+    texture.layer = 0;
+    texture.row = 0;
+    return true;
+}
+
+bool texture_streaming::reserve(streamed_texture& texture)
+{
+    // Storage of the level at the upload cursor, within the memory budget
+    const size_t bytes = level_memory(texture, texture.level);
+    while(memory_allocated+bytes>memory_budget)
+    {
+        // Least recently used texture first, then the textures having levels finer than required
+        streamed_texture* victim = nullptr;
+        for(std::unique_ptr<streamed_texture>& candidate : textures) {
+            if(candidate.get()==&texture || !candidate->managed)
+                continue;
+            const bool unused = candidate->last_use<frame;
+            if(!unused && candidate->allocated_level>=target_level(*candidate))
+                continue;
+            const GLint level = candidate->allocated_level;
+            if(candidate->width==0 || level>=candidate->levels-1 || std::max(level_size(candidate->width,level),level_size(candidate->height,level))<=resident_size)
+                continue;
+            if(victim==nullptr || candidate->last_use<victim->last_use)
+                victim = candidate.get();
+        }
+        if(victim==nullptr)
+            return false;
+        evict_level(*victim);
+    }
+
+    glBindTexture(texture.target, texture.id);
+    allocate_level(texture.target, texture.internal_format, texture.level, level_size(texture.width,texture.level), level_size(texture.height,texture.level), texture.layers);
+    texture.allocated_level = texture.level;
+    memory_allocated += bytes;
+    return true;
+}
+
+bool texture_streaming::upload_rows(streamed_texture& texture)
+{
+    const GLsizei width = level_size(texture.width, texture.level);
+    const GLsizei height = level_size(texture.height, texture.level);
+
+    // Compressed levels are made of rows of 4x4 blocks
+    const GLsizei block = texture.internal_format==GL_RGBA8 ? 1 : 4;
+    const size_t row_bytes = level_bytes(texture.internal_format, width, std::min(block,height));
+    const GLsizei block_rows = std::min( (height-texture.row+block-1)/block, GLsizei(std::max(size_t(1), pixel_buffer_size/row_bytes)) );
+    const GLsizei rows = std::min(height-texture.row, block_rows*block);
+    const size_t bytes = row_bytes*size_t(block_rows);
+    const unsigned char* source = level_data(texture, texture.layer, texture.level) + row_bytes*size_t(texture.row/block);
+
+    // Orphaned buffer: the driver does not wait for the previous upload before the copy
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(std::max(pixel_buffer_size,bytes)), nullptr, GL_STREAM_DRAW);
+    void* destination = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(bytes), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if(destination==nullptr) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    std::memcpy(destination, source, bytes);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    glBindTexture(texture.target, texture.id);
+    upload_region(texture.target, texture.internal_format, texture.level, texture.row, texture.layer, width, rows, 1, bytes, nullptr);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Next chunk: rows, then layers, then the next finer level
+    texture.row += rows;
+    if(texture.row==height) {
+        texture.row = 0;
+        ++texture.layer;
+    }
+    if(texture.layer==texture.layers) {
+        texture.layer = 0;
+        texture.base_level = texture.level;
+        glTexParameteri(texture.target, GL_TEXTURE_BASE_LEVEL, texture.base_level);
+        --texture.level;
+    }
+    return true;
+}
+
+void texture_streaming::update()
+{
+    const auto start = std::chrono::steady_clock::now();
+    if(pixel_buffer==0)
+        glGenBuffers(1, &pixel_buffer);
+
+    // Levels required by the uses since the last update
+    ++frame;
+    for(std::unique_ptr<streamed_texture>& texture : textures) {
+        if(texture->demand>0.0f) {
+            texture->last_use = frame;
+            texture->required_width = texture->demand;
+            texture->demand = 0.0f;
+        }
+    }
+
+    std::vector<streamed_texture*> blocked; // no memory left for their next level
+    bool budget_left = true;
+    while(budget_left)
+    {
+        // Smallest pending level among the textures whose next layer is decoded
+        streamed_texture* next = nullptr;
+        size_t next_size = 0;
+        for(std::unique_ptr<streamed_texture>& texture : textures)
+        {
+            if(texture->width==0) {
+                if(!is_decoded(*texture, 0))
+                    continue;
+                allocate(*texture);
+            }
+            const bool active = !texture->managed || texture->last_use==frame;
+            if(!active || texture->base_level<=target_level(*texture) || std::find(blocked.begin(), blocked.end(), texture.get())!=blocked.end())
+                continue;
+            if(!texture->source_requested) {
+                request_source(*texture);
+                continue;
+            }
+            if(!is_decoded(*texture, texture->layer))
+                continue;
+            const size_t size = size_t(level_size(texture->width,texture->level))*size_t(level_size(texture->height,texture->level));
+            if(next==nullptr || size<next_size) {
+                next = texture.get();
+                next_size = size;
+            }
+        }
+        if(next==nullptr)
+            break;
+
+        // The storage of a level is allocated when its upload starts
+        if(next->level<next->allocated_level && !reserve(*next)) {
+            blocked.push_back(next);
+            continue;
+        }
+        if(!upload_rows(*next))
+            break;
+
+        budget_left = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-start).count() < budget_ms;
+    }
+
+    // The decoded images are only kept while they are streamed
+    for(std::unique_ptr<streamed_texture>& texture : textures) {
+        const bool active = !texture->managed || texture->last_use==frame;
+        if(texture->source_requested && texture->width>0 && (!active || texture->base_level<=target_level(*texture)) && is_source_loaded(*texture))
+            release_source(*texture);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+bool texture_streaming::done() const
+{
+    for(const std::unique_ptr<streamed_texture>& texture : textures)
+        if(texture->width==0 || texture->base_level>target_level(*texture))
+            return false;
+    return true;
+}
+
+void texture_streaming::clear()
+{
+    workers.cancel();
+    textures.clear();
+    texture_index.clear();
+    memory_allocated = 0;
+    if(pixel_buffer!=0)
+        glDeleteBuffers(1, &pixel_buffer);
+    pixel_buffer = 0;
+}
+
+}
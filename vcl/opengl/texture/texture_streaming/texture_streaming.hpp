@@ -0,0 +1,128 @@
+#pragma once
+
+#include "vcl/wrapper/glad/glad.hpp"
+#include "vcl/math/vec/vec4/vec4.hpp"
+#include "vcl/base/thread_pool/thread_pool.hpp"
+#include "../image/image.hpp"
+#include "../texture_compressed/texture_compressed.hpp"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+namespace vcl
+{
+
+/** Textures available immediately, sharpened progressively, and kept resident within a memory budget.
+ * A texture is created with a 1x1 placeholder color, while the mipmap chain of its png file is mapped on worker threads:
+ *  the chain is computed once by image_mipmaps and cached next to the png (see compressed_texture_load, GL_RGBA8 without compression).
+ *  A missing png with a procedural fallback is generated on the worker thread first (see procedural_texture_source).
+ * The levels are then sent to the GPU from the smallest to the largest, through a pixel buffer object, during update():
+ *  each call uploads rows for at most budget_ms, and GL_TEXTURE_BASE_LEVEL is lowered as soon as a level is complete.
+ * With a compression (bc1, bc3), the cached levels are compressed blocks, uploaded without conversion as well.
+ *  The compression is ignored if the driver does not support S3TC textures.
+ *
+ * Residency: once require() is called for a texture, only the levels needed at the required resolution are streamed,
+ *  and only while the texture is required (i.e. visible). The finer levels are allocated on demand; when they would exceed memory_budget,
+ *  levels are freed (zero size level, above GL_TEXTURE_BASE_LEVEL) from the textures unused for the longest time first,
+ *  then from the textures having more levels than required. The evicted levels are streamed again when they are required.
+ *  The levels up to resident_size texels are never evicted. Textures never required are streamed to their full resolution.
+ *
+ * The OpenGL calls only happen in the creation functions, update() and clear(), on the thread of the context. */
+struct texture_streaming
+{
+    /** number_threads=0: one decoding thread per hardware thread */
+    explicit texture_streaming(unsigned int number_threads=0, float budget_ms=2.0f);
+    texture_streaming(const texture_streaming&) = delete;
+    texture_streaming& operator=(const texture_streaming&) = delete;
+
+    /** Asynchronous variant of create_texture_gpu: the png file keeps its dimension */
+    GLuint create_texture_gpu(const std::string& filename, const vec4& placeholder=vec4(0.5f,0.5f,0.5f,1.0f), GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE, texture_compression compression=texture_compression::none);
+
+    /** Asynchronous variant of create_texture_array_gpu: layer k = filenames[k], resized to (width,height).
+     * A level is only displayed once it is uploaded for all the layers. All the layers share the same compression (not automatic). */
+    GLuint create_texture_array_gpu(const std::vector<std::string>& filenames, GLsizei width, GLsizei height, const vec4& placeholder=vec4(0.5f,0.5f,0.5f,1.0f), GLint wrap_s=GL_CLAMP_TO_EDGE, GLint wrap_t=GL_CLAMP_TO_EDGE, texture_compression compression=texture_compression::none);
+
+    /** Mark a texture as used until the next update, with a level of at least texels_width texels horizontally (ex. the width of the object on screen).
+     * For a texture array, the largest width required for any of its layers. */
+    void require(GLuint texture_id, float texels_width);
+
+    /** Evict and upload the levels (typically called once per frame): the uploads last at most budget_ms */
+    void update();
+
+    /** True once all the textures have their required resolution */
+    bool done() const;
+
+    /** Memory of the allocated levels (in bytes) */
+    size_t memory_used() const;
+
+    /** Drop the decodings not started yet and wait for the running ones, then release the pixel buffer.
+     * The textures remain valid, the levels not yet uploaded are dropped. */
+    void clear();
+
+    /** Time spent uploading at each update (in ms) */
+    float budget_ms;
+    /** Maximal memory of the allocated levels (in bytes) */
+    size_t memory_budget;
+    /** Levels of at most resident_size texels (width and height) are kept */
+    GLsizei resident_size;
+
+private:
+    struct streamed_texture
+    {
+        GLuint id = 0;
+        GLenum target = GL_TEXTURE_2D;
+        texture_compression compression = texture_compression::none;
+        GLenum internal_format = GL_RGBA8; // known once decoded for an automatic compression
+        GLsizei width = 0;  // 0 until the dimension of a GL_TEXTURE_2D is known (decoded)
+        GLsizei height = 0;
+        GLsizei layers = 1;
+        GLint levels = 0;
+        GLint base_level = 0;      // finest complete level (levels: only the placeholder)
+        GLint allocated_level = 0; // finest level with a storage
+
+        // Upload cursor: next rows of (level, layer)
+        GLint level = 0;
+        GLsizei layer = 0;
+        GLsizei row = 0;
+
+        // Residency
+        bool managed = false;     // require() was called at least once
+        float demand = 0.0f;      // largest width required since the last update
+        float required_width = 0.0f; // width required at the last use
+        uint64_t last_use = 0;    // last update where the texture was required
+
+        // Source of the levels, decoded again when evicted levels are required
+        std::vector<std::string> filenames; // per layer
+        GLsizei decode_width = 0;           // resize of the images (0: no resize)
+        GLsizei decode_height = 0;
+        bool source_requested = false;
+        std::vector<compressed_texture> compressed;   // [layer] mipmap chain, written by the decoding threads
+        std::vector<bool> decoded;                    // per layer, protected by the mutex
+    };
+
+    void request_source(streamed_texture& texture);
+    void release_source(streamed_texture& texture);
+    void decode(streamed_texture* texture, GLsizei layer);
+    bool is_decoded(const streamed_texture& texture, GLsizei layer) const;
+    bool is_source_loaded(const streamed_texture& texture) const;
+    const unsigned char* level_data(const streamed_texture& texture, GLsizei layer, GLint level) const;
+    void allocate(streamed_texture& texture);
+    bool reserve(streamed_texture& texture);
+    bool evict_level(streamed_texture& texture);
+    bool upload_rows(streamed_texture& texture);
+    size_t level_memory(const streamed_texture& texture, GLint level) const;
+    GLint target_level(const streamed_texture& texture) const;
+
+    std::vector<std::unique_ptr<streamed_texture> > textures;
+    std::unordered_map<GLuint, streamed_texture*> texture_index; // element of textures from its id
+    size_t memory_allocated; // memory of the allocated levels of all the textures, updated at each allocation and eviction
+    GLuint pixel_buffer;
+    uint64_t frame;
+    mutable std::mutex mutex;
+    thread_pool workers; // last member: destroyed (joined) first
+};
+
+}
@@ -0,0 +1,496 @@
+#include "virtual_texture.hpp"
+
+#include "vcl/base/base.hpp"
+#include "vcl/opengl/uniform/uniform.hpp"
+#include "vcl/wrapper/lodepng/lodepng.hpp"
+#include "../image/image.hpp"
+#include "../texture_compressed/texture_compressed.hpp"
+#include "../procedural_texture/procedural_texture.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace vcl
+{
+
+// Tile identifier: (virtual texture, level, page y, page x) packed in 16, 8, 20 and 20 bits
+static uint64_t tile_key(unsigned int texture, unsigned int level, unsigned int x, unsigned int y)
+{
+    return (uint64_t(texture)<<48) | (uint64_t(level)<<40) | (uint64_t(y)<<20) | uint64_t(x);
+}
+static unsigned int key_texture(uint64_t key) { return unsigned(key>>48); }
+static unsigned int key_level(uint64_t key) { return unsigned(key>>40) & 0xFF; }
+static unsigned int key_y(uint64_t key) { return unsigned(key>>20) & 0xFFFFF; }
+static unsigned int key_x(uint64_t key) { return unsigned(key) & 0xFFFFF; }
+
+static const char page_file_magic[8] = {'v','c','l','p','a','g','e','2'}; // 2: levels of image_mipmaps in linear space
+
+// Header of a page file, followed by the tiles of each level (row by row)
+struct page_file_header
+{
+    char magic[8];
+    uint64_t source_size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t tile_size;
+    uint32_t tile_border;
+    uint32_t internal_format;
+    uint32_t levels;
+};
+
+// Tile of (size x size) texels starting at (x0,y0), the texels outside of the image are clamped to its edges
+static image_raw extract_tile(image_raw const& im, int x0, int y0, unsigned int size)
+{
+    image_raw tile(size, size, image_color_type::rgba, std::vector<unsigned char>(4*size_t(size)*size_t(size)));
+    for(unsigned int y=0; y<size; ++y) {
+        const int ys = std::min(std::max(y0+int(y), 0), int(im.height)-1);
+        for(unsigned int x=0; x<size; ++x) {
+            const int xs = std::min(std::max(x0+int(x), 0), int(im.width)-1);
+            std::memcpy(&tile.data[4*(size_t(y)*size+x)], &im.data[4*(size_t(ys)*im.width+size_t(xs))], 4);
+        }
+    }
+    return tile;
+}
+
+
+virtual_texture_system::virtual_texture_system(unsigned int width_arg, unsigned int height_arg, unsigned int tile_size_arg, GLsizei atlas_size, unsigned int number_threads)
+    :feedback_scale(8), tiles_per_update(16),
+      width(width_arg), height(height_arg), tile_size(tile_size_arg), tile_border(4), slot_size(tile_size_arg+8), levels(1), slots_per_row(0),
+      internal_format(GL_RGBA8), tile_bytes(0), atlas(0), page_table(0), page_table_layers(0),
+      feedback_framebuffer(0), feedback_color(0), feedback_depth(0), feedback_width(0), feedback_height(0), feedback_index(0),
+      saved_framebuffer(0), frame(0), workers(number_threads)
+{
+    // The borders keep the slots aligned on the 4x4 blocks of the compressed atlas
+    assert_vcl(tile_size%4==0, "The tile size must be a multiple of 4");
+    while(pages_x(levels-1)>1 || pages_y(levels-1)>1)
+        ++levels;
+    assert_vcl(levels<=255, "Too many levels of virtual texture");
+
+    // Slot coordinates are stored in 8 bits in the page table
+    slots_per_row = std::min(unsigned(atlas_size)/slot_size, 255u);
+    assert_vcl(slots_per_row>0, "The atlas is smaller than a tile");
+    slots.resize(size_t(slots_per_row)*slots_per_row);
+
+    internal_format = texture_compression_supported() ? texture_format_bc1 : GL_RGBA8;
+    tile_bytes = internal_format==GL_RGBA8 ? 4*size_t(slot_size)*slot_size : compressed_level_size(internal_format, slot_size, slot_size);
+
+    const GLsizei atlas_width = GLsizei(slots_per_row*slot_size);
+    glGenTextures(1, &atlas);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    if(internal_format==GL_RGBA8)
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlas_width, atlas_width, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    else
+        glCompressedTexImage2D(GL_TEXTURE_2D, 0, internal_format, atlas_width, atlas_width, 0, GLsizei(compressed_level_size(internal_format, unsigned(atlas_width), unsigned(atlas_width))), nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenTextures(1, &page_table);
+    glGenFramebuffers(1, &feedback_framebuffer);
+    glGenRenderbuffers(1, &feedback_color);
+    glGenRenderbuffers(1, &feedback_depth);
+    glGenBuffers(2, feedback_buffers);
+    feedback_pixels[0] = feedback_pixels[1] = 0;
+    saved_viewport[0] = saved_viewport[1] = saved_viewport[2] = saved_viewport[3] = 0;
+}
+
+unsigned int virtual_texture_system::level_width(unsigned int level) const
+{
+    return std::max(1u, width>>level);
+}
+
+unsigned int virtual_texture_system::level_height(unsigned int level) const
+{
+    return std::max(1u, height>>level);
+}
+
+unsigned int virtual_texture_system::pages_x(unsigned int level) const
+{
+    return (level_width(level)+tile_size-1)/tile_size;
+}
+
+unsigned int virtual_texture_system::pages_y(unsigned int level) const
+{
+    return (level_height(level)+tile_size-1)/tile_size;
+}
+
+int virtual_texture_system::add(const std::string& filename)
+{
+    assert_vcl(textures.size()<0xFFFF, "Too many virtual textures");
+    std::unique_ptr<page_file> pages(new page_file());
+    pages->filename = filename;
+    page_file* target = pages.get();
+    textures.push_back(std::move(pages));
+    workers.submit([this, target](){ build(target); });
+    return int(textures.size()-1);
+}
+
+void virtual_texture_system::build(page_file* pages)
+{
+    // Loading thread: the page file is only built if it is missing or was built for other parameters (generating the procedural fallback if needed)
+    const std::string source = procedural_texture_source(pages->filename);
+    const std::string cache_filename = source+".pages";
+    const uint64_t source_size = file_size(source);
+
+    std::vector<size_t> level_offset(levels);
+    size_t offset = sizeof(page_file_header);
+    for(unsigned int level=0; level<levels; ++level) {
+        level_offset[level] = offset;
+        offset += size_t(pages_x(level))*pages_y(level)*tile_bytes;
+    }
+
+    page_file_header header;
+    std::memcpy(header.magic, page_file_magic, 8);
+    header.source_size = source_size;
+    header.width = width;
+    header.height = height;
+    header.tile_size = tile_size;
+    header.tile_border = tile_border;
+    header.internal_format = internal_format;
+    header.levels = levels;
+
+    auto is_valid = [&](const file_mapping& file) {
+        return file.size()==offset && std::memcmp(file.data(), &header, sizeof(page_file_header))==0;
+    };
+
+    file_mapping file;
+    if(!file.open(cache_filename) || !is_valid(file)) {
+        file.close();
+        std::cout<<"Build page file "<<cache_filename<<std::endl;
+        image_raw im = image_load_png(source);
+        if(im.width!=width || im.height!=height)
+            im = image_resize(im, width, height);
+        const std::vector<image_raw> mipmaps = image_mipmaps(std::move(im));
+
+        const std::string written_filename = cache_file(cache_filename);
+        std::ofstream stream(written_filename, std::ios::binary);
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(page_file_header));
+        for(unsigned int level=0; level<levels; ++level) {
+            for(unsigned int y=0; y<pages_y(level); ++y) {
+                for(unsigned int x=0; x<pages_x(level); ++x) {
+                    const image_raw tile = extract_tile(mipmaps[level], int(x*tile_size)-int(tile_border), int(y*tile_size)-int(tile_border), slot_size);
+                    if(internal_format==GL_RGBA8)
+                        stream.write(reinterpret_cast<const char*>(&tile.data[0]), std::streamsize(tile_bytes));
+                    else {
+                        const std::vector<unsigned char> blocks = image_compress(tile, texture_compression::bc1);
+                        stream.write(reinterpret_cast<const char*>(&blocks[0]), std::streamsize(tile_bytes));
+                    }
+                }
+            }
+        }
+        stream.close();
+
+        if(!stream || !file.open(written_filename) || !is_valid(file)) {
+            std::cout<<"Cannot write page file "<<written_filename<<": the texture is not virtual"<<std::endl;
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    pages->file = std::move(file);
+    pages->level_offset = level_offset;
+    pages->ready = true;
+}
+
+void virtual_texture_system::request(uint64_t key, bool pinned)
+{
+    pending.insert(key);
+    if(pinned)
+        pending_pinned.insert(key);
+
+    // The tile is copied from the mapping on a loading thread: the disk is only read there
+    const page_file* pages = textures[key_texture(key)].get();
+    const unsigned int level = key_level(key);
+    const size_t offset = pages->level_offset[level] + (size_t(key_y(key))*pages_x(level)+key_x(key))*tile_bytes;
+    workers.submit([this, pages, key, offset]() {
+        loaded_tile tile;
+        tile.key = key;
+        tile.data.assign(pages->file.data()+offset, pages->file.data()+offset+tile_bytes);
+        std::lock_guard<std::mutex> lock(mutex);
+        loaded.push_back(std::move(tile));
+    });
+}
+
+void virtual_texture_system::begin_feedback(GLuint shader, GLsizei viewport_width, GLsizei viewport_height)
+{
+    const GLsizei w = std::max(GLsizei(1), viewport_width/GLsizei(feedback_scale));
+    const GLsizei h = std::max(GLsizei(1), viewport_height/GLsizei(feedback_scale));
+    glGetIntegerv(GL_VIEWPORT, saved_viewport);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &saved_framebuffer);
+
+    if(w!=feedback_width || h!=feedback_height) {
+        glBindRenderbuffer(GL_RENDERBUFFER, feedback_color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA16UI, w, h);
+        glBindRenderbuffer(GL_RENDERBUFFER, feedback_depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, feedback_framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, feedback_color);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, feedback_depth);
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER)!=GL_FRAMEBUFFER_COMPLETE)
+            std::cout<<"Incomplete virtual texture feedback framebuffer"<<std::endl;
+        feedback_width = w;
+        feedback_height = h;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, feedback_framebuffer);
+    glViewport(0, 0, w, h);
+    const GLuint no_page[4] = {0,0,0,0};
+    glClearBufferuiv(GL_COLOR, 0, no_page);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    // The derivatives of the texture coordinates are feedback_scale times larger than in the viewport
+    glUseProgram(shader);
+    glUniform2i(glGetUniformLocation(shader, "virtual_size"), GLint(width), GLint(height));
+    uniform(shader, "virtual_levels", int(levels));
+    uniform(shader, "tile_size", int(tile_size));
+    uniform(shader, "feedback_level_bias", -std::log2(float(viewport_width)/float(w)));
+}
+
+void virtual_texture_system::end_feedback()
+{
+    // Asynchronous read back: the pixel buffer is only mapped two feedbacks later
+    const size_t pixels = size_t(feedback_width)*size_t(feedback_height);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, feedback_buffers[feedback_index]);
+    glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(pixels*4*sizeof(uint16_t)), nullptr, GL_STREAM_READ);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, feedback_width, feedback_height, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    feedback_pixels[feedback_index] = pixels;
+    feedback_index = 1-feedback_index;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, GLuint(saved_framebuffer));
+    glViewport(saved_viewport[0], saved_viewport[1], saved_viewport[2], saved_viewport[3]);
+}
+
+void virtual_texture_system::read_feedback()
+{
+    const size_t pixels = feedback_pixels[feedback_index];
+    if(pixels==0)
+        return;
+    feedback_pixels[feedback_index] = 0;
+
+    // Pages seen in the feedback
+    std::unordered_set<uint64_t> visible;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, feedback_buffers[feedback_index]);
+    const uint16_t* texels = static_cast<const uint16_t*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(pixels*4*sizeof(uint16_t)), GL_MAP_READ_BIT));
+    if(texels!=nullptr) {
+        for(size_t k=0; k<pixels; ++k) {
+            const uint16_t* p = texels+4*k;
+            if(p[3]==0 || size_t(p[3])>textures.size())
+                continue;
+            const unsigned int level = std::min(unsigned(p[2]), levels-1);
+            visible.insert(tile_key(p[3]-1u, level, std::min(unsigned(p[0]), pages_x(level)-1), std::min(unsigned(p[1]), pages_y(level)-1)));
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // The visible tiles and their parents (displayed until the finer tiles are loaded) are used in this frame
+    std::unordered_set<uint64_t> touched;
+    std::vector<uint64_t> missing;
+    for(uint64_t key : visible) {
+        const unsigned int texture = key_texture(key);
+        unsigned int x = key_x(key), y = key_y(key);
+        for(unsigned int level=key_level(key); level<levels; ++level, x/=2, y/=2) {
+            const uint64_t k = tile_key(texture, level, std::min(x, pages_x(level)-1), std::min(y, pages_y(level)-1));
+            if(!touched.insert(k).second)
+                break;
+            auto it = resident.find(k);
+            if(it!=resident.end())
+                slots[it->second].last_use = frame;
+            else if(pending.count(k)==0 && textures[texture]->pinned)
+                missing.push_back(k);
+        }
+    }
+
+    // Coarsest tiles first: they replace the largest areas of fallback
+    std::sort(missing.begin(), missing.end(), [](uint64_t a, uint64_t b){ return key_level(a)>key_level(b); });
+    const size_t max_pending = 4*size_t(tiles_per_update);
+    for(size_t k=0; k<missing.size() && pending.size()<max_pending; ++k)
+        request(missing[k], false);
+}
+
+void virtual_texture_system::upload(loaded_tile& tile)
+{
+    const bool pinned = pending_pinned.erase(tile.key)>0;
+    pending.erase(tile.key);
+
+    // A free slot, otherwise the least recently used one (not used in this frame)
+    size_t slot = slots.size();
+    for(size_t k=0; k<slots.size(); ++k) {
+        const tile_slot& s = slots[k];
+        if(!s.used) {
+            slot = k;
+            break;
+        }
+        if(!s.pinned && s.last_use<frame && (slot==slots.size() || s.last_use<slots[slot].last_use))
+            slot = k;
+    }
+    if(slot==slots.size())
+        return; // all the tiles are visible: the coarser ones are kept
+
+    tile_slot& s = slots[slot];
+    if(s.used) {
+        resident.erase(s.key);
+        textures[key_texture(s.key)]->dirty = true;
+    }
+    s.key = tile.key;
+    s.last_use = frame;
+    s.used = true;
+    s.pinned = pinned;
+    resident[tile.key] = slot;
+    textures[key_texture(tile.key)]->dirty = true;
+
+    const GLint x = GLint((slot%slots_per_row)*slot_size);
+    const GLint y = GLint((slot/slots_per_row)*slot_size);
+    if(internal_format==GL_RGBA8)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, GLsizei(slot_size), GLsizei(slot_size), GL_RGBA, GL_UNSIGNED_BYTE, &tile.data[0]);
+    else
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, x, y, GLsizei(slot_size), GLsizei(slot_size), internal_format, GLsizei(tile_bytes), &tile.data[0]);
+}
+
+void virtual_texture_system::update_page_table(int index)
+{
+    // Each page points to its resident tile, or to the entry of its parent page
+    std::vector<std::vector<unsigned char> > entries(levels);
+    for(int level=int(levels)-1; level>=0; --level) {
+        const unsigned int nx = pages_x(unsigned(level)), ny = pages_y(unsigned(level));
+        std::vector<unsigned char>& entry = entries[size_t(level)];
+        entry.assign(4*size_t(nx)*ny, 0);
+        for(unsigned int y=0; y<ny; ++y) {
+            for(unsigned int x=0; x<nx; ++x) {
+                unsigned char* e = &entry[4*(size_t(y)*nx+x)];
+                auto it = resident.find(tile_key(unsigned(index), unsigned(level), x, y));
+                if(it!=resident.end()) {
+                    e[0] = static_cast<unsigned char>(it->second%slots_per_row);
+                    e[1] = static_cast<unsigned char>(it->second/slots_per_row);
+                    e[2] = static_cast<unsigned char>(level);
+                    e[3] = 1;
+                }
+                else if(unsigned(level)+1<levels) {
+                    const unsigned int px = pages_x(unsigned(level)+1), py = pages_y(unsigned(level)+1);
+                    std::memcpy(e, &entries[size_t(level)+1][4*(size_t(std::min(y/2,py-1))*px+std::min(x/2,px-1))], 4);
+                }
+            }
+        }
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, GLint(unsigned(index)*levels+unsigned(level)), GLsizei(nx), GLsizei(ny), 1, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, &entry[0]);
+    }
+}
+
+void virtual_texture_system::update()
+{
+    ++frame;
+
+    // Tiles of the coarsest level, once the page file is ready
+    for(size_t k=0; k<textures.size(); ++k) {
+        page_file& pages = *textures[k];
+        if(pages.pinned)
+            continue;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(!pages.ready)
+                continue;
+        }
+        for(unsigned int y=0; y<pages_y(levels-1); ++y)
+            for(unsigned int x=0; x<pages_x(levels-1); ++x)
+                request(tile_key(unsigned(k), levels-1, x, y), true);
+        pages.pinned = true;
+    }
+
+    read_feedback();
+
+    std::vector<loaded_tile> tiles;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while(!loaded.empty() && tiles.size()<tiles_per_update) {
+            tiles.push_back(std::move(loaded.front()));
+            loaded.pop_front();
+        }
+    }
+    if(!tiles.empty()) {
+        glBindTexture(GL_TEXTURE_2D, atlas);
+        for(loaded_tile& tile : tiles)
+            upload(tile);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // The page table has a layer per level of each virtual texture
+    glBindTexture(GL_TEXTURE_2D_ARRAY, page_table);
+    const GLsizei layers = GLsizei(textures.size()*levels);
+    if(layers>page_table_layers) {
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8UI, GLsizei(pages_x(0)), GLsizei(pages_y(0)), layers, 0, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        page_table_layers = layers;
+        for(auto& pages : textures)
+            pages->dirty = true;
+    }
+    for(size_t k=0; k<textures.size(); ++k) {
+        if(textures[k]->dirty) {
+            update_page_table(int(k));
+            textures[k]->dirty = false;
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void virtual_texture_system::bind(GLuint shader) const
+{
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, page_table);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glActiveTexture(GL_TEXTURE0);
+
+    glUseProgram(shader);
+    uniform(shader, "page_table", 1);
+    uniform(shader, "tile_atlas", 2);
+    glUniform2i(glGetUniformLocation(shader, "virtual_size"), GLint(width), GLint(height));
+    uniform(shader, "virtual_levels", int(levels));
+    uniform(shader, "tile_size", int(tile_size));
+    uniform(shader, "tile_border", int(tile_border));
+    uniform(shader, "slot_size", int(slot_size));
+}
+
+size_t virtual_texture_system::resident_tiles() const
+{
+    return resident.size();
+}
+
+size_t virtual_texture_system::capacity() const
+{
+    return slots.size();
+}
+
+void virtual_texture_system::clear()
+{
+    workers.cancel();
+    loaded.clear();
+    pending.clear();
+    pending_pinned.clear();
+    resident.clear();
+    textures.clear();
+    slots.assign(slots.size(), tile_slot());
+
+    glDeleteTextures(1, &atlas);
+    glDeleteTextures(1, &page_table);
+    glDeleteFramebuffers(1, &feedback_framebuffer);
+    glDeleteRenderbuffers(1, &feedback_color);
+    glDeleteRenderbuffers(1, &feedback_depth);
+    glDeleteBuffers(2, feedback_buffers);
+    atlas = page_table = feedback_framebuffer = feedback_color = feedback_depth = 0;
+    feedback_buffers[0] = feedback_buffers[1] = 0;
+    feedback_pixels[0] = feedback_pixels[1] = 0;
+    page_table_layers = 0;
+}
+
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "vcl/wrapper/glad/glad.hpp"
+#include "vcl/base/thread_pool/thread_pool.hpp"
+#include "vcl/base/file_mapping/file_mapping.hpp"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <cstdint>
+
+namespace vcl
+{
+
+/** Virtual texturing: textures larger than what can be kept on the GPU, of which only the visible tiles are resident.
+ *
+ * Each virtual texture of (width,height) texels is split, at each mipmap level, in pages of tile_size x tile_size texels.
+ *  - Page file: the tiles of all the levels, with a border of tile_border texels (bilinear filtering across the tiles),
+ *    built once from the png file and cached in filename+".pages" (bc1 tiles if the driver supports S3TC, rgba otherwise).
+ *    It is mapped: only the tiles loaded are read from the disk.
+ *  - Tile atlas: GL_TEXTURE_2D of atlas_size x atlas_size texels, split in slots holding one tile each (least recently used replaced first).
+ *  - Page table: GL_TEXTURE_2D_ARRAY (GL_RGBA8UI), layer = virtual texture*levels + level, one texel per page:
+ *    (slot x, slot y, level of the tile, 1) of the finest resident tile covering the page, (0,0,0,0) if none.
+ *    The tiles of the coarsest level are never evicted, so that every page has a tile once they are loaded.
+ *  - Feedback: the objects are drawn in a small framebuffer where each pixel stores the page it needs (page x, page y, level, virtual texture+1).
+ *    The framebuffer is read back asynchronously, the missing tiles are loaded on worker threads and sent to the atlas during update().
+ *
+ * Shaders: the mesh shader variant with shader_virtual_texture samples the instances having a virtual texture index >= 0 through the page table,
+ *  and falls back to the texture array while no tile is resident. The uniforms and textures are set by bind().
+ * The OpenGL calls only happen in the constructor, begin_feedback, end_feedback, update, bind and clear, on the thread of the context. */
+struct virtual_texture_system
+{
+    /** Virtual textures of (width,height) texels, and tile cache of (atlas_size x atlas_size) texels.
+     * number_threads=0: one loading thread per hardware thread */
+    explicit virtual_texture_system(unsigned int width=8192, unsigned int height=4096, unsigned int tile_size=128, GLsizei atlas_size=4096, unsigned int number_threads=0);
+    virtual_texture_system(const virtual_texture_system&) = delete;
+    virtual_texture_system& operator=(const virtual_texture_system&) = delete;
+
+    /** Add a virtual texture from a png file (resized to the virtual dimension), return its index.
+     * Its page file is built on a worker thread if needed (as well as its procedural fallback, see procedural_texture_source). */
+    int add(const std::string& filename);
+
+    /** Start the feedback pass over a viewport of (width,height) pixels: the objects using the virtual textures must then be drawn with shader */
+    void begin_feedback(GLuint shader, GLsizei viewport_width, GLsizei viewport_height);
+    /** End the feedback pass: the result is read back without waiting for the GPU, and used by a following update() */
+    void end_feedback();
+
+    /** Request the tiles seen in the feedback, send the loaded tiles to the atlas and update the page tables (typically once per frame) */
+    void update();
+
+    /** Bind the page table (texture unit 1) and the tile atlas (texture unit 2) and set the uniforms of a shader sampling the virtual textures */
+    void bind(GLuint shader) const;
+
+    /** Drop the loadings not started yet, wait for the running ones, and release the OpenGL objects */
+    void clear();
+
+    /** Number of tiles resident in the atlas */
+    size_t resident_tiles() const;
+    /** Number of tiles of the atlas */
+    size_t capacity() const;
+
+    /** The feedback framebuffer is feedback_scale times smaller than the viewport */
+    unsigned int feedback_scale;
+    /** Maximal number of tiles sent to the atlas at each update */
+    unsigned int tiles_per_update;
+
+private:
+    struct page_file
+    {
+        std::string filename;
+        file_mapping file;
+        std::vector<size_t> level_offset; // offset of the first tile of each level in the file
+        bool ready = false;               // page file built and mapped, protected by the mutex
+        bool pinned = false;              // tiles of the coarsest level requested
+        bool dirty = true;                // page table to update
+    };
+    struct tile_slot
+    {
+        uint64_t key = 0;
+        uint64_t last_use = 0;
+        bool used = false;
+        bool pinned = false;
+    };
+    struct loaded_tile
+    {
+        uint64_t key;
+        std::vector<unsigned char> data;
+    };
+
+    void build(page_file* pages);
+    void request(uint64_t key, bool pinned);
+    void read_feedback();
+    void upload(loaded_tile& tile);
+    void update_page_table(int index);
+    unsigned int level_width(unsigned int level) const;
+    unsigned int level_height(unsigned int level) const;
+    unsigned int pages_x(unsigned int level) const;
+    unsigned int pages_y(unsigned int level) const;
+
+    unsigned int width;
+    unsigned int height;
+    unsigned int tile_size;
+    unsigned int tile_border;
+    unsigned int slot_size;
+    unsigned int levels;
+    unsigned int slots_per_row;
+    GLenum internal_format; // of the tiles in the page files and in the atlas
+    size_t tile_bytes;
+
+    GLuint atlas;
+    GLuint page_table;
+    GLsizei page_table_layers;
+    GLuint feedback_framebuffer;
+    GLuint feedback_color;
+    GLuint feedback_depth;
+    GLsizei feedback_width;
+    GLsizei feedback_height;
+    GLuint feedback_buffers[2];
+    size_t feedback_pixels[2];     // pixels read in each buffer, 0 if none
+    unsigned int feedback_index;   // next buffer written, and read by update (the oldest)
+    GLint saved_viewport[4];
+    GLint saved_framebuffer;
+
+    std::vector<std::unique_ptr<page_file> > textures;
+    std::vector<tile_slot> slots;
+    std::unordered_map<uint64_t, size_t> resident;   // tile key -> slot
+    std::unordered_set<uint64_t> pending;            // requested, not yet in the atlas
+    std::unordered_set<uint64_t> pending_pinned;
+    std::deque<loaded_tile> loaded;                  // read by the worker threads, protected by the mutex
+    uint64_t frame;
+    mutable std::mutex mutex;
+    thread_pool workers; // last member: destroyed (joined) first
+};
+
+}
@@ -0,0 +1,33 @@
+#include "floating_origin.hpp"
+
+namespace vcl
+{
+
+floating_origin::floating_origin()
+    :origin(make_dvec3(0,0,0))
+{}
+
+void floating_origin::recenter(camera_scene& camera)
+{
+    // The camera targets the point -translation (relative to the current origin)
+    origin = origin - to_dvec3(camera.translation);
+    camera.translation = {0,0,0};
+}
+
+void floating_origin::set(const dvec3& world_position, camera_scene& camera)
+{
+    origin = world_position;
+    camera.translation = {0,0,0};
+}
+
+vec3 floating_origin::relative(const dvec3& world_position) const
+{
+    return to_vec3(world_position-origin);
+}
+
+dvec3 floating_origin::world(const vec3& relative_position) const
+{
+    return origin + to_dvec3(relative_position);
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "vcl/math/vec/dvec3/dvec3.hpp"
+#include "vcl/interaction/camera/camera.hpp"
+
+namespace vcl
+{
+
+/** Floating origin of the rendered scene.
+ * World positions are stored in double precision, and the scene sent to the GPU is expressed relatively to an origin placed on the point targeted by the camera.
+ * The shaders only receive small camera-relative float coordinates, which avoids the loss of precision far from (0,0,0).
+ * Usage at every frame: recenter(camera) (or set(...)), then relative(p) for each position sent to the GPU. */
+struct floating_origin
+{
+    floating_origin();
+
+    /** Absorb the camera translation in the origin: the camera target becomes the new origin and the camera translation is reset to 0 */
+    void recenter(camera_scene& camera);
+    /** Place the origin (and the camera target) on a world position */
+    void set(const dvec3& world_position, camera_scene& camera);
+
+    /** Coordinates relative to the origin, to be sent to the GPU */
+    vec3 relative(const dvec3& world_position) const;
+    /** World coordinates of a position relative to the origin */
+    dvec3 world(const vec3& relative_position) const;
+
+    dvec3 origin;
+};
+
+}
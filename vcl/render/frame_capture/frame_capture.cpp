@@ -0,0 +1,149 @@
+#include "frame_capture.hpp"
+
+#include "vcl/opengl/opengl.hpp"
+#include "vcl/wrapper/lodepng/lodepng.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+
+namespace vcl
+{
+
+frame_capture::frame_capture()
+    :frames_captured(0), current(0), width(0), height(0), prefix(), format(frame_capture_format::png), encoders()
+{
+    for(unsigned int k=0; k<ring_size; ++k) {
+        pbo[k] = 0;
+        fence[k] = nullptr;
+        frame_index[k] = 0;
+    }
+}
+
+frame_capture::~frame_capture()
+{
+    // The GPU buffers are released by stop() (the context may no longer exist here)
+    if(encoders)
+        encoders->wait();
+}
+
+void frame_capture::start(const std::string& prefix_arg, frame_capture_format format_arg, unsigned int number_threads)
+{
+    if(running())
+        stop();
+    prefix = prefix_arg;
+    format = format_arg;
+    frames_captured = 0;
+    current = 0;
+    encoders.reset(new thread_pool(number_threads));
+}
+
+bool frame_capture::running() const
+{
+    return encoders!=nullptr;
+}
+
+void frame_capture::resize(GLsizei width_arg, GLsizei height_arg)
+{
+    width = width_arg;
+    height = height_arg;
+    for(unsigned int k=0; k<ring_size; ++k) {
+        if(pbo[k]==0)
+            glGenBuffers(1, &pbo[k]);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[k]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(width)*height*4, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void frame_capture::capture()
+{
+    if(!running())
+        return;
+
+    GLint viewport[4] = {0,0,0,0};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if(pbo[0]==0 || viewport[2]!=width || viewport[3]!=height) {
+        // Write the frames of the previous size before reallocating the ring
+        for(unsigned int k=0; k<ring_size; ++k)
+            write_slot((current+k)%ring_size);
+        resize(viewport[2], viewport[3]);
+    }
+
+    // The slot still holds the frame captured ring_size frames ago: its copy is done by now
+    write_slot(current);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[current]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr); // asynchronous copy into the buffer
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    fence[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame_index[current] = frames_captured++;
+
+    current = (current+1)%ring_size;
+}
+
+void frame_capture::write_slot(unsigned int slot)
+{
+    if(fence[slot]==nullptr)
+        return;
+
+    glClientWaitSync(fence[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+    glDeleteSync(fence[slot]);
+    fence[slot] = nullptr;
+
+    const size_t row_size = size_t(width)*4;
+    std::shared_ptr<std::vector<unsigned char> > pixels = std::make_shared<std::vector<unsigned char> >(row_size*size_t(height));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[slot]);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(pixels->size()), GL_MAP_READ_BIT);
+    // OpenGL rows go from bottom to top: flipped during the copy out of the buffer
+    if(mapped!=nullptr)
+        image_flip_rows(static_cast<const unsigned char*>(mapped), &(*pixels)[0], row_size, size_t(height));
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if(mapped==nullptr)
+        return;
+
+    // Bound the memory of the frames waiting for an encoder: only the oldest frames need to be written
+    encoders->wait_pending(2*encoders->size());
+
+    char number[16];
+    std::snprintf(number, sizeof(number), "%06u", frame_index[slot]);
+    const std::string filename = prefix + number + (format==frame_capture_format::png ? ".png" : ".rgba");
+    const unsigned int w = static_cast<unsigned int>(width);
+    const unsigned int h = static_cast<unsigned int>(height);
+    const frame_capture_format format_job = format;
+
+    encoders->submit([pixels, filename, w, h, format_job]()
+    {
+        if(format_job==frame_capture_format::png)
+            image_save_png(filename, image_raw(w, h, image_color_type::rgba, std::move(*pixels)));
+        else {
+            std::ofstream stream(filename, std::ios::binary);
+            stream.write(reinterpret_cast<const char*>(&(*pixels)[0]), std::streamsize(pixels->size()));
+        }
+    });
+}
+
+void frame_capture::stop()
+{
+    if(!running())
+        return;
+
+    // Oldest frames first
+    for(unsigned int k=0; k<ring_size; ++k)
+        write_slot((current+k)%ring_size);
+    encoders->wait();
+    encoders.reset();
+
+    for(unsigned int k=0; k<ring_size; ++k) {
+        glDeleteBuffers(1, &pbo[k]);
+        pbo[k] = 0;
+    }
+    width = 0;
+    height = 0;
+    std::cout<<"Captured "<<frames_captured<<" frames ("<<prefix<<"*)"<<std::endl;
+}
+
+}
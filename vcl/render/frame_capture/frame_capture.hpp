@@ -0,0 +1,54 @@
+#pragma once
+
+#include "vcl/wrapper/glad/glad.hpp"
+#include "vcl/base/thread_pool/thread_pool.hpp"
+
+#include <string>
+#include <memory>
+
+namespace vcl
+{
+
+/** File format of the captured frames
+ * - png: encoded with image_save_png
+ * - raw: RGBA 8 bits, rows from top to bottom, without header (ex. ffmpeg -f rawvideo -pixel_format rgba -video_size WxH -i frame_%06d.rgba) */
+enum class frame_capture_format {png, raw};
+
+/** Capture of the displayed frames to an image sequence without stalling the rendering.
+ * Each frame is read back asynchronously into a ring of pixel buffer objects, and mapped a few frames later when the copy is done.
+ * The pixels are then encoded and written by a pool of background threads.
+ * If the encoders cannot follow, the capture waits until the oldest frame is written (frames are never dropped). */
+struct frame_capture
+{
+    frame_capture();
+    ~frame_capture();
+
+    /** Start writing the frames as [prefix][frame number].png (or .rgba) */
+    void start(const std::string& prefix, frame_capture_format format=frame_capture_format::png, unsigned int number_threads=0);
+    /** Read back the current framebuffer (to be called before the GUI is drawn and the buffers are swapped) */
+    void capture();
+    /** Write the frames still in the ring, and wait for the encoders */
+    void stop();
+
+    bool running() const;
+
+    unsigned int frames_captured;
+
+private:
+    void resize(GLsizei width, GLsizei height);
+    void write_slot(unsigned int slot);
+
+    static const unsigned int ring_size = 3;
+    GLuint pbo[ring_size];
+    GLsync fence[ring_size];
+    unsigned int frame_index[ring_size];
+    unsigned int current;
+    GLsizei width;
+    GLsizei height;
+
+    std::string prefix;
+    frame_capture_format format;
+    std::unique_ptr<thread_pool> encoders;
+};
+
+}
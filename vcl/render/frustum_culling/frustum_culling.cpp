@@ -0,0 +1,64 @@
+#include "frustum_culling.hpp"
+
+namespace vcl
+{
+
+frustum camera_frustum(const camera_scene& camera)
+{
+    return frustum_from_matrix(camera.perspective.matrix()*camera.view_matrix());
+}
+
+void frustum_culling::clear()
+{
+    x.clear();
+    y.clear();
+    z.clear();
+    radius.clear();
+    visible.clear();
+}
+
+void frustum_culling::add(const bounding_sphere& sphere)
+{
+    x.push_back(sphere.center.x);
+    y.push_back(sphere.center.y);
+    z.push_back(sphere.center.z);
+    radius.push_back(sphere.radius);
+}
+
+size_t frustum_culling::run(const frustum& f)
+{
+    const size_t N = x.size();
+    visible.resize(N);
+    if(N==0)
+        return 0;
+
+    frustum_test(f, &x[0], &y[0], &z[0], &radius[0], N, &visible[0]);
+
+    size_t counter = 0;
+    for(size_t k=0; k<N; ++k)
+        counter += visible[k];
+    return counter;
+}
+
+size_t cull_instances(buffer<mesh_instance>& instances, const bounding_sphere& geometry, const frustum& f)
+{
+    const size_t N = instances.size();
+
+    frustum_culling culling;
+    for(size_t k=0; k<N; ++k) {
+        const mesh_instance& instance = instances[k];
+        culling.add( transform(geometry, affine_transform(instance.translation, instance.rotation, instance.scaling)) );
+    }
+    culling.run(f);
+
+    // Compact the visible instances at the beginning of the buffer
+    size_t counter = 0;
+    for(size_t k=0; k<N; ++k)
+        if(culling.visible[k])
+            instances[counter++] = instances[k];
+    instances.resize(counter);
+
+    return N-counter;
+}
+
+}
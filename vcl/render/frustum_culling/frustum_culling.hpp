@@ -0,0 +1,32 @@
+#pragma once
+
+#include "vcl/math/math.hpp"
+#include "vcl/interaction/camera/camera.hpp"
+#include "vcl/shape/mesh/mesh_drawable_instanced/mesh_drawable_instanced.hpp"
+
+#include <vector>
+
+namespace vcl
+{
+
+/** Frustum seen by the camera (extracted from perspective * view) */
+frustum camera_frustum(const camera_scene& camera);
+
+/** Batch of bounding spheres stored as structure of arrays, tested together against a frustum.
+ * Usage: clear() / add(sphere) for every element / run(frustum) / read visible[k] */
+struct frustum_culling
+{
+    void clear();
+    void add(const bounding_sphere& sphere);
+    /** Fill visible[k] (1: intersects the frustum, 0: outside) and return the number of visible spheres */
+    size_t run(const frustum& f);
+
+    std::vector<float> x, y, z, radius;
+    std::vector<unsigned char> visible;
+};
+
+/** Remove the instances outside of the frustum. Each instance is bounded by the geometry sphere placed with its transform.
+ * Return the number of removed instances */
+size_t cull_instances(buffer<mesh_instance>& instances, const bounding_sphere& geometry, const frustum& f);
+
+}
@@ -0,0 +1,57 @@
+#include "gpu_timer.hpp"
+
+namespace vcl
+{
+
+gpu_timer::gpu_timer()
+    :milliseconds(0.0f), queries(), pending(), current(0)
+{}
+
+void gpu_timer::begin()
+{
+    if(queries[0]==0)
+        glGenQueries(number_queries, queries);
+
+    // Read the oldest query before reusing it
+    if(pending[current]) {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[current], GL_QUERY_RESULT, &elapsed);
+        milliseconds = float(elapsed)*1e-6f;
+        pending[current] = false;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+}
+
+void gpu_timer::end()
+{
+    glEndQuery(GL_TIME_ELAPSED);
+    pending[current] = true;
+    current = (current+1)%number_queries;
+
+    // Update the measure as soon as a result is available
+    for(unsigned int k=0; k<number_queries; ++k) {
+        const unsigned int index = (current+k)%number_queries;
+        if(!pending[index])
+            continue;
+        GLint available = 0;
+        glGetQueryObjectiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(available==0)
+            break;
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &elapsed);
+        milliseconds = float(elapsed)*1e-6f;
+        pending[index] = false;
+    }
+}
+
+void gpu_timer::clear()
+{
+    if(queries[0]!=0)
+        glDeleteQueries(number_queries, queries);
+    for(unsigned int k=0; k<number_queries; ++k) {
+        queries[k] = 0;
+        pending[k] = false;
+    }
+}
+
+}
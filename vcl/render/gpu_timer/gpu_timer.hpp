@@ -0,0 +1,28 @@
+#pragma once
+
+#include "vcl/wrapper/glad/glad.hpp"
+
+namespace vcl
+{
+
+/** Time spent by the GPU on the commands issued between begin() and end() (GL_TIME_ELAPSED queries).
+ * The queries are read back a few frames later to avoid stalling the pipeline: milliseconds is the last available measure.
+ * Only one timer can be active at a time. */
+struct gpu_timer
+{
+    gpu_timer();
+
+    void begin();
+    void end();
+    void clear();
+
+    float milliseconds;
+
+private:
+    static const unsigned int number_queries = 4;
+    GLuint queries[number_queries];
+    bool pending[number_queries];
+    unsigned int current;
+};
+
+}
@@ -0,0 +1,53 @@
+#include "level_of_detail.hpp"
+
+#include "vcl/render/render_queue/render_queue.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace vcl
+{
+
+float screen_radius(const bounding_sphere& sphere, const camera_scene& camera, float viewport_height)
+{
+    const float depth = view_depth(sphere.center, camera);
+    if(depth<=sphere.radius)
+        return std::numeric_limits<float>::max();
+
+    const float tan_half_angle = std::tan(camera.perspective.angle_of_view/2);
+    return sphere.radius/(depth*tan_half_angle) * viewport_height/2;
+}
+
+level_of_detail::level_of_detail()
+    :min_screen_radius({0.0f}), hysteresis(0.25f)
+{}
+
+level_of_detail::level_of_detail(const std::vector<float>& min_screen_radius_arg, float hysteresis_arg)
+    :min_screen_radius(min_screen_radius_arg), hysteresis(hysteresis_arg)
+{
+    assert_vcl(min_screen_radius.size()>0, "A level of detail chain needs at least one level");
+}
+
+unsigned int level_of_detail::select(float radius, unsigned int current_level) const
+{
+    const unsigned int N = number_of_levels();
+    unsigned int level = std::min(current_level, N-1);
+
+    // Finer levels: switch as soon as the threshold is reached
+    while( level+1<N && radius>=min_screen_radius[level+1] )
+        ++level;
+
+    // Coarser levels: switch only when the radius is clearly below the threshold
+    while( level>0 && radius<(1-hysteresis)*min_screen_radius[level] )
+        --level;
+
+    return level;
+}
+
+unsigned int level_of_detail::number_of_levels() const
+{
+    return static_cast<unsigned int>(min_screen_radius.size());
+}
+
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "vcl/math/math.hpp"
+#include "vcl/interaction/camera/camera.hpp"
+
+#include <vector>
+
+namespace vcl
+{
+
+/** Radius (in pixels) of the sphere projected on a viewport of the given height.
+ * Return a very large value if the camera is inside the sphere. */
+float screen_radius(const bounding_sphere& sphere, const camera_scene& camera, float viewport_height);
+
+/** Selection of a level in a chain of increasingly detailed meshes from the projected screen radius.
+ * Level k is used when the screen radius is above min_screen_radius[k] (values are expected to be increasing, starting at 0).
+ * A finer level is selected as soon as its threshold is reached, while a coarser level is only selected once the radius
+ * gets below (1-hysteresis) times the current threshold: this avoids popping when the size oscillates around a threshold. */
+struct level_of_detail
+{
+    level_of_detail();
+    level_of_detail(const std::vector<float>& min_screen_radius, float hysteresis=0.25f);
+
+    /** Return the level to use given the level selected at the previous frame */
+    unsigned int select(float screen_radius, unsigned int current_level) const;
+    unsigned int number_of_levels() const;
+
+    std::vector<float> min_screen_radius;
+    float hysteresis;
+};
+
+}
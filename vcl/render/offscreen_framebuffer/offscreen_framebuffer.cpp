@@ -0,0 +1,56 @@
+#include "offscreen_framebuffer.hpp"
+
+#include "vcl/base/base.hpp"
+
+namespace vcl
+{
+
+offscreen_framebuffer::offscreen_framebuffer()
+    :fbo(0), color(0), depth(0), width(0), height(0)
+{}
+
+offscreen_framebuffer::offscreen_framebuffer(GLsizei width_arg, GLsizei height_arg)
+    :fbo(0), color(0), depth(0), width(width_arg), height(height_arg)
+{
+    glGenRenderbuffers(1, &color);
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    // Same format as the default framebuffer: the depth can be blitted (see weighted_blended_oit)
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+    assert_vcl(glCheckFramebufferStatus(GL_FRAMEBUFFER)==GL_FRAMEBUFFER_COMPLETE, "Incomplete offscreen framebuffer");
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void offscreen_framebuffer::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, width, height);
+}
+
+void offscreen_framebuffer::clear()
+{
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &color);
+    glDeleteRenderbuffers(1, &depth);
+    fbo = color = depth = 0;
+}
+
+std::vector<unsigned char> offscreen_framebuffer::read_pixels() const
+{
+    std::vector<unsigned char> pixels(size_t(width)*size_t(height)*4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+    return pixels;
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "vcl/wrapper/glad/glad.hpp"
+
+#include <vector>
+
+namespace vcl
+{
+
+/** Framebuffer object with a color (RGBA8) and a depth-stencil target, used as the image of a headless context (see egl_headless_init).
+ * bind() makes it the target of the following draw calls in place of the default framebuffer, with a viewport covering the whole image. */
+struct offscreen_framebuffer
+{
+    offscreen_framebuffer();
+    offscreen_framebuffer(GLsizei width, GLsizei height);
+
+    void bind() const;
+    void clear();
+
+    /** Copy the color image to the CPU (RGBA, rows from bottom to top) */
+    std::vector<unsigned char> read_pixels() const;
+
+    GLuint fbo;
+    GLuint color;
+    GLuint depth;
+    GLsizei width;
+    GLsizei height;
+};
+
+}
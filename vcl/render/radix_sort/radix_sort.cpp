@@ -0,0 +1,60 @@
+#include "radix_sort.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace vcl
+{
+
+void radix_sort(const std::vector<uint64_t>& keys, std::vector<uint32_t>& order, std::vector<uint32_t>& scratch)
+{
+    const size_t N = keys.size();
+    order.resize(N);
+    scratch.resize(N);
+    for(size_t k=0; k<N; ++k)
+        order[k] = uint32_t(k);
+    if(N<2)
+        return;
+    // Below 96 keys the histograms cost more than a comparison sort
+    if(N<96) {
+        std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b){ return keys[a]<keys[b]; });
+        return;
+    }
+
+    // Histograms of the 8 bytes
+    uint32_t histogram[8][256];
+    std::memset(histogram, 0, sizeof(histogram));
+    for(const uint64_t key : keys)
+        for(unsigned int b=0; b<8; ++b)
+            histogram[b][(key>>(8*b)) & 0xff]++;
+
+    for(unsigned int b=0; b<8; ++b)
+    {
+        // All keys share the same byte: the pass would not change the order
+        const uint32_t first_bucket = histogram[b][(keys[0]>>(8*b)) & 0xff];
+        if(first_bucket==N)
+            continue;
+
+        uint32_t offset[256];
+        uint32_t sum = 0;
+        for(unsigned int i=0; i<256; ++i) {
+            offset[i] = sum;
+            sum += histogram[b][i];
+        }
+
+        for(size_t k=0; k<N; ++k) {
+            const uint32_t index = order[k];
+            const unsigned int bucket = (keys[index]>>(8*b)) & 0xff;
+            scratch[offset[bucket]++] = index;
+        }
+        order.swap(scratch);
+    }
+}
+
+void radix_sort(const std::vector<uint64_t>& keys, std::vector<uint32_t>& order)
+{
+    std::vector<uint32_t> scratch;
+    radix_sort(keys, order, scratch);
+}
+
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+namespace vcl
+{
+
+/** Stable LSD radix sort of 64-bit keys (8 passes of 8 bits).
+ * order receives the sorting permutation: keys[order[0]] <= keys[order[1]] <= ...
+ * The histograms of all bytes are computed in a single traversal, and the passes on bytes shared by all keys are skipped.
+ * Small arrays (less than 96 keys), for which the histograms dominate, are sorted with std::stable_sort: both sorts take about the same time at 96 keys.
+ * scratch is a temporary buffer that can be kept between calls to avoid allocations. */
+void radix_sort(const std::vector<uint64_t>& keys, std::vector<uint32_t>& order, std::vector<uint32_t>& scratch);
+void radix_sort(const std::vector<uint64_t>& keys, std::vector<uint32_t>& order);
+
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "render_queue/render_queue.hpp"
+#include "frustum_culling/frustum_culling.hpp"
+#include "level_of_detail/level_of_detail.hpp"
+#include "floating_origin/floating_origin.hpp"
+#include "sphere_shadows/sphere_shadows.hpp"
+#include "offscreen_framebuffer/offscreen_framebuffer.hpp"
+#include "frame_capture/frame_capture.hpp"
@@ -0,0 +1,230 @@
+#include "render_queue.hpp"
+
+#include "vcl/opengl/opengl.hpp"
+#include "vcl/render/radix_sort/radix_sort.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace vcl
+{
+
+static uint32_t depth_bits(float depth)
+{
+    // The binary representation of a positive float is ordered as an unsigned integer
+    depth = std::max(depth, 0.0f);
+    uint32_t bits = 0;
+    std::memcpy(&bits, &depth, sizeof(float));
+    return bits;
+}
+
+uint64_t render_sort_key(render_pass pass, GLuint shader, GLuint texture_id, float depth)
+{
+    const uint64_t p = uint64_t(pass) & 0x3;
+    const uint64_t s = uint64_t(shader) & 0xfff;
+    const uint64_t t = uint64_t(texture_id) & 0x3ffff;
+    const uint64_t d = depth_bits(depth);
+
+    if(pass==render_pass::transparent)
+        return (p<<62) | ((~d & 0xffffffff)<<30) | (s<<18) | t;
+    return (p<<62) | (s<<50) | (t<<32) | d;
+}
+
+float view_depth(const vec3& p, const camera_scene& camera)
+{
+    const mat4 V = camera.view_matrix();
+    return -( V(2,0)*p.x + V(2,1)*p.y + V(2,2)*p.z + V(2,3) );
+}
+
+render_stats::render_stats()
+    :drawn(0), culled(0), draw_calls(0), triangles(0), sort_ms(0), transparent_ms(0)
+{}
+
+void render_stats::reset()
+{
+    drawn = 0;
+    culled = 0;
+    draw_calls = 0;
+    triangles = 0;
+}
+
+void render_queue::clear()
+{
+    packets.clear();
+    stats.reset();
+}
+
+void render_queue::push(const mesh_drawable& drawable, GLuint shader, render_pass pass, const camera_scene& camera)
+{
+    const float depth = view_depth(drawable.uniform.transform.translation, camera);
+
+    render_packet packet;
+    packet.key = render_sort_key(pass, shader, drawable.texture_id, depth);
+    packet.pass = pass;
+    packet.shader = shader;
+    packet.texture_id = drawable.texture_id;
+    packet.drawable = &drawable;
+    packet.drawable_instanced = nullptr;
+    packet.sky = nullptr;
+    packet.bounding = world_bounding_sphere(drawable);
+    packet.cullable = true;
+    packets.push_back(packet);
+}
+
+void render_queue::push(const mesh_drawable_instanced& drawable, GLuint shader, render_pass pass, const camera_scene& )
+{
+    // Instances are spread in the scene: the packet is placed in front of its pass
+    render_packet packet;
+    packet.key = render_sort_key(pass, shader, drawable.texture_id, 0.0f);
+    packet.pass = pass;
+    packet.shader = shader;
+    packet.texture_id = drawable.texture_id;
+    packet.drawable = nullptr;
+    packet.drawable_instanced = &drawable;
+    packet.sky = nullptr;
+    packet.cullable = false;
+    packets.push_back(packet);
+}
+
+void render_queue::push(const skybox& sky, GLuint shader, render_pass pass)
+{
+    // The sky box surrounds the camera: it is never culled
+    render_packet packet;
+    packet.key = render_sort_key(pass, shader, sky.texture_id, 0.0f);
+    packet.pass = pass;
+    packet.shader = shader;
+    packet.texture_id = sky.texture_id;
+    packet.drawable = nullptr;
+    packet.drawable_instanced = nullptr;
+    packet.sky = &sky;
+    packet.cullable = false;
+    packets.push_back(packet);
+}
+
+void render_queue::cull(const frustum& f)
+{
+    culling.clear();
+    for(const render_packet& packet : packets)
+        culling.add(packet.bounding);
+    culling.run(f);
+
+    size_t counter = 0;
+    for(size_t k=0; k<packets.size(); ++k) {
+        if(culling.visible[k] || !packets[k].cullable)
+            packets[counter++] = packets[k];
+        else
+            stats.culled++;
+    }
+    packets.resize(counter);
+}
+
+void render_queue::sort()
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    const size_t N = packets.size();
+    sort_keys.resize(N);
+    for(size_t k=0; k<N; ++k)
+        sort_keys[k] = packets[k].key;
+    radix_sort(sort_keys, sort_order, sort_scratch);
+
+    sorted_packets.resize(N);
+    for(size_t k=0; k<N; ++k)
+        sorted_packets[k] = packets[sort_order[k]];
+    packets.swap(sorted_packets);
+
+    stats.sort_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+static void set_pass_state(render_pass pass)
+{
+    if(pass==render_pass::transparent) {
+        // new color = previous color + (1-alpha) current color, transparent elements don't write in the depth buffer
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(false);
+        glDepthFunc(GL_LESS);
+    }
+    else if(pass==render_pass::background) {
+        // the background lies on the far plane: only the pixels still at the cleared depth pass the test
+        glDisable(GL_BLEND);
+        glDepthMask(false);
+        glDepthFunc(GL_LEQUAL);
+    }
+    else {
+        glDisable(GL_BLEND);
+        glDepthMask(true);
+        glDepthFunc(GL_LESS);
+    }
+}
+
+void render_queue::begin_pass(render_pass pass)
+{
+    if(pass==render_pass::transparent) {
+        transparent_timer.begin();
+        if(transparency==transparency_mode::weighted_blended) {
+            oit.begin();
+            return;
+        }
+    }
+    set_pass_state(pass);
+}
+
+void render_queue::end_pass(render_pass pass)
+{
+    if(pass==render_pass::transparent) {
+        if(transparency==transparency_mode::weighted_blended)
+            oit.end(oit_composite_shader);
+        transparent_timer.end();
+        stats.transparent_ms = transparent_timer.milliseconds;
+    }
+}
+
+void render_queue::submit(const camera_scene& camera)
+{
+    // All the textures of the packets are bound with bind_texture
+    texture_binding_cache_begin();
+
+    bool first = true;
+    render_pass current_pass = render_pass::opaque;
+    for(const render_packet& packet : packets)
+    {
+        if(first || packet.pass!=current_pass) {
+            if(!first)
+                end_pass(current_pass);
+            begin_pass(packet.pass);
+            current_pass = packet.pass;
+            first = false;
+        }
+
+        if(packet.drawable!=nullptr) {
+            draw(*packet.drawable, camera, packet.shader, packet.texture_id);
+            stats.drawn++;
+            stats.triangles += packet.drawable->data.number_triangles;
+        }
+        else if(packet.drawable_instanced!=nullptr) {
+            draw(*packet.drawable_instanced, camera, packet.shader);
+            stats.drawn += packet.drawable_instanced->number_instances;
+            stats.triangles += packet.drawable_instanced->number_instances * packet.drawable_instanced->geometry.number_triangles;
+        }
+        else if(packet.sky!=nullptr) {
+            draw(*packet.sky, camera, packet.shader);
+            stats.drawn++;
+            stats.triangles += packet.sky->cube.number_triangles;
+        }
+        stats.draw_calls++;
+    }
+
+    if(!first)
+        end_pass(current_pass);
+
+    // Restore default state (the textures stay bound, the samplers are specific to the drawables)
+    glBindSampler(0, 0);
+    texture_binding_cache_end();
+    glDisable(GL_BLEND);
+    glDepthMask(true);
+    glDepthFunc(GL_LESS);
+}
+
+}
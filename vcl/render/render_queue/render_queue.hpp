@@ -0,0 +1,105 @@
+#pragma once
+
+#include "vcl/shape/mesh/mesh_drawable/mesh_drawable.hpp"
+#include "vcl/shape/mesh/mesh_drawable_instanced/mesh_drawable_instanced.hpp"
+#include "vcl/shape/skybox/skybox.hpp"
+#include "vcl/interaction/camera/camera.hpp"
+#include "vcl/render/frustum_culling/frustum_culling.hpp"
+#include "vcl/render/weighted_blended_oit/weighted_blended_oit.hpp"
+#include "vcl/render/gpu_timer/gpu_timer.hpp"
+
+#include <vector>
+#include <cstdint>
+
+namespace vcl
+{
+
+/** Passes of the render queue, submitted in this order
+ * - opaque: depth test and write, no blending (front to back)
+ * - background: drawn after opaque elements at depth=1 with a GL_LEQUAL test, such that covered pixels are rejected
+ * - transparent: blending, no depth write (back to front)
+ * - overlay: wireframe and other elements drawn on top of the scene */
+enum class render_pass : unsigned int { opaque=0, background=1, transparent=2, overlay=3 };
+
+/** Rendering of the transparent pass
+ * - sorted: packets blended back to front in the default framebuffer (order given by the sort key)
+ * - weighted_blended: order independent accumulation (see weighted_blended_oit), the transparent packets must use a shader writing its two targets */
+enum class transparency_mode { sorted, weighted_blended };
+
+/** 64-bit sort key of a draw packet.
+ * Opaque-like passes:  [pass:2][shader:12][texture:18][depth:32] - minimize state changes, then front to back
+ * Transparent pass:    [pass:2][inverted depth:32][shader:12][texture:18] - back to front has priority for correct blending
+ * depth is the (positive) view-space distance along the camera axis. */
+uint64_t render_sort_key(render_pass pass, GLuint shader, GLuint texture_id, float depth);
+
+/** View-space depth of a point along the viewing direction (positive in front of the camera) */
+float view_depth(const vec3& p, const camera_scene& camera);
+
+/** Element of the render queue: a drawable with its shader, texture and sort key */
+struct render_packet
+{
+    uint64_t key;
+    render_pass pass;
+    GLuint shader;
+    GLuint texture_id;
+    const mesh_drawable* drawable;
+    const mesh_drawable_instanced* drawable_instanced;
+    const skybox* sky;
+
+    bounding_sphere bounding; // in world coordinates
+    bool cullable;            // instanced drawables are culled per instance before being pushed
+};
+
+/** Counters on the elements of the last frame (objects or instances) */
+struct render_stats
+{
+    render_stats();
+    void reset();
+
+    unsigned int drawn;
+    unsigned int culled;
+    unsigned int draw_calls;
+    unsigned int triangles;
+
+    float sort_ms;        // CPU time of sort()
+    float transparent_ms; // GPU time of the transparent pass (measured a few frames before)
+};
+
+/** Collect draw packets during a frame, sort them by key, and submit them in order.
+ * Drawables are stored by pointer: they must remain valid until submit() is called.
+ * Usage: clear() / push(...) / sort() / submit(camera) at every frame. */
+struct render_queue
+{
+    void clear();
+
+    void push(const mesh_drawable& drawable, GLuint shader, render_pass pass, const camera_scene& camera);
+    void push(const mesh_drawable_instanced& drawable, GLuint shader, render_pass pass, const camera_scene& camera);
+    void push(const skybox& sky, GLuint shader, render_pass pass = render_pass::background);
+
+    /** Remove the packets outside of the frustum (and count them in the stats) */
+    void cull(const frustum& f);
+    /** Order the packets by key (stable radix sort) */
+    void sort();
+    /** Draw all packets in the current order, setting the blending and depth state of each pass */
+    void submit(const camera_scene& camera);
+
+    std::vector<render_packet> packets;
+    render_stats stats;
+
+    transparency_mode transparency = transparency_mode::sorted;
+    GLuint oit_composite_shader = 0; // used in weighted_blended mode
+
+private:
+    void begin_pass(render_pass pass);
+    void end_pass(render_pass pass);
+
+    frustum_culling culling;
+    std::vector<uint64_t> sort_keys;
+    std::vector<uint32_t> sort_order;
+    std::vector<uint32_t> sort_scratch;
+    std::vector<render_packet> sorted_packets;
+    weighted_blended_oit oit;
+    gpu_timer transparent_timer;
+};
+
+}
@@ -0,0 +1,73 @@
+#include "sphere_shadows.hpp"
+
+#include "vcl/base/base.hpp"
+
+#include <algorithm>
+
+namespace vcl
+{
+
+sphere_shadows::sphere_shadows()
+    :light_center({0,0,0}), light_radius(1.0f), occluders()
+{}
+
+void sphere_shadows::clear()
+{
+    occluders.clear();
+}
+
+int sphere_shadows::add(const vec3& center, float radius)
+{
+    assert_vcl(occluders.size()<max_occluders, "Too many shadow occluders");
+    occluders.push_back({center.x, center.y, center.z, radius});
+    return int(occluders.size())-1;
+}
+
+vec2 sphere_shadows::select(const vec3& center, float radius, int receiver) const
+{
+    // The segments joining the receiver to the light lie in a truncated cone of axis center->light_center,
+    //  whose radius varies linearly from the receiver radius to the light radius.
+    //  An occluder may cast a shadow if it intersects this cone.
+    const vec3 axis = light_center-center;
+    const float length = norm(axis);
+    if(length<1e-6f)
+        return {-1,-1};
+    const vec3 u = axis/length;
+
+    int best[2] = {-1,-1};
+    float depth[2] = {0,0}; // penetration of the occluder in the cone (the deepest occluders are kept)
+    for(size_t k=0; k<occluders.size(); ++k)
+    {
+        if(int(k)==receiver)
+            continue;
+        const vec4& o = occluders[k];
+        const vec3 p = vec3{o.x,o.y,o.z}-center;
+        const float t = dot(p,u);
+        if(t+o.w<=0 || t>=length) // behind the receiver or the light
+            continue;
+
+        const float distance_to_axis = norm(p-t*u);
+        const float cone_radius = radius + (light_radius-radius)*std::max(t,0.0f)/length;
+        const float d = cone_radius + o.w - distance_to_axis;
+        if(d<=0)
+            continue;
+
+        if(best[0]==-1 || d>depth[0]) {
+            best[1] = best[0]; depth[1] = depth[0];
+            best[0] = int(k);  depth[0] = d;
+        }
+        else if(best[1]==-1 || d>depth[1]) {
+            best[1] = int(k);  depth[1] = d;
+        }
+    }
+    return {float(best[0]), float(best[1])};
+}
+
+void sphere_shadows::send(GLuint shader, const vec2& object_occluders) const
+{
+    glUniform4fv(glGetUniformLocation(shader, "occluders"), GLsizei(occluders.size()), occluders.empty() ? nullptr : &occluders[0].x);
+    glUniform1f(glGetUniformLocation(shader, "light_radius"), light_radius);
+    glUniform2i(glGetUniformLocation(shader, "object_occluders"), int(object_occluders.x), int(object_occluders.y));
+}
+
+}
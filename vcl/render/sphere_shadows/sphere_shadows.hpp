@@ -0,0 +1,38 @@
+#pragma once
+
+#include "vcl/math/math.hpp"
+#include "vcl/wrapper/glad/glad.hpp"
+
+#include <vector>
+
+namespace vcl
+{
+
+/** Spheres casting analytic soft shadows from a spherical light (eclipses), without shadow maps.
+ * The occluders are sent to the shaders as the uniform array "occluders" (center, radius). The CPU selects the few occluders
+ * which may hide part of the light from each receiver, and the fragment shader computes the visible fraction of the light disc.
+ * Usage at every frame: clear(), set the light, add() the occluders, then select() the occluders of each receiver (per instance attribute) and send() the uniforms. */
+struct sphere_shadows
+{
+    /** Size of the uniform array in the shaders */
+    static const size_t max_occluders = 16;
+
+    sphere_shadows();
+
+    void clear();
+    /** Add an occluder and return its index in the uniform array */
+    int add(const vec3& center, float radius);
+
+    /** Indices (x,y) of at most two occluders which may hide part of the light from the receiver sphere, -1 if none.
+     *  receiver is the index of the receiver itself if it is also an occluder (skipped). */
+    vec2 select(const vec3& center, float radius, int receiver=-1) const;
+
+    /** Send the uniforms "occluders", "light_radius", and "object_occluders" (indices used by the shaders drawing a single object) */
+    void send(GLuint shader, const vec2& object_occluders={-1,-1}) const;
+
+    vec3 light_center;
+    float light_radius;
+    std::vector<vec4> occluders; // (center, radius)
+};
+
+}
@@ -0,0 +1,124 @@
+#include "weighted_blended_oit.hpp"
+
+#include "vcl/opengl/opengl.hpp"
+#include "vcl/base/base.hpp"
+
+namespace vcl
+{
+
+weighted_blended_oit::weighted_blended_oit()
+    :fbo(0), accumulation(0), weight(0), depth(0), vao_empty(0), width(0), height(0), target(0)
+{}
+
+static GLuint create_target(GLint internal_format, GLenum format, GLsizei width, GLsizei height)
+{
+    GLuint id = 0;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return id;
+}
+
+void weighted_blended_oit::resize(GLsizei width_arg, GLsizei height_arg)
+{
+    clear();
+    width = width_arg;
+    height = height_arg;
+
+    accumulation = create_target(GL_RGBA16F, GL_RGBA, width, height);
+    weight = create_target(GL_R16F, GL_RED, width, height);
+
+    glGenRenderbuffers(1, &depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumulation, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, weight, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+    const GLenum draw_buffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, draw_buffers);
+    assert_vcl(glCheckFramebufferStatus(GL_FRAMEBUFFER)==GL_FRAMEBUFFER_COMPLETE, "Incomplete framebuffer for the order independent transparency");
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenVertexArrays(1, &vao_empty);
+}
+
+void weighted_blended_oit::begin()
+{
+    // Framebuffer of the opaque elements: the default one, or an offscreen framebuffer
+    GLint target_binding = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target_binding);
+    target = GLuint(target_binding);
+
+    GLint viewport[4] = {0,0,0,0};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if(fbo==0 || viewport[2]!=width || viewport[3]!=height)
+        resize(viewport[2], viewport[3]);
+
+    // Copy the depth of the opaque elements: hidden transparent fragments are rejected
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+    glBlitFramebuffer(0,0,width,height, 0,0,width,height, GL_DEPTH_BUFFER_BIT, GL_NEAREST); opengl_debug();
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    const GLfloat clear_accumulation[4] = {0,0,0,1}; // revealage starts at 1
+    const GLfloat clear_weight[4] = {0,0,0,0};
+    glClearBufferfv(GL_COLOR, 0, clear_accumulation);
+    glClearBufferfv(GL_COLOR, 1, clear_weight);
+
+    glEnable(GL_BLEND);
+    glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(false);
+    glDepthFunc(GL_LESS);
+}
+
+void weighted_blended_oit::end(GLuint composite_shader)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+
+    // average color weighted by the revealage: color*(1-revealage) + background*revealage
+    glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+    glDisable(GL_DEPTH_TEST);
+
+    glUseProgram(composite_shader);
+    bind_texture(GL_TEXTURE_2D, accumulation, 0, 0);
+    bind_texture(GL_TEXTURE_2D, weight, 0, 1);
+    uniform(composite_shader, "accumulation_sampler", 0);
+    uniform(composite_shader, "weight_sampler", 1);
+
+    glBindVertexArray(vao_empty);
+    glDrawArrays(GL_TRIANGLES, 0, 3); opengl_debug();
+    glBindVertexArray(0);
+
+    bind_texture(GL_TEXTURE_2D, 0, 0, 1);
+    bind_texture(GL_TEXTURE_2D, 0, 0, 0);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void weighted_blended_oit::clear()
+{
+    if(fbo!=0) {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(1, &accumulation);
+        glDeleteTextures(1, &weight);
+        glDeleteRenderbuffers(1, &depth);
+        glDeleteVertexArrays(1, &vao_empty);
+    }
+    fbo = 0;
+    accumulation = 0;
+    weight = 0;
+    depth = 0;
+    vao_empty = 0;
+    width = 0;
+    height = 0;
+}
+
+}
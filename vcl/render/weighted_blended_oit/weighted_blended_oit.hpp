@@ -0,0 +1,38 @@
+#pragma once
+
+#include "vcl/wrapper/glad/glad.hpp"
+
+namespace vcl
+{
+
+/** Weighted blended order independent transparency (McGuire and Bavoil, 2013).
+ * Transparent fragments are accumulated in two offscreen targets whatever their order, then composited over the opaque image.
+ *  - accumulation (RGBA16F): rgb = sum(weight*alpha*color), a = product(1-alpha) (revealage)
+ *  - weight (R16F): r = sum(weight*alpha)
+ * Both targets share a single blend function (glBlendFunci requires OpenGL 4): rgb are added, alpha is multiplied by (1-alpha).
+ * The fragment shaders of the transparent elements write vec4(weight*alpha*color, alpha) and vec4(weight*alpha, 0, 0, alpha) in the two targets. */
+struct weighted_blended_oit
+{
+    weighted_blended_oit();
+
+    /** Bind the offscreen targets (resized to the current viewport), sharing the depth of the opaque elements drawn in the currently bound framebuffer */
+    void begin();
+    /** Composite the accumulated elements over the framebuffer bound at begin() with the given shader (sampling accumulation_sampler and weight_sampler) */
+    void end(GLuint composite_shader);
+
+    void clear();
+
+    GLuint fbo;
+    GLuint accumulation;
+    GLuint weight;
+    GLuint depth;
+    GLuint vao_empty; // the composition is a full screen triangle generated from gl_VertexID
+    GLsizei width;
+    GLsizei height;
+    GLuint target; // framebuffer of the opaque elements, bound at begin()
+
+private:
+    void resize(GLsizei width, GLsizei height);
+};
+
+}
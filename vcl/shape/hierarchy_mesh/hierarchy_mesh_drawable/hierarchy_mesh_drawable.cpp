@@ -109,15 +109,23 @@ void hierarchy_mesh_drawable::update_local_to_global_coordinates()
 
             element.global_transform = global_parent * local;
         }
+
+        element.global_bounding_sphere = transform(element.element.data.bounding, element.global_transform * element.element.uniform.transform);
     }
 }
 
-void draw(const hierarchy_mesh_drawable& hierarchy, const camera_scene& camera, int shader)
+// Draw all the elements, or only the ones intersecting the frustum if it is given
+static unsigned int draw_elements(const hierarchy_mesh_drawable& hierarchy, const camera_scene& camera, const frustum* view_frustum, int shader)
 {
+    unsigned int culled = 0;
     const size_t N = hierarchy.elements.size();
     for(size_t k=0; k<N; ++k)
     {
         const hierarchy_mesh_drawable_node& node = hierarchy.elements[k];
+        if(view_frustum!=nullptr && !is_visible(*view_frustum, node.global_bounding_sphere)) {
+            culled++;
+            continue;
+        }
 
         // copy of the mesh drawable (lightweight element) - to preserve its uniform parameters
         mesh_drawable visual_element = node.element;
@@ -131,6 +139,17 @@ void draw(const hierarchy_mesh_drawable& hierarchy, const camera_scene& camera,
         else // use the shader set in the argument
             vcl::draw(visual_element, camera, shader);
     }
+    return culled;
+}
+
+void draw(const hierarchy_mesh_drawable& hierarchy, const camera_scene& camera, int shader)
+{
+    draw_elements(hierarchy, camera, nullptr, shader);
+}
+
+unsigned int draw(const hierarchy_mesh_drawable& hierarchy, const camera_scene& camera, const frustum& view_frustum, int shader)
+{
+    return draw_elements(hierarchy, camera, &view_frustum, shader);
 }
 
 void assert_valid_hierarchy(const hierarchy_mesh_drawable& hierarchy)
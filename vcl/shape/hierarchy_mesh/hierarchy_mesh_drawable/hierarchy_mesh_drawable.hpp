@@ -1,6 +1,7 @@
 #pragma once
 
 #include "vcl/shape/mesh/mesh_drawable/mesh_drawable.hpp"
+#include "vcl/math/frustum/frustum.hpp"
 #include "hierarchy_mesh_drawable_node/hierarchy_mesh_drawable_node.hpp"
 #include "hierarchy_mesh_drawable_display_skeleton/hierarchy_mesh_drawable_display_skeleton.hpp"
 
@@ -62,4 +63,8 @@ struct hierarchy_mesh_drawable
 */
 void draw(const hierarchy_mesh_drawable& hierarchy, const camera_scene& camera, int shader=-1);
 
+/** Display the elements of the hierarchy whose global_bounding_sphere intersects the frustum (ex. camera_frustum(camera))
+    Return the number of culled elements (ex. to be added to render_stats::culled) */
+unsigned int draw(const hierarchy_mesh_drawable& hierarchy, const camera_scene& camera, const frustum& view_frustum, int shader=-1);
+
 }
@@ -30,6 +30,8 @@ struct hierarchy_mesh_drawable_node {
 
     affine_transform transform;        // Local coordinates values for rotation and translation to apply with respect to the parent node frame
     affine_transform global_transform; // Global coordinates values for orientation and translation (supposed to be computed automatically)
+
+    bounding_sphere global_bounding_sphere; // Sphere enclosing the element in global coordinates (supposed to be computed automatically)
 };
 
 
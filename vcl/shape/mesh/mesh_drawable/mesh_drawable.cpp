@@ -8,11 +8,11 @@ namespace vcl
 
 
 mesh_drawable::mesh_drawable()
-    :data(),uniform(),shader(0),texture_id(0)
+    :data(),uniform(),shader(0),texture_id(0),sampler(0)
 {}
 
-mesh_drawable::mesh_drawable(const mesh& mesh_arg, GLuint shader_arg, GLuint texture_id_arg)
-    :data(mesh_arg),uniform(),shader(shader_arg),texture_id(texture_id_arg)
+mesh_drawable::mesh_drawable(const mesh& mesh_arg, GLuint shader_arg, GLuint texture_id_arg, bool barycentric)
+    :data(mesh_arg, barycentric),uniform(),shader(shader_arg),texture_id(texture_id_arg),sampler(0)
 {}
 
 void mesh_drawable::clear()
@@ -30,6 +30,11 @@ void mesh_drawable::update_normal(const vcl::buffer<vec3>& new_normal)
     data.update_normal(new_normal);
 }
 
+bounding_sphere world_bounding_sphere(const mesh_drawable& drawable)
+{
+    return transform(drawable.data.bounding, drawable.uniform.transform);
+}
+
 
 void draw(const mesh_drawable& drawable, const camera_scene& camera)
 {
@@ -60,10 +65,10 @@ void draw(const mesh_drawable& drawable, const camera_scene& camera, GLuint shad
     if(shader!=GLuint(current_shader))
         glUseProgram(shader); opengl_debug();
 
-    // Bind texture only if id != 0
+    // Bind texture only if id != 0 (and if it is not already bound)
     if(texture_id!=0) {
         assert(glIsTexture(texture_id));
-        glBindTexture(GL_TEXTURE_2D, texture_id);  opengl_debug();
+        bind_texture(GL_TEXTURE_2D, texture_id, drawable.sampler);  opengl_debug();
     }
 
     // Send all uniform values to the shader
@@ -75,6 +80,7 @@ void draw(const mesh_drawable& drawable, const camera_scene& camera, GLuint shad
     uniform(shader, "scaling_axis", drawable.uniform.transform.scaling_axis);    opengl_debug();
 
     uniform(shader,"perspective",camera.perspective.matrix());         opengl_debug();
+    uniform(shader,"depth_log_coefficient",camera.perspective.depth_log_coefficient()); opengl_debug();
     uniform(shader,"view",camera.view_matrix());                       opengl_debug();
     uniform(shader,"camera_position",camera.camera_position());        opengl_debug();
 
@@ -21,8 +21,8 @@ struct mesh_drawable
 public:
 
     mesh_drawable();
-    /** Initialize VAO and VBO from the mesh */
-    mesh_drawable(const mesh& mesh_cpu, GLuint shader = 0, GLuint texture_id = 0);
+    /** Initialize VAO and VBO from the mesh (see mesh_drawable_gpu_data for the barycentric option) */
+    mesh_drawable(const mesh& mesh_cpu, GLuint shader = 0, GLuint texture_id = 0, bool barycentric = false);
 
 
     /** Clear buffers (VBO, VAO, etc) */
@@ -42,8 +42,12 @@ public:
     mesh_drawable_uniform uniform;
     GLuint shader;
     GLuint texture_id;
+    GLuint sampler; // wrapping and filtering of the texture (see sampler_object), 0: parameters of the texture
 };
 
+/** Bounding sphere of the drawable in world coordinates (local bounding sphere with the uniform transform applied) */
+bounding_sphere world_bounding_sphere(const mesh_drawable& drawable);
+
 void draw(const mesh_drawable& drawable, const camera_scene& camera);
 void draw(const mesh_drawable& drawable, const camera_scene& camera, GLuint shader);
 void draw(const mesh_drawable& drawable, const camera_scene& camera, GLuint shader, GLuint texture_id);
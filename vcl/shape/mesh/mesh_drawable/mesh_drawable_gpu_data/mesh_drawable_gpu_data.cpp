@@ -6,10 +6,28 @@ namespace vcl
 {
 
 mesh_drawable_gpu_data::mesh_drawable_gpu_data()
-    :vao(0), number_triangles(0), vbo_index(0), vbo_position(0), vbo_normal(0), vbo_color(0), vbo_texture_uv(0)
+    :vao(0), number_triangles(0), vbo_index(0), vbo_position(0), vbo_normal(0), vbo_color(0), vbo_texture_uv(0), vbo_barycentric(0), bounding()
 {}
 
-mesh_drawable_gpu_data::mesh_drawable_gpu_data(const mesh &mesh_cpu_arg)
+// Duplicate the vertices such that each triangle has its own three vertices
+static mesh split_triangles(const mesh& m)
+{
+    mesh split;
+    for(const uint3& tri : m.connectivity) {
+        const unsigned int offset = static_cast<unsigned int>(split.position.size());
+        for(unsigned int k=0; k<3; ++k) {
+            split.position.push_back(m.position[tri[k]]);
+            split.normal.push_back(m.normal[tri[k]]);
+            split.color.push_back(m.color[tri[k]]);
+            split.texture_uv.push_back(m.texture_uv[tri[k]]);
+        }
+        split.connectivity.push_back({offset, offset+1, offset+2});
+    }
+    return split;
+}
+
+mesh_drawable_gpu_data::mesh_drawable_gpu_data(const mesh &mesh_cpu_arg, bool barycentric)
+    :mesh_drawable_gpu_data()
 {
     // Doesn't assign anything if there is no position
     if(mesh_cpu_arg.position.size()==0)
@@ -18,6 +36,8 @@ mesh_drawable_gpu_data::mesh_drawable_gpu_data(const mesh &mesh_cpu_arg)
     // temp copy of the mesh to fill all empty fields
     mesh mesh_cpu = mesh_cpu_arg;
     mesh_cpu.fill_empty_fields();
+    if(barycentric)
+        mesh_cpu = split_triangles(mesh_cpu);
 
     // Fill VBO for position
     glGenBuffers(1, &vbo_position);
@@ -49,7 +69,22 @@ mesh_drawable_gpu_data::mesh_drawable_gpu_data(const mesh &mesh_cpu_arg)
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(mesh_cpu.connectivity.size()*sizeof(GLuint)*3), &mesh_cpu.connectivity[0], GL_DYNAMIC_DRAW );
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
+    // Fill VBO for barycentric coordinates
+    if(barycentric) {
+        buffer<vec3> coordinates;
+        for(size_t k=0; k<mesh_cpu.connectivity.size(); ++k) {
+            coordinates.push_back({1,0,0});
+            coordinates.push_back({0,1,0});
+            coordinates.push_back({0,0,1});
+        }
+        glGenBuffers(1, &vbo_barycentric);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_barycentric);
+        glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(coordinates.size()*sizeof(GLfloat)*3), &coordinates[0], GL_STATIC_DRAW );
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
     number_triangles = static_cast<unsigned int>(mesh_cpu.connectivity.size());
+    bounding = bounding_sphere_from_position(mesh_cpu.position);
 
     glGenVertexArrays(1,&vao);
     glBindVertexArray(vao);
@@ -74,6 +109,13 @@ mesh_drawable_gpu_data::mesh_drawable_gpu_data(const mesh &mesh_cpu_arg)
     glEnableVertexAttribArray( 3 );
     glVertexAttribPointer( 3, 2, GL_FLOAT, GL_FALSE, 0, nullptr );
 
+    // barycentric coordinates at layout 9
+    if(vbo_barycentric!=0) {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_barycentric);
+        glEnableVertexAttribArray( 9 );
+        glVertexAttribPointer( 9, 3, GL_FLOAT, GL_FALSE, 0, nullptr );
+    }
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
@@ -86,6 +128,8 @@ void mesh_drawable_gpu_data::clear()
     glDeleteBuffers(1,&vbo_color);
     glDeleteBuffers(1,&vbo_texture_uv);
     glDeleteBuffers(1,&vbo_index);
+    if(vbo_barycentric!=0)
+        glDeleteBuffers(1,&vbo_barycentric);
 }
 
 void mesh_drawable_gpu_data::update_position(const buffer<vec3>& new_position)
@@ -3,6 +3,7 @@
 
 #include "vcl/wrapper/glad/glad.hpp"
 #include "../../mesh_structure/mesh.hpp"
+#include "vcl/math/bounding_sphere/bounding_sphere.hpp"
 
 
 namespace vcl
@@ -11,7 +12,10 @@ namespace vcl
 struct mesh_drawable_gpu_data {
 
     mesh_drawable_gpu_data();
-    mesh_drawable_gpu_data(const mesh& mesh_cpu);
+    /** Send the mesh to the GPU.
+     * If barycentric is true, the triangles are split (3 independent vertices per triangle) and each vertex receives its barycentric coordinates (layout 9).
+     * It allows to display the wireframe in the fragment shader in the same pass, at the cost of a larger memory footprint. */
+    mesh_drawable_gpu_data(const mesh& mesh_cpu, bool barycentric = false);
 
     /** Clear buffers */
     void clear();
@@ -34,6 +38,9 @@ struct mesh_drawable_gpu_data {
     GLuint vbo_normal;     // (nx,ny,nz) normals coordinates (unit length)
     GLuint vbo_color;      // (r,g,b) values
     GLuint vbo_texture_uv; // (u,v) texture coordinates
+    GLuint vbo_barycentric;// (1,0,0), (0,1,0), (0,0,1) on the vertices of each triangle (0 if the triangles are not split)
+
+    bounding_sphere bounding; // sphere enclosing the positions (in local coordinates)
 };
 
 /** Call raw OpenGL draw */
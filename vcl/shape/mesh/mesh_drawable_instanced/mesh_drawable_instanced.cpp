@@ -0,0 +1,136 @@
+#include "mesh_drawable_instanced.hpp"
+
+#include "vcl/opengl/opengl.hpp"
+
+#include <cstddef>
+
+namespace vcl
+{
+
+mesh_instance::mesh_instance()
+    :rotation(), translation({0,0,0}), scaling(1.0f), shading({0.2f,0.8f,0.5f}), texture_layer(0.0f), occluders({-1.0f,-1.0f}), virtual_texture(-1.0f)
+{}
+
+mesh_drawable_instanced::mesh_drawable_instanced()
+    :geometry(), vao(0), vbo_instance(0), number_instances(0), color({1,1,1}), color_alpha(1.0f), specular_exponent(128), shader(0), texture_id(0), sampler(0)
+{}
+
+mesh_drawable_instanced::mesh_drawable_instanced(const mesh_drawable_gpu_data& geometry_arg, GLuint shader_arg, GLuint texture_array_id_arg)
+    :geometry(geometry_arg), vao(0), vbo_instance(0), number_instances(0), color({1,1,1}), color_alpha(1.0f), specular_exponent(128), shader(shader_arg), texture_id(texture_array_id_arg), sampler(0)
+{
+    glGenBuffers(1, &vbo_instance);
+
+    glGenVertexArrays(1,&vao);
+    glBindVertexArray(vao);
+
+    // Shared per-vertex attributes (same layout as mesh_drawable_gpu_data)
+    glBindBuffer(GL_ARRAY_BUFFER, geometry.vbo_position);
+    glEnableVertexAttribArray( 0 );
+    glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, 0, nullptr );
+
+    glBindBuffer(GL_ARRAY_BUFFER, geometry.vbo_normal);
+    glEnableVertexAttribArray( 1 );
+    glVertexAttribPointer( 1, 3, GL_FLOAT, GL_FALSE, 0, nullptr );
+
+    glBindBuffer(GL_ARRAY_BUFFER, geometry.vbo_color);
+    glEnableVertexAttribArray( 2 );
+    glVertexAttribPointer( 2, 4, GL_FLOAT, GL_FALSE, 0, nullptr );
+
+    glBindBuffer(GL_ARRAY_BUFFER, geometry.vbo_texture_uv);
+    glEnableVertexAttribArray( 3 );
+    glVertexAttribPointer( 3, 2, GL_FLOAT, GL_FALSE, 0, nullptr );
+
+    if(geometry.vbo_barycentric!=0) {
+        glBindBuffer(GL_ARRAY_BUFFER, geometry.vbo_barycentric);
+        glEnableVertexAttribArray( 9 );
+        glVertexAttribPointer( 9, 3, GL_FLOAT, GL_FALSE, 0, nullptr );
+    }
+
+    // Per-instance attributes: advance once per instance
+    const GLsizei stride = sizeof(mesh_instance);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_instance);
+    for(GLuint k=0; k<3; ++k) {
+        glEnableVertexAttribArray( 4+k );
+        glVertexAttribPointer( 4+k, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(mesh_instance,rotation)+3*k*sizeof(float)) );
+        glVertexAttribDivisor( 4+k, 1 );
+    }
+    glEnableVertexAttribArray( 7 );
+    glVertexAttribPointer( 7, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(mesh_instance,translation)) );
+    glVertexAttribDivisor( 7, 1 );
+
+    glEnableVertexAttribArray( 8 );
+    glVertexAttribPointer( 8, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(mesh_instance,shading)) );
+    glVertexAttribDivisor( 8, 1 );
+
+    glEnableVertexAttribArray( 10 );
+    glVertexAttribPointer( 10, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(mesh_instance,occluders)) );
+    glVertexAttribDivisor( 10, 1 );
+
+    glEnableVertexAttribArray( 11 );
+    glVertexAttribPointer( 11, 1, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(mesh_instance,virtual_texture)) );
+    glVertexAttribDivisor( 11, 1 );
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, geometry.vbo_index);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void mesh_drawable_instanced::clear()
+{
+    glDeleteBuffers(1, &vbo_instance);
+    glDeleteVertexArrays(1, &vao);
+    vbo_instance = 0;
+    vao = 0;
+    number_instances = 0;
+}
+
+void mesh_drawable_instanced::update_instances(const buffer<mesh_instance>& instances)
+{
+    assert(glIsBuffer(vbo_instance));
+    number_instances = static_cast<unsigned int>(instances.size());
+    if(number_instances==0)
+        return;
+
+    // Orphan the previous storage to avoid waiting for the draw calls still using it
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_instance);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(instances.size()*sizeof(mesh_instance)), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, GLsizeiptr(instances.size()*sizeof(mesh_instance)), &instances[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+void draw(const mesh_drawable_instanced& drawable, const camera_scene& camera)
+{
+    draw(drawable, camera, drawable.shader);
+}
+
+void draw(const mesh_drawable_instanced& drawable, const camera_scene& camera, GLuint shader)
+{
+    if(shader==0 || drawable.number_instances==0 || drawable.geometry.number_triangles==0)
+        return ;
+
+    // Set without querying the current program (a query would synchronize with the driver)
+    glUseProgram(shader); opengl_debug();
+
+    if(drawable.texture_id!=0) {
+        assert(glIsTexture(drawable.texture_id));
+        bind_texture(GL_TEXTURE_2D_ARRAY, drawable.texture_id, drawable.sampler); opengl_debug();
+    }
+
+    uniform(shader, "color", drawable.color);                            opengl_debug();
+    uniform(shader, "color_alpha", drawable.color_alpha);                opengl_debug();
+    uniform(shader, "specular_exponent", drawable.specular_exponent);    opengl_debug();
+
+    uniform(shader,"perspective",camera.perspective.matrix());         opengl_debug();
+    uniform(shader,"depth_log_coefficient",camera.perspective.depth_log_coefficient()); opengl_debug();
+    uniform(shader,"view",camera.view_matrix());                       opengl_debug();
+    uniform(shader,"camera_position",camera.camera_position());        opengl_debug();
+
+    glBindVertexArray(drawable.vao); opengl_debug();
+    glDrawElementsInstanced(GL_TRIANGLES, GLsizei(drawable.geometry.number_triangles*3), GL_UNSIGNED_INT, nullptr, GLsizei(drawable.number_instances)); opengl_debug();
+    glBindVertexArray(0);
+}
+
+}
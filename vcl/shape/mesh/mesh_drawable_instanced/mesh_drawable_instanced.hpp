@@ -0,0 +1,67 @@
+#pragma once
+
+#include "vcl/math/math.hpp"
+#include "vcl/containers/buffer/buffer.hpp"
+#include "vcl/interaction/camera/camera.hpp"
+
+#include "../mesh_drawable/mesh_drawable_gpu_data/mesh_drawable_gpu_data.hpp"
+
+
+namespace vcl
+{
+
+/** Per-instance parameters sent to the GPU as instanced vertex attributes (layout 9 is kept for the barycentric coordinates of the geometry).
+ *  - rotation: layout 4,5,6 (one row per attribute)
+ *  - translation, scaling: layout 7
+ *  - shading (ambiant, diffuse, specular), texture layer: layout 8
+ *  - occluders: layout 10
+ *  - virtual texture: layout 11 */
+struct mesh_instance
+{
+    mesh_instance();
+
+    mat3 rotation;
+    vec3 translation;
+    float scaling;
+    vec3 shading;
+    float texture_layer;
+    vec2 occluders; // indices of the shadow casting spheres (see sphere_shadows), -1 if none
+    float virtual_texture; // index in a virtual_texture_system, -1 to sample the texture layer
+};
+
+
+/** Drawable displaying several instances of the same mesh in a single draw call.
+ * The geometry (VBO) is shared with an existing mesh_drawable_gpu_data, while a dedicated VAO binds it together with the per-instance buffer.
+ * The texture is expected to be a GL_TEXTURE_2D_ARRAY, each instance selecting its layer. */
+struct mesh_drawable_instanced
+{
+public:
+
+    mesh_drawable_instanced();
+    /** Initialize the VAO from shared geometry. The geometry buffers are not owned by the instanced drawable. */
+    mesh_drawable_instanced(const mesh_drawable_gpu_data& geometry, GLuint shader = 0, GLuint texture_array_id = 0);
+
+    /** Clear the per-instance buffer and the VAO (the shared geometry is kept) */
+    void clear();
+
+    /** Send the new set of instances to the GPU. The number of instances can change between two calls. */
+    void update_instances(const buffer<mesh_instance>& instances);
+
+    mesh_drawable_gpu_data geometry;
+    GLuint vao;
+    GLuint vbo_instance;
+    unsigned int number_instances;
+
+    vec3 color;
+    float color_alpha;
+    int specular_exponent;
+
+    GLuint shader;
+    GLuint texture_id;
+    GLuint sampler; // wrapping and filtering of the texture array (see sampler_object), 0: parameters of the texture
+};
+
+void draw(const mesh_drawable_instanced& drawable, const camera_scene& camera);
+void draw(const mesh_drawable_instanced& drawable, const camera_scene& camera, GLuint shader);
+
+}
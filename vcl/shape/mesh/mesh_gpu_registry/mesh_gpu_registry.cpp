@@ -0,0 +1,60 @@
+#include "mesh_gpu_registry.hpp"
+
+#include "../mesh_primitive/mesh_primitive.hpp"
+
+#include <map>
+
+namespace vcl
+{
+
+bool operator<(const mesh_primitive_key& a, const mesh_primitive_key& b)
+{
+    if(a.name!=b.name)
+        return a.name<b.name;
+    return a.parameters<b.parameters;
+}
+
+static std::map<mesh_primitive_key, mesh_drawable_gpu_data>& registry_storage()
+{
+    static std::map<mesh_primitive_key, mesh_drawable_gpu_data> storage;
+    return storage;
+}
+
+const mesh_drawable_gpu_data& mesh_gpu_registry(const mesh_primitive_key& key, const std::function<mesh()>& generator, bool barycentric)
+{
+    std::map<mesh_primitive_key, mesh_drawable_gpu_data>& storage = registry_storage();
+
+    mesh_primitive_key stored_key = key;
+    if(barycentric)
+        stored_key.name += "/barycentric";
+
+    auto it = storage.find(stored_key);
+    if(it==storage.end())
+        it = storage.insert( std::make_pair(stored_key, mesh_drawable_gpu_data(generator(), barycentric)) ).first;
+
+    return it->second;
+}
+
+const mesh_drawable_gpu_data& mesh_gpu_registry_sphere(size_t Nu, size_t Nv, bool barycentric)
+{
+    const mesh_primitive_key key = {"sphere", {float(Nu), float(Nv)}};
+    return mesh_gpu_registry(key, [Nu,Nv](){ return mesh_primitive_sphere(1.0f, {0,0,0}, Nu, Nv); }, barycentric);
+}
+
+const mesh_drawable_gpu_data& mesh_gpu_registry_quad()
+{
+    const mesh_primitive_key key = {"quad", {}};
+    return mesh_gpu_registry(key, [](){ return mesh_primitive_quad({-1,-1,0}, {1,-1,0}, {1,1,0}, {-1,1,0}); });
+}
+
+void mesh_gpu_registry_clear()
+{
+    std::map<mesh_primitive_key, mesh_drawable_gpu_data>& storage = registry_storage();
+    for(auto& it : storage) {
+        it.second.clear();
+        glDeleteVertexArrays(1, &it.second.vao);
+    }
+    storage.clear();
+}
+
+}
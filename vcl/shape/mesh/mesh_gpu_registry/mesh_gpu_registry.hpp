@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../mesh_structure/mesh.hpp"
+#include "../mesh_drawable/mesh_drawable_gpu_data/mesh_drawable_gpu_data.hpp"
+
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace vcl
+{
+
+/** Identify a primitive mesh by the name of its generating function and its parameters */
+struct mesh_primitive_key
+{
+    std::string name;
+    std::vector<float> parameters;
+};
+bool operator<(const mesh_primitive_key& a, const mesh_primitive_key& b);
+
+
+/** Registry sharing the GPU data (VAO, VBO) of primitive meshes.
+ * A primitive is generated and sent to the GPU only the first time its key is queried, later calls return the same buffers.
+ * Shapes are expected to be stored with unit size, and placed in the scene using the uniform transform (translation, rotation, scaling).
+ * The returned data is owned by the registry: it should not be cleared by the caller.
+ * The barycentric variant of a key (split triangles, see mesh_drawable_gpu_data) is stored separately from the indexed one. */
+const mesh_drawable_gpu_data& mesh_gpu_registry(const mesh_primitive_key& key, const std::function<mesh()>& generator, bool barycentric = false);
+
+/** Unit sphere (radius 1, centered at the origin) sampled with Nu x Nv vertices */
+const mesh_drawable_gpu_data& mesh_gpu_registry_sphere(size_t Nu=20, size_t Nv=40, bool barycentric = false);
+
+/** Quadrangle with corners (-1,-1,0) and (1,1,0) */
+const mesh_drawable_gpu_data& mesh_gpu_registry_quad();
+
+/** Delete all the buffers stored in the registry */
+void mesh_gpu_registry_clear();
+
+}
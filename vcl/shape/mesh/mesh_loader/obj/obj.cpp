@@ -8,7 +8,6 @@
 
 #include <map>
 
-#include <fstream>
 #include <sstream>
 
 namespace vcl
@@ -171,8 +170,7 @@ std::vector<vec3> obj_read_positions(const std::string& filename)
     assert_file_exist(filename);
     std::vector<vec3> positions;
 
-    std::ifstream stream(filename);
-    assert_vcl(stream.is_open(), "Cannot open file "+str(filename));
+    std::istringstream stream(read_file_text(filename)); // from the asset pack or the file system
     while(stream.good()) {
         std::string buffer;
         std::getline(stream,buffer);
@@ -190,8 +188,6 @@ std::vector<vec3> obj_read_positions(const std::string& filename)
             }
         }
     }
-    stream.close();
-    assert_vcl(!stream.is_open(), "Cannot close file "+str(filename));
     return positions;
 }
 
@@ -200,8 +196,7 @@ std::vector<vec3> obj_read_normals(const std::string& filename)
     assert_file_exist(filename);
     std::vector<vec3> normals;
 
-    std::ifstream stream(filename);
-    assert_vcl(stream.is_open(), "Cannot open file "+str(filename));
+    std::istringstream stream(read_file_text(filename)); // from the asset pack or the file system
     while(stream.good()) {
         std::string buffer;
         std::getline(stream,buffer);
@@ -219,8 +214,6 @@ std::vector<vec3> obj_read_normals(const std::string& filename)
             }
         }
     }
-    stream.close();
-    assert_vcl(!stream.is_open(), "Cannot close file "+str(filename));
     return normals;
 }
 
@@ -229,8 +222,7 @@ std::vector<vec2> obj_read_texture_uv(const std::string& filename)
     assert_file_exist(filename);
     std::vector<vec2> texture_uv;
 
-    std::ifstream stream(filename);
-    assert_vcl(stream.is_open(), "Cannot open file "+str(filename));
+    std::istringstream stream(read_file_text(filename)); // from the asset pack or the file system
     while(stream.good()) {
         std::string buffer;
         std::getline(stream,buffer);
@@ -248,8 +240,6 @@ std::vector<vec2> obj_read_texture_uv(const std::string& filename)
             }
         }
     }
-    stream.close();
-    assert_vcl(!stream.is_open(), "Cannot close file "+str(filename));
     return texture_uv;
 }
 
@@ -261,8 +251,7 @@ std::vector<uint3> obj_read_connectivity(const std::string& filename)
     std::vector<uint3> connectivity;
 
     // Open file
-    std::ifstream stream(filename);
-    assert_vcl(stream.is_open(), "Cannot open file "+str(filename));
+    std::istringstream stream(read_file_text(filename)); // from the asset pack or the file system
 
 
     while(stream.good())
@@ -295,8 +284,6 @@ std::vector<uint3> obj_read_connectivity(const std::string& filename)
 
 
 
-    stream.close();
-    assert_vcl(!stream.is_open(), "Cannot close file "+str(filename));
 
     return connectivity;
 }
@@ -328,8 +315,7 @@ buffer<buffer<int3>> obj_read_faces(const std::string& filename, obj_type const
     assert_file_exist(filename);
     buffer<buffer<int3>> faces;
 
-    std::ifstream stream(filename);
-    assert_vcl(stream.is_open(), "Cannot open file "+str(filename));
+    std::istringstream stream(read_file_text(filename)); // from the asset pack or the file system
     while(stream.good()) {
         std::string buffer;
         std::getline(stream,buffer);
@@ -357,8 +343,6 @@ buffer<buffer<int3>> obj_read_faces(const std::string& filename, obj_type const
             }
         }
     }
-    stream.close();
-    assert_vcl(!stream.is_open(), "Cannot close file "+str(filename));
 
     return faces;
 }
@@ -4,3 +4,4 @@
 #include "segment/segment.hpp"
 #include "curve/curve.hpp"
 #include "hierarchy_mesh/hierarchy_mesh.hpp"
+#include "skybox/skybox.hpp"
@@ -0,0 +1,57 @@
+#include "skybox.hpp"
+
+#include "vcl/opengl/opengl.hpp"
+#include "vcl/shape/mesh/mesh_gpu_registry/mesh_gpu_registry.hpp"
+
+namespace vcl
+{
+
+static mesh skybox_cube()
+{
+    mesh cube;
+    cube.position = {{-1,-1,-1}, {1,-1,-1}, {1,1,-1}, {-1,1,-1}, {-1,-1,1}, {1,-1,1}, {1,1,1}, {-1,1,1}};
+    cube.connectivity = {{0,1,2}, {0,2,3}, {4,6,5}, {4,7,6},
+                         {0,5,1}, {0,4,5}, {1,6,2}, {1,5,6},
+                         {2,7,3}, {2,6,7}, {3,4,0}, {3,7,4}};
+    return cube;
+}
+
+skybox::skybox()
+    :cube(), shader(0), texture_id(0), sampler(0)
+{}
+
+skybox::skybox(GLuint cubemap_id, GLuint shader_arg)
+    :cube(mesh_gpu_registry({"skybox_cube",{}}, skybox_cube)), shader(shader_arg), texture_id(cubemap_id), sampler(0)
+{}
+
+void skybox::clear()
+{
+    glDeleteTextures(1, &texture_id);
+    texture_id = 0;
+}
+
+void draw(const skybox& sky, const camera_scene& camera)
+{
+    draw(sky, camera, sky.shader);
+}
+
+void draw(const skybox& sky, const camera_scene& camera, GLuint shader)
+{
+    if(shader==0 || sky.texture_id==0)
+        return ;
+
+    GLint current_shader = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current_shader); opengl_debug();
+    if(shader!=GLuint(current_shader)) {
+        glUseProgram(shader); opengl_debug();
+    }
+
+    bind_texture(GL_TEXTURE_CUBE_MAP, sky.texture_id, sky.sampler); opengl_debug();
+
+    uniform(shader,"perspective",camera.perspective.matrix());         opengl_debug();
+    uniform(shader,"view",camera.view_matrix());                       opengl_debug();
+
+    vcl::draw(sky.cube); opengl_debug();
+}
+
+}
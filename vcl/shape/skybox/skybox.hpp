@@ -0,0 +1,28 @@
+#pragma once
+
+#include "vcl/shape/mesh/mesh_drawable/mesh_drawable_gpu_data/mesh_drawable_gpu_data.hpp"
+#include "vcl/interaction/camera/camera.hpp"
+
+namespace vcl
+{
+
+/** Background of the scene sampled from a GL_TEXTURE_CUBE_MAP in the viewing direction.
+ * The unit cube is centered on the camera and projected on the far plane (depth=1) by its shader:
+ * it is drawn after the opaque elements with a GL_LEQUAL depth test, such that only the uncovered pixels are shaded. */
+struct skybox
+{
+    skybox();
+    skybox(GLuint cubemap_id, GLuint shader = 0);
+
+    void clear();
+
+    mesh_drawable_gpu_data cube;
+    GLuint shader;
+    GLuint texture_id;
+    GLuint sampler; // see sampler_object, 0: parameters of the cubemap
+};
+
+void draw(const skybox& sky, const camera_scene& camera);
+void draw(const skybox& sky, const camera_scene& camera, GLuint shader);
+
+}
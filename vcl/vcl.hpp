@@ -21,6 +21,7 @@
 #include "opengl/opengl.hpp"
 #include "interaction/interaction.hpp"
 #include "shape/shape.hpp"
+#include "render/render.hpp"
 #include "wrapper/wrapper.hpp"
 #include "containers/containers.hpp"
 
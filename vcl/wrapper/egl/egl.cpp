@@ -0,0 +1,177 @@
+#include "egl.hpp"
+
+#include "vcl/wrapper/glad/glad.hpp"
+
+#include <iostream>
+
+#ifdef __linux__
+#include <dlfcn.h>
+#include <cstdint>
+#endif
+
+namespace vcl
+{
+
+#ifdef __linux__
+
+// Subset of the EGL 1.5 API, loaded from libEGL at run time (the EGL headers are not required)
+typedef void* egl_display;
+typedef void* egl_config;
+typedef void* egl_context;
+typedef void* egl_surface;
+typedef int32_t egl_int;
+typedef unsigned int egl_boolean;
+
+static const egl_int egl_none = 0x3038;
+static const egl_int egl_renderable_type = 0x3040;
+static const egl_int egl_opengl_bit = 0x0008;
+static const egl_int egl_width = 0x3057;
+static const egl_int egl_height = 0x3056;
+static const egl_int egl_context_major_version = 0x3098;
+static const egl_int egl_context_minor_version = 0x30FB;
+static const egl_int egl_context_opengl_profile_mask = 0x30FD;
+static const egl_int egl_context_opengl_core_profile_bit = 0x0001;
+static const unsigned int egl_opengl_api = 0x30A2;
+static const unsigned int egl_platform_surfaceless_mesa = 0x31DD;
+
+typedef void* (*egl_get_proc_address_function)(const char* name);
+typedef egl_display (*egl_get_display_function)(void* native_display);
+typedef egl_display (*egl_get_platform_display_function)(unsigned int platform, void* native_display, const egl_int* attributes);
+typedef egl_boolean (*egl_initialize_function)(egl_display display, egl_int* major, egl_int* minor);
+typedef egl_boolean (*egl_choose_config_function)(egl_display display, const egl_int* attributes, egl_config* configs, egl_int size, egl_int* number);
+typedef egl_boolean (*egl_bind_api_function)(unsigned int api);
+typedef egl_context (*egl_create_context_function)(egl_display display, egl_config config, egl_context share, const egl_int* attributes);
+typedef egl_surface (*egl_create_pbuffer_surface_function)(egl_display display, egl_config config, const egl_int* attributes);
+typedef egl_boolean (*egl_make_current_function)(egl_display display, egl_surface draw, egl_surface read, egl_context context);
+typedef egl_boolean (*egl_destroy_context_function)(egl_display display, egl_context context);
+typedef egl_boolean (*egl_destroy_surface_function)(egl_display display, egl_surface surface);
+typedef egl_boolean (*egl_terminate_function)(egl_display display);
+
+static void* library = nullptr;
+static egl_get_proc_address_function get_proc_address = nullptr;
+static egl_display display = nullptr;
+static egl_context context = nullptr;
+static egl_surface surface = nullptr;
+
+template <typename function_type>
+static function_type load_function(const char* name)
+{
+    return reinterpret_cast<function_type>(dlsym(library, name));
+}
+
+bool egl_headless_init(int opengl_version_major, int opengl_version_minor)
+{
+    library = dlopen("libEGL.so.1", RTLD_NOW | RTLD_LOCAL);
+    if(library==nullptr) {
+        std::cerr<<"Cannot load libEGL.so.1 for the headless rendering"<<std::endl;
+        return false;
+    }
+    get_proc_address = load_function<egl_get_proc_address_function>("eglGetProcAddress");
+    auto get_display = load_function<egl_get_display_function>("eglGetDisplay");
+    auto initialize = load_function<egl_initialize_function>("eglInitialize");
+    auto choose_config = load_function<egl_choose_config_function>("eglChooseConfig");
+    auto bind_api = load_function<egl_bind_api_function>("eglBindAPI");
+    auto create_context = load_function<egl_create_context_function>("eglCreateContext");
+    auto create_pbuffer_surface = load_function<egl_create_pbuffer_surface_function>("eglCreatePbufferSurface");
+    auto make_current = load_function<egl_make_current_function>("eglMakeCurrent");
+    if(!get_proc_address || !get_display || !initialize || !choose_config || !bind_api || !create_context || !create_pbuffer_surface || !make_current) {
+        std::cerr<<"Incomplete EGL library"<<std::endl;
+        return false;
+    }
+
+    // Surfaceless platform (Mesa): no display server is needed. Otherwise the default display.
+    auto get_platform_display = reinterpret_cast<egl_get_platform_display_function>(get_proc_address("eglGetPlatformDisplayEXT"));
+    if(get_platform_display!=nullptr)
+        display = get_platform_display(egl_platform_surfaceless_mesa, nullptr, nullptr);
+    if(display==nullptr)
+        display = get_display(nullptr);
+
+    egl_int major = 0, minor = 0;
+    if(display==nullptr || !initialize(display, &major, &minor)) {
+        std::cerr<<"Cannot initialize the EGL display"<<std::endl;
+        return false;
+    }
+
+    const egl_int config_attributes[] = {egl_renderable_type, egl_opengl_bit, egl_none};
+    egl_config config = nullptr;
+    egl_int number_configs = 0;
+    choose_config(display, config_attributes, &config, 1, &number_configs);
+    bind_api(egl_opengl_api);
+
+    const egl_int context_attributes[] = {
+        egl_context_major_version, opengl_version_major,
+        egl_context_minor_version, opengl_version_minor,
+        egl_context_opengl_profile_mask, egl_context_opengl_core_profile_bit,
+        egl_none};
+    context = create_context(display, number_configs>0 ? config : nullptr, nullptr, context_attributes);
+    if(context==nullptr) {
+        std::cerr<<"Cannot create an OpenGL "<<opengl_version_major<<"."<<opengl_version_minor<<" core context with EGL"<<std::endl;
+        return false;
+    }
+
+    // Without surfaceless context support, a small pbuffer is current (the rendering still targets a framebuffer object)
+    if(!make_current(display, nullptr, nullptr, context)) {
+        const egl_int pbuffer_attributes[] = {egl_width, 1, egl_height, 1, egl_none};
+        surface = create_pbuffer_surface(display, config, pbuffer_attributes);
+        if(surface==nullptr || !make_current(display, surface, surface, context)) {
+            std::cerr<<"Cannot make the EGL context current"<<std::endl;
+            return false;
+        }
+    }
+
+    if(gladLoadGLLoader(egl_get_proc_address)==0) {
+        std::cerr<<"Failed to Init GLAD"<<std::endl;
+        return false;
+    }
+    return true;
+}
+
+void* egl_get_proc_address(const char* name)
+{
+    // Core functions may only be exported by libEGL/libGL and not returned by eglGetProcAddress
+    void* function = get_proc_address!=nullptr ? get_proc_address(name) : nullptr;
+    if(function==nullptr && library!=nullptr)
+        function = dlsym(RTLD_DEFAULT, name);
+    return function;
+}
+
+void egl_headless_cleanup()
+{
+    if(library==nullptr)
+        return;
+    auto make_current = load_function<egl_make_current_function>("eglMakeCurrent");
+    auto destroy_context = load_function<egl_destroy_context_function>("eglDestroyContext");
+    auto destroy_surface = load_function<egl_destroy_surface_function>("eglDestroySurface");
+    auto terminate = load_function<egl_terminate_function>("eglTerminate");
+    if(display!=nullptr) {
+        make_current(display, nullptr, nullptr, nullptr);
+        if(context!=nullptr)
+            destroy_context(display, context);
+        if(surface!=nullptr)
+            destroy_surface(display, surface);
+        terminate(display);
+    }
+    display = context = surface = nullptr;
+    dlclose(library);
+    library = nullptr;
+}
+
+#else
+
+bool egl_headless_init(int, int)
+{
+    std::cerr<<"Headless rendering (EGL) is only available on Linux"<<std::endl;
+    return false;
+}
+
+void* egl_get_proc_address(const char*)
+{
+    return nullptr;
+}
+
+void egl_headless_cleanup()
+{}
+
+#endif
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+namespace vcl
+{
+
+/** Headless OpenGL context without window nor display server (EGL surfaceless, ex. Mesa llvmpipe on a build agent).
+ * libEGL is loaded at run time: the program does not depend on it when the headless mode is not used.
+ * There is no default framebuffer: the rendering must target a framebuffer object (see offscreen_framebuffer).
+ * Only available on Linux, egl_headless_init returns false otherwise. */
+
+/** Create an OpenGL core context of the given version and make it current, then load the OpenGL functions (GLAD). Return false on failure. */
+bool egl_headless_init(int opengl_version_major, int opengl_version_minor);
+
+/** Loader of the OpenGL functions of the headless context (to be used instead of glfwGetProcAddress) */
+void* egl_get_proc_address(const char* name);
+
+void egl_headless_cleanup();
+
+}
@@ -4,6 +4,9 @@
 namespace vcl
 {
 
+// Without window, the GUI is built at each frame (the scene code is unchanged) but neither receives inputs nor is displayed
+static bool headless = false;
+
 void imgui_init(GLFWwindow* window)
 {
     IMGUI_CHECKVERSION();
@@ -14,16 +17,35 @@ void imgui_init(GLFWwindow* window)
     ImGui::StyleColorsClassic();
 }
 
+void imgui_init_headless(int width, int height)
+{
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    headless = true;
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2(float(width), float(height));
+    io.DeltaTime = 1.0f/60.0f;
+    unsigned char* pixels = nullptr;
+    int atlas_width = 0, atlas_height = 0;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &atlas_width, &atlas_height); // builds the font atlas, never sent to the GPU
+    ImGui::StyleColorsClassic();
+}
+
 void imgui_create_frame()
 {
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
+    if(!headless) {
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+    }
     ImGui::NewFrame();
 }
 
 void imgui_render_frame(GLFWwindow* window)
 {
     ImGui::Render();
+    if(headless)
+        return;
     int display_w, display_h;
     glfwGetFramebufferSize(window, &display_w, &display_h);
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -31,9 +53,12 @@ void imgui_render_frame(GLFWwindow* window)
 
 void imgui_cleanup()
 {
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
+    if(!headless) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+    }
     ImGui::DestroyContext();
+    headless = false;
 }
 
 }
@@ -11,6 +11,8 @@ namespace vcl
 {
 
 void imgui_init(GLFWwindow* window);
+/** GUI without window (see egl_headless_init): the frames are built but not displayed */
+void imgui_init_headless(int width, int height);
 
 void imgui_create_frame();
 void imgui_render_frame(GLFWwindow* window);
@@ -1,10 +1,108 @@
 #include "lodepng.hpp"
 
+#include "vcl/base/file_mapping/file_mapping.hpp"
+
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 namespace vcl
 {
 
+static inline unsigned char paeth(int a, int b, int c)
+{
+    const int p = a+b-c;
+    const int pa = std::abs(p-a), pb = std::abs(p-b), pc = std::abs(p-c);
+    return static_cast<unsigned char>((pa<=pb && pa<=pc) ? a : (pb<=pc ? b : c));
+}
+
+// Reverse the filter of a scanline of length bytes (PNG specification), previous being the unfiltered row above (zeros for the first one)
+static bool unfilter_row(unsigned char* row, const unsigned char* filtered, const unsigned char* previous, unsigned char filter, size_t length, size_t bpp)
+{
+    size_t i = 0;
+    switch(filter) {
+    case 0:
+        std::memcpy(row, filtered, length);
+        return true;
+    case 1:
+        for(; i<bpp; ++i) row[i] = filtered[i];
+        for(; i<length; ++i) row[i] = static_cast<unsigned char>(filtered[i]+row[i-bpp]);
+        return true;
+    case 2:
+        for(; i<length; ++i) row[i] = static_cast<unsigned char>(filtered[i]+previous[i]);
+        return true;
+    case 3:
+        for(; i<bpp; ++i) row[i] = static_cast<unsigned char>(filtered[i]+(previous[i]>>1));
+        for(; i<length; ++i) row[i] = static_cast<unsigned char>(filtered[i]+((row[i-bpp]+previous[i])>>1));
+        return true;
+    case 4:
+        for(; i<bpp; ++i) row[i] = static_cast<unsigned char>(filtered[i]+previous[i]);
+        for(; i<length; ++i) row[i] = static_cast<unsigned char>(filtered[i]+paeth(row[i-bpp], previous[i], previous[i-bpp]));
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Usual case of the assets: non interlaced 8-bit rgb or rgba png, without color key. The rows are inflated by lodepng,
+//  and unfiltered straight into the image (expanded to rgba on the way if needed). Return false for the other files.
+static bool image_decode_plain(const unsigned char* png, size_t size, image_color_type color_type, image_raw& im)
+{
+    unsigned width = 0, height = 0;
+    lodepng::State state;
+    if(lodepng_inspect(&width, &height, &state, png, size)!=0)
+        return false;
+    const LodePNGColorMode& color = state.info_png.color;
+    const bool rgba = color.colortype==LCT_RGBA;
+    if(state.info_png.interlace_method!=0 || color.bitdepth!=8 || (color.colortype!=LCT_RGB && !rgba) || (rgba && color_type==image_color_type::rgb))
+        return false;
+
+    // Compressed rows: content of the IDAT chunks, one after the other
+    std::vector<unsigned char> compressed;
+    const unsigned char* const end = png+size;
+    const unsigned char* chunk = png+33; // signature and IHDR
+    while(true) {
+        if(end-chunk<12 || lodepng_chunk_length(chunk)>size_t(end-chunk)-12)
+            return false;
+        if(!state.decoder.ignore_crc && lodepng_chunk_check_crc(chunk))
+            return false;
+        if(lodepng_chunk_type_equals(chunk, "IEND"))
+            break;
+        if(lodepng_chunk_type_equals(chunk, "tRNS"))
+            return false;
+        if(lodepng_chunk_type_equals(chunk, "IDAT")) {
+            const unsigned char* const data = lodepng_chunk_data_const(chunk);
+            compressed.insert(compressed.end(), data, data+lodepng_chunk_length(chunk));
+        }
+        chunk = lodepng_chunk_next_const(chunk);
+    }
+
+    unsigned char* scanlines = nullptr;
+    size_t scanlines_size = 0;
+    const size_t bpp = rgba ? 4 : 3;
+    const size_t length = size_t(width)*bpp;
+    bool valid = !compressed.empty() && lodepng_zlib_decompress(&scanlines, &scanlines_size, &compressed[0], compressed.size(), &state.decoder.zlibsettings)==0
+                 && scanlines_size==(length+1)*height;
+    if(valid) {
+        const bool expand = !rgba && color_type==image_color_type::rgba;
+        const size_t pixel_size = color_type==image_color_type::rgba ? 4 : 3;
+        im = image_raw(width, height, color_type, std::vector<unsigned char>(size_t(width)*height*pixel_size));
+
+        // The previous row is the one of the image, or one of the two rows being expanded
+        std::vector<unsigned char> rows(expand ? 2*length : 0), zeros(length, 0);
+        const unsigned char* previous = zeros.empty() ? nullptr : &zeros[0];
+        for(size_t y=0; valid && y<height; ++y) {
+            const unsigned char* const filtered = scanlines+y*(length+1);
+            unsigned char* const row = expand ? &rows[(y%2)*length] : &im.data[y*length];
+            valid = unfilter_row(row, filtered+1, previous, filtered[0], length, bpp);
+            if(expand)
+                image_rgb_to_rgba(row, &im.data[y*size_t(width)*4], width);
+            previous = row;
+        }
+    }
+    std::free(scanlines);
+    return valid;
+}
 
 image_raw image_load_png(const std::string& filename, image_color_type color_type)
 {
@@ -21,10 +119,46 @@ image_raw image_load_png(const std::string& filename, image_color_type color_typ
         exit(1);
     }
 
-    image_raw im;
-    im.color_type = color_type;
+    // The file is mapped (or is a view of the asset pack). Plain rgb/rgba files are unfiltered directly into the image,
+    //  the others are decoded by lodepng in their own color type and converted once into the image
+    file_mapping file;
+    unsigned error = file.open(filename) ? 0 : 78;
+    if( !error ) {
+        image_raw plain;
+        if( image_decode_plain(file.data(), file.size(), color_type, plain) )
+            return plain;
+    }
+    lodepng::State state;
+    state.decoder.color_convert = 0;
+    unsigned char* decoded = nullptr;
+    unsigned width = 0, height = 0;
+    if( !error )
+        error = lodepng_decode(&decoded, &width, &height, &state, file.data(), file.size());
+    file.close();
+
+    LodePNGColorMode mode;
+    lodepng_color_mode_init(&mode);
+    mode.colortype = lodepng_color_type;
+    mode.bitdepth = 8;
+
+    image_raw im(width, height, color_type, std::vector<unsigned char>());
+    if( !error ) {
+        const size_t pixels = size_t(width)*size_t(height);
+        const LodePNGColorMode& source = state.info_png.color;
+        const bool plain = source.bitdepth==8 && !source.key_defined;
+        im.data.resize(pixels*(color_type==image_color_type::rgb ? 3 : 4));
+        if( pixels>0 ) {
+            if( plain && source.colortype==lodepng_color_type )
+                std::memcpy(&im.data[0], decoded, im.data.size());
+            else if( plain && source.colortype==LCT_RGB && color_type==image_color_type::rgba )
+                image_rgb_to_rgba(decoded, &im.data[0], pixels);
+            else
+                error = lodepng_convert(&im.data[0], decoded, &mode, &source, width, height);
+        }
+    }
+    std::free(decoded);
+    lodepng_color_mode_cleanup(&mode);
 
-    unsigned error = lodepng::decode(im.data, im.width, im.height, filename, lodepng_color_type);
     if ( error )
     {
         std::cerr<<"Error Loading png file "<<filename<<std::endl;
@@ -1,5 +1,19 @@
 #include "perlin.hpp"
 
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define VCL_PERLIN_SSE2
+#endif
+
+// AVX2 path compiled whatever the build flags (function attributes), and selected at run time
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define VCL_PERLIN_AVX2
+#endif
+
 namespace  vcl {
 
 float perlin(float x, int octave, float persistency, float frequency_gain)
@@ -46,4 +60,307 @@ float perlin(float x, float y, float z, int octave, float persistency, float fre
     return value;
 }
 
+// Gradients of snoise3 indexed by the low 4 bits of the hash: the dot product is ((h&1)? -u : u) + ((h&2)? -v : v)
+struct simplex_gradients
+{
+    float x[16], y[16], z[16];
+    simplex_gradients()
+    {
+        for(int h=0; h<16; ++h) {
+            float g[3] = {0,0,0};
+            const int u = h<8 ? 0 : 1;
+            const int v = h<4 ? 1 : (h==12 || h==14) ? 0 : 2;
+            g[u] += (h&1) ? -1.0f : 1.0f;
+            g[v] += (h&2) ? -1.0f : 1.0f;
+            x[h] = g[0]; y[h] = g[1]; z[h] = g[2];
+        }
+    }
+};
+static const simplex_gradients gradients;
+
+// Permutation of snoise3 (third_party/simplexnoise), duplicated on 512 entries and widened to 32 bits to be gathered
+static const unsigned char permutation[256] = {
+    151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,
+    140,36,103,30,69,142,8,99,37,240,21,10,23,190,6,148,
+    247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,
+    57,177,33,88,237,149,56,87,174,20,125,136,171,168,68,175,
+    74,165,71,134,139,48,27,166,77,146,158,231,83,111,229,122,
+    60,211,133,230,220,105,92,41,55,46,245,40,244,102,143,54,
+    65,25,63,161,1,216,80,73,209,76,132,187,208,89,18,169,
+    200,196,135,130,116,188,159,86,164,100,109,198,173,186,3,64,
+    52,217,226,250,124,123,5,202,38,147,118,126,255,82,85,212,
+    207,206,59,227,47,16,58,17,182,189,28,42,223,183,170,213,
+    119,248,152,2,44,154,163,70,221,153,101,155,167,43,172,9,
+    129,22,39,253,19,98,108,110,79,113,224,232,178,185,112,104,
+    218,246,97,228,251,34,242,193,238,210,144,12,191,179,162,241,
+    81,51,145,235,249,14,239,107,49,192,214,31,181,199,106,157,
+    184,84,204,176,115,121,50,45,127,4,150,254,138,236,205,93,
+    222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
+};
+struct simplex_permutation
+{
+    alignas(32) int p[512];
+    simplex_permutation()
+    {
+        for(int k=0; k<512; ++k)
+            p[k] = permutation[k&255];
+    }
+};
+static const simplex_permutation perm_table;
+
+static const float F3 = 1.0f/3.0f;
+static const float G3 = 1.0f/6.0f;
+
+static inline int simplex_hash(int i, int j, int k)
+{
+    const int* const perm = perm_table.p;
+    return perm[i+perm[j+perm[k]]] & 15;
+}
+
+static inline float simplex_corner(float x, float y, float z, int h)
+{
+    float t = 0.6f - x*x - y*y - z*z;
+    if(t<0.0f)
+        return 0.0f;
+    t *= t;
+    return t*t*(gradients.x[h]*x + gradients.y[h]*y + gradients.z[h]*z);
+}
+
+// Scalar version (remaining points, or without SSE2)
+static float simplex3(float x, float y, float z)
+{
+    const float s = (x+y+z)*F3;
+    const float fi = std::floor(x+s), fj = std::floor(y+s), fk = std::floor(z+s);
+    const float t = (fi+fj+fk)*G3;
+    const float x0 = x-(fi-t), y0 = y-(fj-t), z0 = z-(fk-t);
+
+    // Offsets of the second and third corners (same order as snoise3, written as comparisons)
+    const bool a = x0>=y0, b = y0>=z0, c = x0>=z0;
+    const int i1 = a && c, j1 = !a && b, k1 = !b && !(a && c);
+    const int i2 = a || (b && c), j2 = !a || b, k2 = !b || (!a && !c);
+
+    const int ii = int(fi) & 255, jj = int(fj) & 255, kk = int(fk) & 255;
+    const float n0 = simplex_corner(x0, y0, z0, simplex_hash(ii, jj, kk));
+    const float n1 = simplex_corner(x0-i1+G3, y0-j1+G3, z0-k1+G3, simplex_hash(ii+i1, jj+j1, kk+k1));
+    const float n2 = simplex_corner(x0-i2+2*G3, y0-j2+2*G3, z0-k2+2*G3, simplex_hash(ii+i2, jj+j2, kk+k2));
+    const float n3 = simplex_corner(x0-1+3*G3, y0-1+3*G3, z0-1+3*G3, simplex_hash(ii+1, jj+1, kk+1));
+    return 32.0f*(n0+n1+n2+n3);
+}
+
+#ifdef VCL_PERLIN_SSE2
+
+static inline __m128 floor4(__m128 v)
+{
+    const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, v), _mm_set1_ps(1.0f)));
+}
+
+// Contribution of one corner for 4 points: gradient selected from the hashes h as in snoise3 (see simplex_gradients)
+static inline __m128 simplex_corner4(__m128 x, __m128 y, __m128 z, __m128i h)
+{
+    __m128 t = _mm_sub_ps(_mm_set1_ps(0.6f), _mm_add_ps(_mm_add_ps(_mm_mul_ps(x,x), _mm_mul_ps(y,y)), _mm_mul_ps(z,z)));
+    t = _mm_max_ps(t, _mm_setzero_ps());
+    t = _mm_mul_ps(t, t);
+    t = _mm_mul_ps(t, t);
+
+    const __m128 h_lt8 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(8)));
+    const __m128 h_lt4 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(4)));
+    const __m128 h_12_14 = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_or_si128(h, _mm_set1_epi32(2)), _mm_set1_epi32(14)));
+    const __m128 u = _mm_or_ps(_mm_and_ps(h_lt8, x), _mm_andnot_ps(h_lt8, y));
+    const __m128 v = _mm_or_ps(_mm_and_ps(h_lt4, y), _mm_andnot_ps(h_lt4, _mm_or_ps(_mm_and_ps(h_12_14, x), _mm_andnot_ps(h_12_14, z))));
+    // Signs: bit 0 of h for u, bit 1 for v, moved to the sign bit
+    const __m128 sign_u = _mm_castsi128_ps(_mm_slli_epi32(h, 31));
+    const __m128 sign_v = _mm_castsi128_ps(_mm_slli_epi32(_mm_srli_epi32(h, 1), 31));
+    return _mm_mul_ps(t, _mm_add_ps(_mm_xor_ps(u, sign_u), _mm_xor_ps(v, sign_v)));
+}
+
+static __m128 simplex3_4(__m128 x, __m128 y, __m128 z)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 g3 = _mm_set1_ps(G3);
+
+    const __m128 s = _mm_mul_ps(_mm_add_ps(_mm_add_ps(x,y),z), _mm_set1_ps(F3));
+    const __m128 fi = floor4(_mm_add_ps(x,s)), fj = floor4(_mm_add_ps(y,s)), fk = floor4(_mm_add_ps(z,s));
+    const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(fi,fj),fk), g3);
+    const __m128 x0 = _mm_sub_ps(x, _mm_sub_ps(fi,t));
+    const __m128 y0 = _mm_sub_ps(y, _mm_sub_ps(fj,t));
+    const __m128 z0 = _mm_sub_ps(z, _mm_sub_ps(fk,t));
+
+    // Corner offsets as 0/1 masks (see simplex3)
+    const __m128 a = _mm_cmpge_ps(x0,y0), b = _mm_cmpge_ps(y0,z0), c = _mm_cmpge_ps(x0,z0);
+    const __m128 ac = _mm_and_ps(a,c);
+    const __m128 i1 = _mm_and_ps(ac, one);
+    const __m128 j1 = _mm_and_ps(_mm_andnot_ps(a,b), one);
+    const __m128 k1 = _mm_andnot_ps(_mm_or_ps(b,ac), one);
+    const __m128 i2 = _mm_and_ps(_mm_or_ps(a, _mm_and_ps(b,c)), one);
+    const __m128 j2 = _mm_andnot_ps(_mm_andnot_ps(b,a), one);
+    const __m128 k2 = _mm_andnot_ps(_mm_and_ps(b, _mm_or_ps(a,c)), one);
+
+    // Hashes: table lookups per lane
+    alignas(16) int ii[4], jj[4], kk[4], oi1[4], oj1[4], ok1[4], oi2[4], oj2[4], ok2[4];
+    const __m128i mask = _mm_set1_epi32(255);
+    _mm_store_si128(reinterpret_cast<__m128i*>(ii), _mm_and_si128(_mm_cvttps_epi32(fi), mask));
+    _mm_store_si128(reinterpret_cast<__m128i*>(jj), _mm_and_si128(_mm_cvttps_epi32(fj), mask));
+    _mm_store_si128(reinterpret_cast<__m128i*>(kk), _mm_and_si128(_mm_cvttps_epi32(fk), mask));
+    _mm_store_si128(reinterpret_cast<__m128i*>(oi1), _mm_cvttps_epi32(i1));
+    _mm_store_si128(reinterpret_cast<__m128i*>(oj1), _mm_cvttps_epi32(j1));
+    _mm_store_si128(reinterpret_cast<__m128i*>(ok1), _mm_cvttps_epi32(k1));
+    _mm_store_si128(reinterpret_cast<__m128i*>(oi2), _mm_cvttps_epi32(i2));
+    _mm_store_si128(reinterpret_cast<__m128i*>(oj2), _mm_cvttps_epi32(j2));
+    _mm_store_si128(reinterpret_cast<__m128i*>(ok2), _mm_cvttps_epi32(k2));
+
+    alignas(16) int h0[4], h1[4], h2[4], h3[4];
+    for(int l=0; l<4; ++l) {
+        const int i = ii[l], j = jj[l], k = kk[l];
+        h0[l] = simplex_hash(i, j, k);
+        h1[l] = simplex_hash(i+oi1[l], j+oj1[l], k+ok1[l]);
+        h2[l] = simplex_hash(i+oi2[l], j+oj2[l], k+ok2[l]);
+        h3[l] = simplex_hash(i+1, j+1, k+1);
+    }
+
+    const __m128 g3_2 = _mm_set1_ps(2*G3);
+    const __m128 g3_3 = _mm_set1_ps(3*G3-1);
+    const __m128i* const h = reinterpret_cast<const __m128i*>(h0);
+    __m128 n = simplex_corner4(x0, y0, z0, _mm_load_si128(h));
+    n = _mm_add_ps(n, simplex_corner4(_mm_add_ps(_mm_sub_ps(x0,i1),g3), _mm_add_ps(_mm_sub_ps(y0,j1),g3), _mm_add_ps(_mm_sub_ps(z0,k1),g3), _mm_load_si128(reinterpret_cast<const __m128i*>(h1))));
+    n = _mm_add_ps(n, simplex_corner4(_mm_add_ps(_mm_sub_ps(x0,i2),g3_2), _mm_add_ps(_mm_sub_ps(y0,j2),g3_2), _mm_add_ps(_mm_sub_ps(z0,k2),g3_2), _mm_load_si128(reinterpret_cast<const __m128i*>(h2))));
+    n = _mm_add_ps(n, simplex_corner4(_mm_add_ps(x0,g3_3), _mm_add_ps(y0,g3_3), _mm_add_ps(z0,g3_3), _mm_load_si128(reinterpret_cast<const __m128i*>(h3))));
+    return _mm_mul_ps(n, _mm_set1_ps(32.0f));
+}
+
+#endif
+
+#ifdef VCL_PERLIN_AVX2
+
+#define VCL_PERLIN_TARGET_AVX2 __attribute__((target("avx2")))
+
+// Same computation as simplex_corner4 on 8 points
+VCL_PERLIN_TARGET_AVX2 static inline __m256 simplex_corner8(__m256 x, __m256 y, __m256 z, __m256i h)
+{
+    __m256 t = _mm256_sub_ps(_mm256_set1_ps(0.6f), _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x,x), _mm256_mul_ps(y,y)), _mm256_mul_ps(z,z)));
+    t = _mm256_max_ps(t, _mm256_setzero_ps());
+    t = _mm256_mul_ps(t, t);
+    t = _mm256_mul_ps(t, t);
+
+    const __m256 h_lt8 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h));
+    const __m256 h_lt4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h));
+    const __m256 h_12_14 = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_or_si256(h, _mm256_set1_epi32(2)), _mm256_set1_epi32(14)));
+    const __m256 u = _mm256_blendv_ps(y, x, h_lt8);
+    const __m256 v = _mm256_blendv_ps(_mm256_blendv_ps(z, x, h_12_14), y, h_lt4);
+    const __m256 sign_u = _mm256_castsi256_ps(_mm256_slli_epi32(h, 31));
+    const __m256 sign_v = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(h, 1), 31));
+    return _mm256_mul_ps(t, _mm256_add_ps(_mm256_xor_ps(u, sign_u), _mm256_xor_ps(v, sign_v)));
+}
+
+// simplex_hash of 8 lattice points: the three lookups are gathers in the 2 KB permutation table (kept in the L1 cache)
+VCL_PERLIN_TARGET_AVX2 static inline __m256i simplex_hash8(__m256i i, __m256i j, __m256i k)
+{
+    const int* const perm = perm_table.p;
+    const __m256i pk = _mm256_i32gather_epi32(perm, k, 4);
+    const __m256i pj = _mm256_i32gather_epi32(perm, _mm256_add_epi32(j, pk), 4);
+    return _mm256_and_si256(_mm256_i32gather_epi32(perm, _mm256_add_epi32(i, pj), 4), _mm256_set1_epi32(15));
+}
+
+VCL_PERLIN_TARGET_AVX2 static __m256 simplex3_8(__m256 x, __m256 y, __m256 z)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 g3 = _mm256_set1_ps(G3);
+
+    const __m256 s = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(x,y),z), _mm256_set1_ps(F3));
+    const __m256 fi = _mm256_floor_ps(_mm256_add_ps(x,s)), fj = _mm256_floor_ps(_mm256_add_ps(y,s)), fk = _mm256_floor_ps(_mm256_add_ps(z,s));
+    const __m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(fi,fj),fk), g3);
+    const __m256 x0 = _mm256_sub_ps(x, _mm256_sub_ps(fi,t));
+    const __m256 y0 = _mm256_sub_ps(y, _mm256_sub_ps(fj,t));
+    const __m256 z0 = _mm256_sub_ps(z, _mm256_sub_ps(fk,t));
+
+    // Corner offsets as 0/1 (see simplex3)
+    const __m256 a = _mm256_cmp_ps(x0,y0,_CMP_GE_OQ), b = _mm256_cmp_ps(y0,z0,_CMP_GE_OQ), c = _mm256_cmp_ps(x0,z0,_CMP_GE_OQ);
+    const __m256 ac = _mm256_and_ps(a,c);
+    const __m256 i1 = _mm256_and_ps(ac, one);
+    const __m256 j1 = _mm256_and_ps(_mm256_andnot_ps(a,b), one);
+    const __m256 k1 = _mm256_andnot_ps(_mm256_or_ps(b,ac), one);
+    const __m256 i2 = _mm256_and_ps(_mm256_or_ps(a, _mm256_and_ps(b,c)), one);
+    const __m256 j2 = _mm256_andnot_ps(_mm256_andnot_ps(b,a), one);
+    const __m256 k2 = _mm256_andnot_ps(_mm256_and_ps(b, _mm256_or_ps(a,c)), one);
+
+    const __m256i mask = _mm256_set1_epi32(255);
+    const __m256i unit = _mm256_set1_epi32(1);
+    const __m256i ii = _mm256_and_si256(_mm256_cvttps_epi32(fi), mask);
+    const __m256i jj = _mm256_and_si256(_mm256_cvttps_epi32(fj), mask);
+    const __m256i kk = _mm256_and_si256(_mm256_cvttps_epi32(fk), mask);
+    const __m256i h0 = simplex_hash8(ii, jj, kk);
+    const __m256i h1 = simplex_hash8(_mm256_add_epi32(ii, _mm256_cvttps_epi32(i1)), _mm256_add_epi32(jj, _mm256_cvttps_epi32(j1)), _mm256_add_epi32(kk, _mm256_cvttps_epi32(k1)));
+    const __m256i h2 = simplex_hash8(_mm256_add_epi32(ii, _mm256_cvttps_epi32(i2)), _mm256_add_epi32(jj, _mm256_cvttps_epi32(j2)), _mm256_add_epi32(kk, _mm256_cvttps_epi32(k2)));
+    const __m256i h3 = simplex_hash8(_mm256_add_epi32(ii, unit), _mm256_add_epi32(jj, unit), _mm256_add_epi32(kk, unit));
+
+    const __m256 g3_2 = _mm256_set1_ps(2*G3);
+    const __m256 g3_3 = _mm256_set1_ps(3*G3-1);
+    __m256 n = simplex_corner8(x0, y0, z0, h0);
+    n = _mm256_add_ps(n, simplex_corner8(_mm256_add_ps(_mm256_sub_ps(x0,i1),g3), _mm256_add_ps(_mm256_sub_ps(y0,j1),g3), _mm256_add_ps(_mm256_sub_ps(z0,k1),g3), h1));
+    n = _mm256_add_ps(n, simplex_corner8(_mm256_add_ps(_mm256_sub_ps(x0,i2),g3_2), _mm256_add_ps(_mm256_sub_ps(y0,j2),g3_2), _mm256_add_ps(_mm256_sub_ps(z0,k2),g3_2), h2));
+    n = _mm256_add_ps(n, simplex_corner8(_mm256_add_ps(x0,g3_3), _mm256_add_ps(y0,g3_3), _mm256_add_ps(z0,g3_3), h3));
+    return _mm256_mul_ps(n, _mm256_set1_ps(32.0f));
+}
+
+// Noise of the first points with AVX2, returns their number (multiple of 8)
+VCL_PERLIN_TARGET_AVX2 static size_t snoise3_batch_avx2(const float* x, const float* y, const float* z, float* noise, size_t n)
+{
+    size_t k = 0;
+    for(; k+8<=n; k+=8)
+        _mm256_storeu_ps(noise+k, simplex3_8(_mm256_loadu_ps(x+k), _mm256_loadu_ps(y+k), _mm256_loadu_ps(z+k)));
+    return k;
+}
+
+static bool has_avx2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+#endif
+
+void snoise3_batch(const float* x, const float* y, const float* z, float* noise, size_t n)
+{
+    size_t k = 0;
+#ifdef VCL_PERLIN_AVX2
+    if(has_avx2())
+        k = snoise3_batch_avx2(x, y, z, noise, n);
+#endif
+#ifdef VCL_PERLIN_SSE2
+    for(; k+4<=n; k+=4)
+        _mm_storeu_ps(noise+k, simplex3_4(_mm_loadu_ps(x+k), _mm_loadu_ps(y+k), _mm_loadu_ps(z+k)));
+#endif
+    for(; k<n; ++k)
+        noise[k] = simplex3(x[k], y[k], z[k]);
+}
+
+void perlin_batch(const float* x, const float* y, const float* z, float* value, size_t n, int octave, float persistency, float frequency_gain)
+{
+    // By chunks: the scaled coordinates stay in the cache across the octaves
+    const size_t chunk = 256;
+    float xf[chunk], yf[chunk], zf[chunk], noise[chunk];
+    for(size_t start=0; start<n; start+=chunk)
+    {
+        const size_t m = std::min(chunk, n-start);
+        for(size_t k=0; k<m; ++k)
+            value[start+k] = 0.0f;
+
+        float a = 1.0f; // current magnitude
+        float f = 1.0f; // current frequency
+        for(int o=0; o<octave; ++o)
+        {
+            for(size_t k=0; k<m; ++k) {
+                xf[k] = x[start+k]*f;
+                yf[k] = y[start+k]*f;
+                zf[k] = z[start+k]*f;
+            }
+            snoise3_batch(xf, yf, zf, noise, m);
+            for(size_t k=0; k<m; ++k)
+                value[start+k] += a*(0.5f+0.5f*noise[k]);
+            f *= frequency_gain;
+            a *= persistency;
+        }
+    }
+}
+
 }
@@ -2,10 +2,20 @@
 
 #include "third_party/simplexnoise/simplexnoise1234.hpp"
 
+#include <cstddef>
+
 namespace  vcl {
 
 float perlin(float x, int octave=5, float persistency=0.3f, float frequency_gain=2.0f);
 float perlin(float x, float y, int octave=5, float persistency=0.3f, float frequency_gain=2.0f);
 float perlin(float x, float y, float z, int octave=5, float persistency=0.3f, float frequency_gain=2.0f);
 
+/** 3D simplex noise of n points (x[k],y[k],z[k]), in single precision: eight points at a time with AVX2 (selected at run time),
+ * four with SSE2 otherwise, the same values in both cases.
+ * Same noise as snoise3, except that the lattice wraps every 256 cells for negative coordinates as well. */
+void snoise3_batch(const float* x, const float* y, const float* z, float* noise, size_t n);
+
+/** value[k] = perlin(x[k],y[k],z[k], octave, persistency, frequency_gain) for n points, using snoise3_batch */
+void perlin_batch(const float* x, const float* y, const float* z, float* value, size_t n, int octave=5, float persistency=0.3f, float frequency_gain=2.0f);
+
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "glfw/glfw.hpp"
+#include "egl/egl.hpp"
 #include "imgui/imgui.hpp"
 #include "lodepng/lodepng.hpp"
 #include "perlin/perlin.hpp"